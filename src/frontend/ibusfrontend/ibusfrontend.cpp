@@ -15,6 +15,7 @@
 #include <mutex>
 #include <fmt/format.h>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/dbus/calltask.h"
 #include "fcitx-utils/dbus/message.h"
 #include "fcitx-utils/dbus/objectvtable.h"
 #include "fcitx-utils/dbus/servicewatcher.h"
@@ -786,8 +787,12 @@ void IBusFrontendModule::replaceIBus(bool recheck) {
                         IBUS_SERVICE, "/org/freedesktop/IBus",
                         IBUS_INPUTMETHOD_DBUS_INTERFACE, "Exit");
                     call << false;
-                    call.call(1000000);
-                    deferCheck = true;
+                    // The result is checked by the timer below, no need to
+                    // wait for the reply.
+                    if (call.send()) {
+                        bus.flush();
+                        deferCheck = true;
+                    }
                 }
             } catch (...) {
             }
@@ -929,28 +934,43 @@ void IBusFrontendModule::becomeIBus(bool recheck) {
 }
 
 void IBusFrontendModule::ensureIsIBus() {
-    if (!isInFlatpak()) {
-        auto myname = bus()->uniqueName();
-        if (!myname.empty() &&
-            myname != bus()->serviceOwner(IBUS_SERVICE, 1000000)) {
-            auto msg = bus()->createMethodCall(
-                "org.freedesktop.DBus", "/org/freedesktop/DBus",
-                "org.freedesktop.DBus", "GetConnectionUnixProcessID");
-            msg << IBUS_SERVICE;
-            auto reply = msg.call(1000000);
-
-            uint32_t pid = 0;
-            if (reply.type() == dbus::MessageType::Reply) {
-                reply >> pid;
-            }
-            if (pid > 0 && static_cast<pid_t>(pid) != getpid()) {
-                if (kill(pid, SIGKILL) != 0) {
-                    return;
-                }
-            }
-        }
+    auto myname = bus()->uniqueName();
+    if (isInFlatpak() || myname.empty()) {
+        checkAddressFiles();
+        return;
     }
+    // Don't block the main loop on the bus daemon, the check is periodic
+    // anyway.
+    ensureIsIBusTask_ =
+        dbus::serviceOwnerTask(*bus(), IBUS_SERVICE, 1000000)
+            .then([this, myname](const std::string &owner) {
+                if (owner == myname) {
+                    return Task<uint32_t>::ready(0);
+                }
+                auto msg = bus()->createMethodCall(
+                    "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                    "org.freedesktop.DBus", "GetConnectionUnixProcessID");
+                msg << IBUS_SERVICE;
+                return dbus::callTask(msg, 1000000)
+                    .then([](dbus::Message reply) {
+                        uint32_t pid = 0;
+                        if (reply.type() == dbus::MessageType::Reply) {
+                            reply >> pid;
+                        }
+                        return pid;
+                    });
+            })
+            .then([this](uint32_t pid) {
+                if (pid > 0 && static_cast<pid_t>(pid) != getpid()) {
+                    if (kill(pid, SIGKILL) != 0) {
+                        return;
+                    }
+                }
+                checkAddressFiles();
+            });
+}
 
+void IBusFrontendModule::checkAddressFiles() {
     // Some one overwrite our address file.
     for (const auto &path : socketPaths_) {
         auto address = getAddress(path);
@@ -969,4 +989,4 @@ public:
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::IBusFrontendModuleFactory);
+FCITX_ADDON_FACTORY_V2(ibusfrontend, fcitx::IBusFrontendModuleFactory);
@@ -10,6 +10,7 @@
 #include <unistd.h>
 #include "fcitx-utils/dbus/servicewatcher.h"
 #include "fcitx-utils/event.h"
+#include "fcitx-utils/task.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
@@ -36,12 +37,14 @@ private:
     void replaceIBus(bool recheck);
     void becomeIBus(bool recheck);
     void ensureIsIBus();
+    void checkAddressFiles();
 
     Instance *instance_;
     std::unique_ptr<dbus::Bus> portalBus_;
     std::unique_ptr<IBusFrontend> inputMethod1_;
     std::unique_ptr<IBusFrontend> portalIBusFrontend_;
     std::unique_ptr<EventSourceTime> timeEvent_;
+    Task<void> ensureIsIBusTask_;
 
     std::set<std::string> socketPaths_;
     std::string addressWrote_;
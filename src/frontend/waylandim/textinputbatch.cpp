@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include "textinputbatch.h"
+#include <utility>
+
+namespace fcitx {
+
+bool TextInputBatch::end() {
+    if (--depth_ > 0) {
+        return false;
+    }
+    flush();
+    return true;
+}
+
+void TextInputBatch::commitString(const std::string &text) {
+    changes_.commitString.append(text);
+    // Commit string replaces the preedit on the client side, only the preedit
+    // updated after this commit string need to be sent.
+    changes_.updatePreedit = false;
+    changed();
+}
+
+void TextInputBatch::updatePreedit() {
+    changes_.updatePreedit = true;
+    changed();
+}
+
+void TextInputBatch::prepareDeleteSurroundingText() {
+    if (changes_.deleteSurroundingText || !changes_.commitString.empty()) {
+        flush();
+    }
+}
+
+void TextInputBatch::deleteSurroundingText() {
+    changes_.deleteSurroundingText = true;
+    changes_.updatePreedit = false;
+    changed();
+}
+
+void TextInputBatch::flush() {
+    if (!pending_) {
+        return;
+    }
+    pending_ = false;
+    // Reset before sending, in case the callback changes the text again.
+    auto changes = std::exchange(changes_, TextInputChanges());
+    send_(changes);
+}
+
+void TextInputBatch::changed() {
+    pending_ = true;
+    if (!depth_) {
+        flush();
+    }
+}
+
+} // namespace fcitx
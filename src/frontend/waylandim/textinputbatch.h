@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_FRONTEND_WAYLANDIM_TEXTINPUTBATCH_H_
+#define _FCITX_FRONTEND_WAYLANDIM_TEXTINPUTBATCH_H_
+
+#include <functional>
+#include <string>
+
+namespace fcitx {
+
+// Text changes of an input context that are not sent to client yet.
+struct TextInputChanges {
+    std::string commitString;
+    bool deleteSurroundingText = false;
+    bool updatePreedit = false;
+};
+
+// Accumulates commit string, preedit and delete surrounding text requested
+// while a key event is processed, so they reach the client in one update.
+// Pending changes must be flushed before any key is sent to the client,
+// otherwise the key would overtake the text committed before it.
+class TextInputBatch {
+public:
+    using SendCallback = std::function<void(const TextInputChanges &)>;
+
+    TextInputBatch(SendCallback send) : send_(std::move(send)) {}
+
+    void begin() { ++depth_; }
+    // Return true if the outermost batch ends, pending changes are sent.
+    bool end();
+    bool inBatch() const { return depth_ > 0; }
+
+    void commitString(const std::string &text);
+    void updatePreedit();
+    // Deletion is applied together with the next commit, so anything pending
+    // is sent before the deletion request.
+    void prepareDeleteSurroundingText();
+    void deleteSurroundingText();
+
+    // Send pending changes now.
+    void flush();
+
+private:
+    void changed();
+
+    SendCallback send_;
+    int depth_ = 0;
+    bool pending_ = false;
+    TextInputChanges changes_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_FRONTEND_WAYLANDIM_TEXTINPUTBATCH_H_
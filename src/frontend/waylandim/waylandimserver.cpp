@@ -199,6 +199,7 @@ void WaylandIMInputContextV1::repeat() {
         Key(repeatSym_, server_->modifiers_ | KeyState::Repeat, repeatKey_ + 8),
         false, repeatTime_);
 
+    beginBatch();
     sendKeyToVK(repeatTime_, event.rawKey().code() - 8,
                 WL_KEYBOARD_KEY_STATE_RELEASED);
     if (!keyEvent(event)) {
@@ -209,7 +210,7 @@ void WaylandIMInputContextV1::repeat() {
     uint64_t interval = 1000000 / repeatRate_;
     timeEvent_->setTime(timeEvent_->time() + interval);
     timeEvent_->setOneShot();
-    server_->display_->flush();
+    endBatch();
 }
 
 void WaylandIMInputContextV1::surroundingTextCallback(const char *text,
@@ -429,10 +430,12 @@ void WaylandIMInputContextV1::keyCallback(uint32_t serial, uint32_t time,
 
     WAYLANDIM_DEBUG() << event.key().toString()
                       << " IsRelease=" << event.isRelease();
+    beginBatch();
     if (!keyEvent(event)) {
+        batch_.flush();
         ic_->key(serial, time, key, state);
     }
-    server_->display_->flush();
+    endBatch();
 }
 void WaylandIMInputContextV1::modifiersCallback(uint32_t serial,
                                                 uint32_t mods_depressed,
@@ -499,6 +502,8 @@ void WaylandIMInputContextV1::sendKey(uint32_t time, uint32_t sym,
     if (!ic_) {
         return;
     }
+    // Text committed before the key need to reach the client first.
+    batch_.flush();
     auto modifiers = toModifiers(states);
     ic_->keysym(serial_, time, sym, state, modifiers);
 }
@@ -508,18 +513,52 @@ void WaylandIMInputContextV1::sendKeyToVK(uint32_t time, uint32_t key,
     if (!ic_) {
         return;
     }
+    // Text committed before the key need to reach the client first.
+    batch_.flush();
     lastVKKey_ = key;
     lastVKState_ = state;
     lastVKTime_ = time;
     ic_->key(serial_, time, key, state);
-    server_->display_->flush();
+    if (!batch_.inBatch()) {
+        server_->display_->flush();
+    }
+}
+
+void WaylandIMInputContextV1::endBatch() {
+    if (batch_.end()) {
+        server_->display_->flush();
+    }
+}
+
+void WaylandIMInputContextV1::sendChanges(const TextInputChanges &changes) {
+    if (!ic_) {
+        return;
+    }
+
+    // Empty commit string applies the deletion.
+    if (changes.deleteSurroundingText || !changes.commitString.empty()) {
+        ic_->commitString(serial_, changes.commitString.c_str());
+    }
+    if (changes.updatePreedit) {
+        sendPreedit();
+    }
+}
+
+void WaylandIMInputContextV1::commitStringImpl(const std::string &text) {
+    if (!ic_) {
+        return;
+    }
+    batch_.commitString(text);
 }
 
 void WaylandIMInputContextV1::updatePreeditImpl() {
     if (!ic_) {
         return;
     }
+    batch_.updatePreedit();
+}
 
+void WaylandIMInputContextV1::sendPreedit() {
     auto preedit =
         server_->instance()->outputFilter(this, inputPanel().clientPreedit());
 
@@ -563,7 +602,8 @@ void WaylandIMInputContextV1::deleteSurroundingTextImpl(int offset,
     auto startBytes = utf8::ncharByteLength(text.begin(), start);
     auto cursorBytes = utf8::ncharByteLength(text.begin(), cursor);
     auto sizeBytes = utf8::ncharByteLength(text.begin() + startBytes, size);
+    batch_.prepareDeleteSurroundingText();
     ic_->deleteSurroundingText(startBytes - cursorBytes, sizeBytes);
-    ic_->commitString(serial_, "");
+    batch_.deleteSurroundingText();
 }
 } // namespace fcitx
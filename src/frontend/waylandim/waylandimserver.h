@@ -14,6 +14,7 @@
 #include <wayland-client.h>
 #include <xkbcommon/xkbcommon.h>
 #include "display.h"
+#include "textinputbatch.h"
 #include "wayland-text-input-unstable-v1-client-protocol.h"
 #include "wl_keyboard.h"
 #include "zwp_input_method_context_v1.h"
@@ -84,12 +85,7 @@ public:
     void deactivate(wayland::ZwpInputMethodContextV1 *id);
 
 protected:
-    void commitStringImpl(const std::string &text) override {
-        if (!ic_) {
-            return;
-        }
-        ic_->commitString(serial_, text.c_str());
-    }
+    void commitStringImpl(const std::string &text) override;
     void deleteSurroundingTextImpl(int offset, unsigned int size) override;
     void forwardKeyImpl(const ForwardKeyEvent &key) override {
         if (!ic_) {
@@ -128,6 +124,13 @@ private:
     void sendKey(uint32_t time, uint32_t sym, uint32_t state, KeyStates states);
     void sendKeyToVK(uint32_t time, uint32_t key, uint32_t state);
 
+    // Within a batch, commit string and preedit are accumulated and sent
+    // together with a single display flush when the batch ends.
+    void beginBatch() { batch_.begin(); }
+    void endBatch();
+    void sendChanges(const TextInputChanges &changes);
+    void sendPreedit();
+
     static uint32_t toModifiers(KeyStates states) {
         uint32_t modifiers = 0;
         // We use Shift Control Mod1 Mod4
@@ -162,6 +165,9 @@ private:
     uint32_t lastVKKey_ = 0;
     uint32_t lastVKState_ = WL_KEYBOARD_KEY_STATE_RELEASED;
     uint32_t lastVKTime_ = 0;
+
+    TextInputBatch batch_{
+        [this](const TextInputChanges &changes) { sendChanges(changes); }};
 };
 
 } // namespace fcitx
@@ -219,12 +219,14 @@ void WaylandIMInputContextV2::repeat() {
         this,
         Key(repeatSym_, server_->modifiers_ | KeyState::Repeat, repeatKey_ + 8),
         false, repeatTime_);
+    beginBatch();
     sendKeyToVK(repeatTime_, event.rawKey().code() - 8,
                 WL_KEYBOARD_KEY_STATE_RELEASED);
     if (!keyEvent(event)) {
         sendKeyToVK(repeatTime_, event.rawKey().code() - 8,
                     WL_KEYBOARD_KEY_STATE_PRESSED);
     }
+    endBatch();
     uint64_t interval = 1000000 / repeatRate_;
     timeEvent_->setTime(timeEvent_->time() + interval);
     timeEvent_->setOneShot();
@@ -345,6 +347,12 @@ void WaylandIMInputContextV2::keymapCallback(uint32_t format, int32_t fd,
         server_->keymap_.reset(xkb_keymap_new_from_string(
             server_->context_.get(), static_cast<const char *>(mapStr),
             XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS));
+        // Only rebuilt when compositor sends a different keymap.
+        server_->keycodeTable_.reset();
+        if (server_->keymap_) {
+            server_->keycodeTable_ =
+                std::make_unique<KeycodeTable>(server_->keymap_.get());
+        }
     }
 
     munmap(mapStr, size);
@@ -356,6 +364,7 @@ void WaylandIMInputContextV2::keymapCallback(uint32_t format, int32_t fd,
     server_->state_.reset(xkb_state_new(server_->keymap_.get()));
     if (!server_->state_) {
         server_->keymap_.reset();
+        server_->keycodeTable_.reset();
         return;
     }
 
@@ -426,12 +435,13 @@ void WaylandIMInputContextV2::keyCallback(uint32_t, uint32_t time, uint32_t key,
 
     WAYLANDIM_DEBUG() << event.key().toString()
                       << " IsRelease=" << event.isRelease();
+    beginBatch();
     if (!keyEvent(event)) {
         sendKeyToVK(time, event.rawKey().code() - 8,
                     event.isRelease() ? WL_KEYBOARD_KEY_STATE_RELEASED
                                       : WL_KEYBOARD_KEY_STATE_PRESSED);
     }
-    server_->display_->flush();
+    endBatch();
 }
 void WaylandIMInputContextV2::modifiersCallback(uint32_t,
                                                 uint32_t mods_depressed,
@@ -497,28 +507,43 @@ void WaylandIMInputContextV2::repeatInfoCallback(int32_t rate, int32_t delay) {
 
 void WaylandIMInputContextV2::sendKeyToVK(uint32_t time, uint32_t key,
                                           uint32_t state) {
+    // Text committed before the key need to reach the client first.
+    batch_.flush();
     lastVKKey_ = key;
     lastVKState_ = state;
     lastVKTime_ = time;
     vk_->key(time, key, state);
-    server_->display_->flush();
+    if (!batch_.inBatch()) {
+        server_->display_->flush();
+    }
+}
+
+void WaylandIMInputContextV2::endBatch() {
+    if (batch_.end()) {
+        server_->display_->flush();
+    }
+}
+
+void WaylandIMInputContextV2::sendChanges(const TextInputChanges &changes) {
+    if (!hasFocus()) {
+        return;
+    }
+
+    if (!changes.commitString.empty()) {
+        ic_->commitString(changes.commitString.c_str());
+    }
+    if (changes.updatePreedit) {
+        sendPreedit();
+    }
+    ic_->commit(serial_);
 }
 
 void WaylandIMInputContextV2::forwardKeyImpl(const ForwardKeyEvent &key) {
     uint32_t code = 0;
     if (key.rawKey().code()) {
         code = key.rawKey().code();
-    } else if (auto xkbState = server_->xkbState()) {
-        auto *map = xkb_state_get_keymap(xkbState);
-        auto min = xkb_keymap_min_keycode(map),
-             max = xkb_keymap_max_keycode(map);
-        for (auto keyCode = min; keyCode < max; keyCode++) {
-            if (xkb_state_key_get_one_sym(xkbState, keyCode) ==
-                static_cast<uint32_t>(key.rawKey().sym())) {
-                code = keyCode;
-                break;
-            }
-        }
+    } else if (const auto *table = server_->keycodeTable()) {
+        code = table->keycode(server_->xkbState(), key.rawKey().sym());
     }
     sendKeyToVK(time_, code - 8,
                 key.isRelease() ? WL_KEYBOARD_KEY_STATE_RELEASED
@@ -528,10 +553,21 @@ void WaylandIMInputContextV2::forwardKeyImpl(const ForwardKeyEvent &key) {
     }
 }
 
+void WaylandIMInputContextV2::commitStringImpl(const std::string &text) {
+    if (!hasFocus()) {
+        return;
+    }
+    batch_.commitString(text);
+}
+
 void WaylandIMInputContextV2::updatePreeditImpl() {
     if (!hasFocus()) {
         return;
     }
+    batch_.updatePreedit();
+}
+
+void WaylandIMInputContextV2::sendPreedit() {
     auto preedit =
         server_->instance()->outputFilter(this, inputPanel().clientPreedit());
 
@@ -565,7 +601,6 @@ void WaylandIMInputContextV2::updatePreeditImpl() {
     }
 
     ic_->setPreeditString(preedit.toString().data(), cursorStart, cursorEnd);
-    ic_->commit(serial_);
 }
 
 void WaylandIMInputContextV2::deleteSurroundingTextImpl(int offset,
@@ -597,9 +632,12 @@ void WaylandIMInputContextV2::deleteSurroundingTextImpl(int offset,
     auto startBytes = utf8::ncharByteLength(text.begin(), start);
     auto cursorBytes = utf8::ncharByteLength(text.begin(), cursor);
     auto sizeBytes = utf8::ncharByteLength(text.begin() + startBytes, size);
+    // Compositor always applies deletion before commit string, so anything
+    // already pending need to go out first to keep the order.
+    batch_.prepareDeleteSurroundingText();
     ic_->deleteSurroundingText(cursorBytes - startBytes,
                                startBytes + sizeBytes - cursorBytes);
-    ic_->commit(serial_);
+    batch_.deleteSurroundingText();
 }
 
 } // namespace fcitx
@@ -10,8 +10,10 @@
 #include <fcitx-utils/event.h>
 #include <fcitx/focusgroup.h>
 #include <fcitx/instance.h>
+#include <fcitx/keycodetable.h>
 #include <xkbcommon/xkbcommon.h>
 #include "display.h"
+#include "textinputbatch.h"
 #include "zwp_input_method_keyboard_grab_v2.h"
 #include "zwp_input_method_manager_v2.h"
 #include "zwp_input_method_v2.h"
@@ -42,6 +44,7 @@ public:
     Instance *instance();
     FocusGroup *group() { return group_; }
     auto *xkbState() { return state_.get(); }
+    const KeycodeTable *keycodeTable() const { return keycodeTable_.get(); }
     auto *inputMethodManagerV2() { return inputMethodManagerV2_.get(); }
 
 private:
@@ -57,6 +60,7 @@ private:
     std::vector<char> keymapData_;
     UniqueCPtr<struct xkb_keymap, xkb_keymap_unref> keymap_;
     UniqueCPtr<struct xkb_state, xkb_state_unref> state_;
+    std::unique_ptr<KeycodeTable> keycodeTable_;
 
     wayland::Display *display_;
     ScopedConnection globalConn_;
@@ -93,13 +97,7 @@ public:
     auto inputMethodV2() { return ic_.get(); }
 
 protected:
-    void commitStringImpl(const std::string &text) override {
-        if (!hasFocus()) {
-            return;
-        }
-        ic_->commitString(text.c_str());
-        ic_->commit(serial_);
-    }
+    void commitStringImpl(const std::string &text) override;
     void deleteSurroundingTextImpl(int offset, unsigned int size) override;
     void forwardKeyImpl(const ForwardKeyEvent &key) override;
 
@@ -122,6 +120,14 @@ private:
     void repeatInfoCallback(int32_t rate, int32_t delay);
     void sendKeyToVK(uint32_t time, uint32_t key, uint32_t state);
 
+    // Text input state sent to the compositor is double buffered. Within a
+    // batch, commit string, preedit and delete surrounding text are only
+    // accumulated, and applied with a single commit when the batch ends.
+    void beginBatch() { batch_.begin(); }
+    void endBatch();
+    void sendChanges(const TextInputChanges &changes);
+    void sendPreedit();
+
     WaylandIMServerV2 *server_;
     std::shared_ptr<wayland::WlSeat> seat_;
     std::unique_ptr<wayland::ZwpInputMethodV2> ic_;
@@ -144,6 +150,9 @@ private:
     uint32_t lastVKKey_ = 0;
     uint32_t lastVKState_ = WL_KEYBOARD_KEY_STATE_RELEASED;
     uint32_t lastVKTime_ = 0;
+
+    TextInputBatch batch_{
+        [this](const TextInputChanges &changes) { sendChanges(changes); }};
 };
 
 } // namespace fcitx
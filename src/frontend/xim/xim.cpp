@@ -165,6 +165,9 @@ public:
     auto xkbState() {
         return parent_->xcb()->call<IXCBModule::xkbState>(name_);
     }
+    const KeycodeTable *keycodeTable() {
+        return parent_->xcb()->call<IXCBModule::keycodeTable>(name_);
+    }
 
 private:
     xcb_connection_t *conn_;
@@ -364,18 +367,10 @@ protected:
         if (key.rawKey().code()) {
             xcbEvent.detail = key.rawKey().code();
         } else {
-            xkb_state *xkbState = server_->xkbState();
-            if (xkbState) {
-                auto *map = xkb_state_get_keymap(xkbState);
-                auto min = xkb_keymap_min_keycode(map),
-                     max = xkb_keymap_max_keycode(map);
-                for (auto keyCode = min; keyCode < max; keyCode++) {
-                    if (xkb_state_key_get_one_sym(xkbState, keyCode) ==
-                        static_cast<uint32_t>(key.rawKey().sym())) {
-                        xcbEvent.detail = keyCode;
-                        break;
-                    }
-                }
+            // Table and state are replaced together with the keymap.
+            if (const auto *table = server_->keycodeTable()) {
+                xcbEvent.detail =
+                    table->keycode(server_->xkbState(), key.rawKey().sym());
             }
         }
         xcbEvent.root = server_->root();
@@ -626,4 +621,4 @@ public:
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::XIMModuleFactory);
+FCITX_ADDON_FACTORY_V2(xim, fcitx::XIMModuleFactory);
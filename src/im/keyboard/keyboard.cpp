@@ -638,17 +638,42 @@ void KeyboardEngine::updateUI(InputContext *inputContext) {
 
 void KeyboardEngine::updateCandidate(const InputMethodEntry &entry,
                                      InputContext *inputContext) {
-    inputContext->inputPanel().reset();
     auto *state = inputContext->propertyFor(&factory_);
-    std::vector<std::string> results;
-    if (spell()) {
-        results = spell()->call<ISpell::hint>(entry.languageCode(),
-                                              state->buffer_.userInput(),
-                                              config_.pageSize.value());
+    // Show the input right away, spell result may take a while and is filled
+    // in when it is ready.
+    state->spellHint_.reset();
+    setHintCandidates(entry.languageCode(), inputContext, {});
+    if (!spell()) {
+        return;
     }
+    state->spellHint_ = spell()->call<ISpell::hintAsync>(
+        entry.languageCode(), state->buffer_.userInput(),
+        config_.pageSize.value(),
+        [this, language = entry.languageCode(), ref = inputContext->watch(),
+         word = state->buffer_.userInput()](
+            const std::vector<std::string> &results) {
+            auto *inputContext = ref.get();
+            if (!inputContext) {
+                return;
+            }
+            auto *state = inputContext->propertyFor(&factory_);
+            // Discard result if buffer is already changed.
+            if (state->mode_ != CandidateMode::Hint ||
+                state->buffer_.userInput() != word) {
+                return;
+            }
+            setHintCandidates(language, inputContext, results);
+        });
+}
+
+void KeyboardEngine::setHintCandidates(const std::string &language,
+                                       InputContext *inputContext,
+                                       std::vector<std::string> results) {
+    inputContext->inputPanel().reset();
+    auto *state = inputContext->propertyFor(&factory_);
     if (config_.enableEmoji.value() && emoji()) {
         auto emojiResults = emoji()->call<IEmoji::query>(
-            entry.languageCode(), state->buffer_.userInput(), true);
+            language, state->buffer_.userInput(), true);
         // If we have emoji result and spell result is full, pop one from the
         // original result, because emoji matching is always exact. Which means
         // the spell is right.
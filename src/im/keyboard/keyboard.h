@@ -12,6 +12,7 @@
 #include "fcitx-config/configuration.h"
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/event.h"
+#include "fcitx-utils/handlertable.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/inputbuffer.h"
 #include "fcitx/addonfactory.h"
@@ -23,6 +24,7 @@
 #include "keyboard_public.h"
 #include "longpress.h"
 #include "quickphrase_public.h"
+#include "spell_public.h"
 #include "xkbrules.h"
 
 namespace fcitx {
@@ -91,6 +93,8 @@ struct KeyboardEngineState : public InputContextProperty {
     CandidateMode mode_ = CandidateMode::Hint;
     std::string origKeyString_;
     bool repeatStarted_ = false;
+    // Pending spell hint request, reset it to cancel.
+    std::unique_ptr<HandlerTableEntry<SpellHintCallback>> spellHint_;
 
     bool hintEnabled() const {
         return enableWordHint_ || oneTimeEnableWordHint_;
@@ -102,6 +106,7 @@ struct KeyboardEngineState : public InputContextProperty {
         mode_ = CandidateMode::Hint;
         repeatStarted_ = false;
         oneTimeEnableWordHint_ = false;
+        spellHint_.reset();
     }
 };
 
@@ -140,6 +145,10 @@ public:
 
     void updateCandidate(const InputMethodEntry &entry,
                          InputContext *inputContext);
+    // Set the hint candidates with spell result and emoji, then update UI.
+    void setHintCandidates(const std::string &language,
+                           InputContext *inputContext,
+                           std::vector<std::string> results);
     // Update preedit and send ui update.
     void updateUI(InputContext *inputContext);
 
@@ -8,6 +8,7 @@
 #include "xkbrules.h"
 #include <cstring>
 #include <list>
+#include "fcitx-utils/diskcache.h"
 #include "fcitx-utils/stringutils.h"
 #include "xmlparser.h"
 
@@ -148,9 +149,52 @@ struct XkbRulesParseState : public XMLParser {
     }
 };
 
+namespace {
+
+void writeStrings(DiskCacheWriter &writer,
+                  const std::vector<std::string> &strings) {
+    writer.writeUInt32(strings.size());
+    for (const auto &str : strings) {
+        writer.writeString(str);
+    }
+}
+
+bool readStrings(DiskCacheReader &reader, std::vector<std::string> &strings) {
+    uint32_t size;
+    if (!reader.readUInt32(size)) {
+        return false;
+    }
+    strings.resize(size);
+    for (auto &str : strings) {
+        if (!reader.readString(str)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 bool XkbRules::read(const std::string &fileName) {
     clear();
 
+    std::string extraFile;
+    if (stringutils::endsWith(fileName, ".xml")) {
+        extraFile = fileName.substr(0, fileName.size() - 3);
+        extraFile += "extras.xml";
+    }
+
+    // Parsing the xml takes a noticeable amount of time on start up.
+    DiskCache cache("keyboard-xkbrules", 1);
+    cache.addSourceFile(fileName);
+    if (!extraFile.empty()) {
+        cache.addSourceFile(extraFile);
+    }
+    if (loadCache(cache)) {
+        return true;
+    }
+    clear();
+
     {
         XkbRulesParseState state;
         state.rules_ = this;
@@ -160,20 +204,120 @@ bool XkbRules::read(const std::string &fileName) {
         state.merge(this);
     }
 
-    if (stringutils::endsWith(fileName, ".xml")) {
-        auto extraFile = fileName.substr(0, fileName.size() - 3);
-        extraFile += "extras.xml";
-        {
-            XkbRulesParseState state;
-            state.rules_ = this;
-            if (state.parse(extraFile)) {
-                state.merge(this);
-            }
+    if (!extraFile.empty()) {
+        XkbRulesParseState state;
+        state.rules_ = this;
+        if (state.parse(extraFile)) {
+            state.merge(this);
         }
     }
+    saveCache(cache);
     return true;
 }
 
+bool XkbRules::loadCache(const DiskCache &cache) {
+    auto data = cache.load();
+    if (!data) {
+        return false;
+    }
+    DiskCacheReader reader(data->view());
+    uint32_t size;
+    if (!reader.readString(version_) || !reader.readUInt32(size)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        XkbLayoutInfo info;
+        uint32_t variantSize;
+        if (!reader.readString(info.name) ||
+            !reader.readString(info.description) ||
+            !reader.readString(info.shortDescription) ||
+            !readStrings(reader, info.languages) ||
+            !reader.readUInt32(variantSize)) {
+            return false;
+        }
+        info.variantInfos.resize(variantSize);
+        for (auto &variant : info.variantInfos) {
+            if (!reader.readString(variant.name) ||
+                !reader.readString(variant.description) ||
+                !reader.readString(variant.shortDescription) ||
+                !readStrings(reader, variant.languages)) {
+                return false;
+            }
+        }
+        auto name = info.name;
+        layoutInfos_.emplace(std::move(name), std::move(info));
+    }
+    if (!reader.readUInt32(size)) {
+        return false;
+    }
+    modelInfos_.resize(size);
+    for (auto &model : modelInfos_) {
+        if (!reader.readString(model.name) ||
+            !reader.readString(model.description) ||
+            !reader.readString(model.vendor)) {
+            return false;
+        }
+    }
+    if (!reader.readUInt32(size)) {
+        return false;
+    }
+    optionGroupInfos_.resize(size);
+    for (auto &group : optionGroupInfos_) {
+        uint32_t exclusive, optionSize;
+        if (!reader.readString(group.name) ||
+            !reader.readString(group.description) ||
+            !reader.readUInt32(exclusive) || !reader.readUInt32(optionSize)) {
+            return false;
+        }
+        group.exclusive = exclusive;
+        group.optionInfos.resize(optionSize);
+        for (auto &option : group.optionInfos) {
+            if (!reader.readString(option.name) ||
+                !reader.readString(option.description)) {
+                return false;
+            }
+        }
+    }
+    return reader.atEnd();
+}
+
+void XkbRules::saveCache(const DiskCache &cache) const {
+    DiskCacheWriter writer;
+    writer.writeString(version_);
+    writer.writeUInt32(layoutInfos_.size());
+    for (const auto &[name, info] : layoutInfos_) {
+        writer.writeString(info.name);
+        writer.writeString(info.description);
+        writer.writeString(info.shortDescription);
+        writeStrings(writer, info.languages);
+        writer.writeUInt32(info.variantInfos.size());
+        for (const auto &variant : info.variantInfos) {
+            writer.writeString(variant.name);
+            writer.writeString(variant.description);
+            writer.writeString(variant.shortDescription);
+            writeStrings(writer, variant.languages);
+        }
+    }
+    writer.writeUInt32(modelInfos_.size());
+    for (const auto &model : modelInfos_) {
+        writer.writeString(model.name);
+        writer.writeString(model.description);
+        writer.writeString(model.vendor);
+    }
+    writer.writeUInt32(optionGroupInfos_.size());
+    for (const auto &group : optionGroupInfos_) {
+        writer.writeString(group.name);
+        writer.writeString(group.description);
+        writer.writeUInt32(group.exclusive);
+        writer.writeUInt32(group.optionInfos.size());
+        for (const auto &option : group.optionInfos) {
+            writer.writeString(option.name);
+            writer.writeString(option.description);
+        }
+    }
+    cache.save(writer.data());
+}
+
 #ifdef _TEST_XKBRULES
 void XkbRules::dump() {
     std::cout << "Version: " << version_ << std::endl;
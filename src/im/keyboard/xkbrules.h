@@ -14,6 +14,8 @@
 
 namespace fcitx {
 
+class DiskCache;
+
 struct XkbVariantInfo {
     std::string name;
     std::string description;
@@ -73,6 +75,9 @@ public:
     auto &version() const { return version_; }
 
 private:
+    bool loadCache(const DiskCache &cache);
+    void saveCache(const DiskCache &cache) const;
+
     std::unordered_map<std::string, XkbLayoutInfo> layoutInfos_;
     std::vector<XkbModelInfo> modelInfos_;
     std::vector<XkbOptionGroupInfo> optionGroupInfos_;
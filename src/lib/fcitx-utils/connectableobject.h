@@ -102,6 +102,16 @@ protected:
             signal))(std::forward<Args>(args)...);
     }
 
+    /// Check if emitting the signal would invoke anything, so the caller
+    /// may skip preparing the arguments.
+    template <typename SignalType>
+    bool hasConnections() const {
+        auto signal = findSignal(SignalType::signature::data());
+        return signal &&
+               static_cast<Signal<typename SignalType::signalType> *>(signal)
+                   ->hasConnections();
+    }
+
     template <typename SignalType,
               typename Combiner = LastValue<typename std::function<
                   typename SignalType::signalType>::result_type>>
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_DBUS_CALLTASK_H_
+#define _FCITX_UTILS_DBUS_CALLTASK_H_
+
+#include <string>
+#include <fcitx-utils/dbus/bus.h>
+#include <fcitx-utils/dbus/message.h>
+#include <fcitx-utils/task.h>
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief Task wrappers of asynchronous dbus calls.
+
+namespace fcitx {
+namespace dbus {
+
+/**
+ * Call the method asynchronously, the task resolves with the reply.
+ *
+ * The reply may also be an error, e.g. when the call times out. Destroying
+ * the task cancels the call.
+ *
+ * @see Message::callAsync
+ * @since 5.0.14
+ */
+inline Task<Message> callTask(Message &message, uint64_t usec) {
+    Task<Message> task;
+    task.attach(message.callAsync(
+        usec, [promise = task.promise()](Message &reply) {
+            promise.resolve(std::move(reply));
+            return true;
+        }));
+    return task;
+}
+
+/**
+ * Query the owner of the name, resolves with empty string if it has no
+ * owner or the call fails.
+ *
+ * @see Bus::serviceOwnerAsync
+ * @since 5.0.14
+ */
+inline Task<std::string> serviceOwnerTask(Bus &bus, const std::string &name,
+                                          uint64_t usec) {
+    Task<std::string> task;
+    task.attach(bus.serviceOwnerAsync(
+        name, usec, [promise = task.promise()](Message &reply) {
+            std::string owner;
+            if (reply.type() == MessageType::Reply) {
+                reply >> owner;
+            }
+            promise.resolve(std::move(owner));
+            return true;
+        }));
+    return task;
+}
+
+} // namespace dbus
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_DBUS_CALLTASK_H_
@@ -0,0 +1,290 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "diskcache.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "endian_p.h"
+#include "fs.h"
+#include "log.h"
+#include "misc_p.h"
+#include "mtime_p.h"
+#include "standardpath.h"
+#include "stringutils.h"
+#include "unixfd.h"
+
+namespace fcitx {
+
+namespace {
+
+constexpr char cacheMagic[8] = {'F', 'C', 'I', 'T', 'X', 'D', 'C', '\0'};
+constexpr uint32_t cacheFormatVersion = 1;
+constexpr char cacheSuffix[] = ".cache";
+
+// magic, format version, payload version, key, payload size, checksum, then
+// padded so the payload is aligned.
+constexpr size_t headerSize = 64;
+
+class FNV1a {
+public:
+    void update(const void *data, size_t size) {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash_ ^= bytes[i];
+            hash_ *= 0x100000001b3ULL;
+        }
+    }
+
+    void update(uint64_t value) {
+        value = htole64(value);
+        update(&value, sizeof(value));
+    }
+
+    void update(std::string_view str) {
+        update(str.size());
+        update(str.data(), str.size());
+    }
+
+    uint64_t hash() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0xcbf29ce484222325ULL;
+};
+
+uint32_t readLE32(const char *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return le32toh(value);
+}
+
+uint64_t readLE64(const char *data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return le64toh(value);
+}
+
+void writeLE32(char *data, uint32_t value) {
+    value = htole32(value);
+    memcpy(data, &value, sizeof(value));
+}
+
+void writeLE64(char *data, uint64_t value) {
+    value = htole64(value);
+    memcpy(data, &value, sizeof(value));
+}
+
+std::string cacheDirectory() {
+    auto dir = StandardPath::global().userDirectory(StandardPath::Type::Cache);
+    if (dir.empty()) {
+        return {};
+    }
+    return stringutils::joinPath(dir, "fcitx5");
+}
+
+} // namespace
+
+DiskCacheData::DiskCacheData(void *map, size_t mapSize, size_t offset,
+                             size_t size)
+    : map_(map), mapSize_(mapSize),
+      data_(static_cast<const char *>(map) + offset), size_(size) {}
+
+DiskCacheData::DiskCacheData(DiskCacheData &&other) noexcept
+    : map_(std::exchange(other.map_, nullptr)),
+      mapSize_(std::exchange(other.mapSize_, 0)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+DiskCacheData::~DiskCacheData() {
+    if (map_) {
+        munmap(map_, mapSize_);
+    }
+}
+
+DiskCacheData &DiskCacheData::operator=(DiskCacheData other) noexcept {
+    std::swap(map_, other.map_);
+    std::swap(mapSize_, other.mapSize_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+}
+
+class DiskCachePrivate {
+public:
+    DiskCachePrivate(const std::string &name, uint32_t version)
+        : name_(name), version_(version) {
+        key_.update(name);
+        key_.update(version);
+        auto dir = cacheDirectory();
+        if (!dir.empty() && !name.empty() &&
+            name.find('/') == std::string::npos) {
+            path_ = stringutils::joinPath(dir,
+                                          stringutils::concat(name, cacheSuffix));
+        }
+    }
+
+    std::string name_;
+    uint32_t version_;
+    std::string path_;
+    FNV1a key_;
+};
+
+DiskCache::DiskCache(const std::string &name, uint32_t version)
+    : d_ptr(std::make_unique<DiskCachePrivate>(name, version)) {}
+
+DiskCache::~DiskCache() = default;
+
+void DiskCache::addSourceFile(const std::string &path) {
+    FCITX_D();
+    d->key_.update(path);
+    struct stat stats;
+    if (stat(path.c_str(), &stats) != 0) {
+        // Still change the key, so file appears later will invalidate it.
+        d->key_.update(static_cast<uint64_t>(-1));
+        return;
+    }
+    auto mtime = modifiedTime(stats);
+    d->key_.update(static_cast<uint64_t>(stats.st_size));
+    d->key_.update(static_cast<uint64_t>(mtime.sec));
+    d->key_.update(static_cast<uint64_t>(mtime.nsec));
+}
+
+void DiskCache::addSourceData(std::string_view data) {
+    FCITX_D();
+    d->key_.update(data);
+}
+
+const std::string &DiskCache::path() const {
+    FCITX_D();
+    return d->path_;
+}
+
+std::optional<DiskCacheData> DiskCache::load() const {
+    FCITX_D();
+    if (d->path_.empty()) {
+        return std::nullopt;
+    }
+    UnixFD fd = UnixFD::own(open(d->path_.c_str(), O_RDONLY));
+    if (!fd.isValid()) {
+        return std::nullopt;
+    }
+    struct stat stats;
+    if (fstat(fd.fd(), &stats) != 0 ||
+        static_cast<size_t>(stats.st_size) < headerSize) {
+        return std::nullopt;
+    }
+    const size_t size = stats.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.fd(), 0);
+    if (map == MAP_FAILED) {
+        return std::nullopt;
+    }
+    DiskCacheData data(map, size, headerSize, size - headerSize);
+
+    const auto *header = static_cast<const char *>(map);
+    if (memcmp(header, cacheMagic, sizeof(cacheMagic)) != 0 ||
+        readLE32(header + 8) != cacheFormatVersion ||
+        readLE32(header + 12) != d->version_ ||
+        readLE64(header + 16) != d->key_.hash() ||
+        readLE64(header + 24) != data.size()) {
+        return std::nullopt;
+    }
+    FNV1a checksum;
+    checksum.update(data.data(), data.size());
+    if (readLE64(header + 32) != checksum.hash()) {
+        FCITX_WARN() << "Cache file " << d->path_ << " is corrupted.";
+        return std::nullopt;
+    }
+    // Modification time of the cache file is used for LRU eviction.
+    futimens(fd.fd(), nullptr);
+    return data;
+}
+
+bool DiskCache::save(std::string_view payload) const {
+    FCITX_D();
+    if (d->path_.empty()) {
+        return false;
+    }
+    char header[headerSize] = {0};
+    memcpy(header, cacheMagic, sizeof(cacheMagic));
+    writeLE32(header + 8, cacheFormatVersion);
+    writeLE32(header + 12, d->version_);
+    writeLE64(header + 16, d->key_.hash());
+    writeLE64(header + 24, payload.size());
+    FNV1a checksum;
+    checksum.update(payload.data(), payload.size());
+    writeLE64(header + 32, checksum.hash());
+
+    bool result = StandardPath::global().safeSave(
+        StandardPath::Type::Cache,
+        stringutils::joinPath("fcitx5",
+                              stringutils::concat(d->name_, cacheSuffix)),
+        [&header, &payload](int fd) {
+            return fs::safeWrite(fd, header, sizeof(header)) ==
+                       static_cast<ssize_t>(sizeof(header)) &&
+                   fs::safeWrite(fd, payload.data(), payload.size()) ==
+                       static_cast<ssize_t>(payload.size());
+        });
+    if (result) {
+        evict();
+    }
+    return result;
+}
+
+void DiskCache::evict(size_t budget) {
+    auto dir = cacheDirectory();
+    if (dir.empty()) {
+        return;
+    }
+    UniqueCPtr<DIR, closedir> scopedDir{opendir(dir.c_str())};
+    if (!scopedDir) {
+        return;
+    }
+    struct CacheFile {
+        std::string path;
+        size_t size;
+        Timespec mtime;
+    };
+    std::vector<CacheFile> files;
+    size_t total = 0;
+    struct dirent *drt;
+    while ((drt = readdir(scopedDir.get())) != nullptr) {
+        // Temporary files from safeSave don't have the suffix.
+        if (!stringutils::endsWith(drt->d_name, cacheSuffix)) {
+            continue;
+        }
+        auto path = stringutils::joinPath(dir, drt->d_name);
+        struct stat stats;
+        if (stat(path.c_str(), &stats) != 0 || !S_ISREG(stats.st_mode)) {
+            continue;
+        }
+        total += stats.st_size;
+        files.push_back({std::move(path), static_cast<size_t>(stats.st_size),
+                         modifiedTime(stats)});
+    }
+    if (total <= budget) {
+        return;
+    }
+    std::sort(files.begin(), files.end(),
+              [](const CacheFile &lhs, const CacheFile &rhs) {
+                  return std::make_pair(lhs.mtime.sec, lhs.mtime.nsec) <
+                         std::make_pair(rhs.mtime.sec, rhs.mtime.nsec);
+              });
+    for (const auto &file : files) {
+        if (total <= budget) {
+            break;
+        }
+        if (unlink(file.path.c_str()) == 0) {
+            total -= file.size;
+        }
+    }
+}
+
+} // namespace fcitx
@@ -0,0 +1,192 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_DISKCACHE_H_
+#define _FCITX_UTILS_DISKCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <fcitx-utils/macros.h>
+#include "fcitxutils_export.h"
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief On disk cache for data derived from other files.
+
+namespace fcitx {
+
+class DiskCachePrivate;
+
+/**
+ * Read only payload of a cache file, mapped into memory.
+ *
+ * The data is aligned to 8 bytes.
+ *
+ * @since 5.0.14
+ */
+class FCITXUTILS_EXPORT DiskCacheData {
+public:
+    DiskCacheData(const DiskCacheData &) = delete;
+    DiskCacheData(DiskCacheData &&other) noexcept;
+    ~DiskCacheData();
+    DiskCacheData &operator=(DiskCacheData other) noexcept;
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    friend class DiskCache;
+    DiskCacheData(void *map, size_t mapSize, size_t offset, size_t size);
+
+    void *map_ = nullptr;
+    size_t mapSize_ = 0;
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * A cache file under $XDG_CACHE_HOME/fcitx5.
+ *
+ * The entry is keyed by the name, the version of payload format and the
+ * sources added to it. If any of them changes, load will miss and the caller
+ * is expected to rebuild the data and save it again. Files are written with
+ * StandardPath::safeSave, and verified with a checksum when loaded. Least
+ * recently used files are removed when the total size is over the budget.
+ *
+ * \code{.cpp}
+ * DiskCache cache("mymodule-index", 1);
+ * cache.addSourceFile(sourceFile);
+ * if (auto data = cache.load()) {
+ *     // Read from data->data().
+ * } else {
+ *     // Build from sourceFile, then cache.save(payload).
+ * }
+ * \endcode
+ *
+ * @since 5.0.14
+ */
+class FCITXUTILS_EXPORT DiskCache {
+public:
+    /// Default total size of all cache files, in bytes.
+    static constexpr size_t defaultBudget = 64 * 1024 * 1024;
+
+    /**
+     * Create a cache entry.
+     *
+     * @param name file name of the entry, must not contain '/'.
+     * @param version version of payload format.
+     */
+    DiskCache(const std::string &name, uint32_t version);
+    virtual ~DiskCache();
+
+    /// Key the entry by the path, size and modification time of the file.
+    void addSourceFile(const std::string &path);
+
+    /// Key the entry by the content.
+    void addSourceData(std::string_view data);
+
+    /// Full path of the cache file, empty if there is no user cache directory.
+    const std::string &path() const;
+
+    /// Return the payload if the file exists, is valid and matches the key.
+    std::optional<DiskCacheData> load() const;
+
+    /// Save the payload, and evict old entries if over the default budget.
+    bool save(std::string_view payload) const;
+
+    /**
+     * Remove least recently used cache files until total size is less than
+     * budget.
+     */
+    static void evict(size_t budget = defaultBudget);
+
+private:
+    std::unique_ptr<DiskCachePrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(DiskCache);
+};
+
+/**
+ * Helper to build a payload with little endian integers and strings.
+ *
+ * @since 5.0.14
+ */
+class DiskCacheWriter {
+public:
+    void writeUInt32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            data_.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+        }
+    }
+
+    void writeString(std::string_view str) {
+        writeUInt32(str.size());
+        data_.append(str.data(), str.size());
+    }
+
+    const std::string &data() const { return data_; }
+
+private:
+    std::string data_;
+};
+
+/**
+ * Helper to read a payload written by DiskCacheWriter.
+ *
+ * All read functions return false if the payload is truncated.
+ *
+ * @since 5.0.14
+ */
+class DiskCacheReader {
+public:
+    DiskCacheReader(std::string_view data) : data_(data) {}
+
+    bool readUInt32(uint32_t &value) {
+        if (data_.size() < 4) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[i]))
+                     << (i * 8);
+        }
+        data_.remove_prefix(4);
+        return true;
+    }
+
+    bool readString(std::string_view &str) {
+        uint32_t size;
+        if (!readUInt32(size) || data_.size() < size) {
+            return false;
+        }
+        str = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return true;
+    }
+
+    bool readString(std::string &str) {
+        std::string_view view;
+        if (!readString(view)) {
+            return false;
+        }
+        str = view;
+        return true;
+    }
+
+    bool atEnd() const { return data_.empty(); }
+
+private:
+    std::string_view data_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_DISKCACHE_H_
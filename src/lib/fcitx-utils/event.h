@@ -8,10 +8,13 @@
 #define _FCITX_UTILS_EVENT_H_
 
 #include <time.h>
+#include <array>
 #include <cstring>
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 #include <fcitx-utils/flags.h>
 #include <fcitx-utils/macros.h>
 #include "fcitxutils_export.h"
@@ -70,6 +73,46 @@ typedef std::function<bool(EventSource *)> EventCallback;
 
 FCITXUTILS_EXPORT uint64_t now(clockid_t clock);
 
+/**
+ * Callback statistics of all event sources with the same label.
+ *
+ * Time is in microseconds.
+ *
+ * @see EventLoop::statistics
+ * @since 5.0.14
+ */
+struct EventSourceStatistics {
+    /// Upper bounds of the histogram buckets, the last bucket has no bound.
+    static constexpr std::array<uint64_t, 6> histogramBounds = {
+        100, 1000, 4000, 16000, 64000, 256000};
+
+    std::string label;
+    uint64_t count = 0;
+    uint64_t totalTime = 0;
+    uint64_t maxTime = 0;
+    std::array<uint64_t, histogramBounds.size() + 1> histogram = {};
+};
+
+/**
+ * Label event sources created within the scope, e.g. with the addon name.
+ *
+ * Sources created from a callback inherit the label of the source being
+ * dispatched, unless a label is set explicitly.
+ *
+ * @since 5.0.14
+ */
+class FCITXUTILS_EXPORT EventSourceLabel {
+public:
+    explicit EventSourceLabel(const std::string &label);
+    ~EventSourceLabel();
+
+    EventSourceLabel(const EventSourceLabel &) = delete;
+    EventSourceLabel &operator=(const EventSourceLabel &) = delete;
+
+private:
+    std::shared_ptr<const std::string> previous_;
+};
+
 class EventLoopPrivate;
 class FCITXUTILS_EXPORT EventLoop {
 public:
@@ -91,6 +134,39 @@ public:
     FCITX_NODISCARD std::unique_ptr<EventSource>
     addDeferEvent(EventCallback callback);
 
+    /**
+     * Record how long callbacks take for each label of event source.
+     *
+     * Disabled by default.
+     *
+     * @since 5.0.14
+     */
+    void setStatisticsEnabled(bool enabled);
+
+    /// @since 5.0.14
+    bool statisticsEnabled() const;
+
+    /**
+     * Warn about callbacks that run longer than the threshold.
+     *
+     * A watchdog thread reports the callback while it is still running, so
+     * a hang is also reported. It only works when statistics is enabled.
+     *
+     * @param usec threshold in microseconds, 0 to disable.
+     * @since 5.0.14
+     */
+    void setStallThreshold(uint64_t usec);
+
+    /**
+     * Statistics of each label, sorted by total time.
+     *
+     * @since 5.0.14
+     */
+    std::vector<EventSourceStatistics> statistics() const;
+
+    /// @since 5.0.14
+    void resetStatistics();
+
 private:
     const std::unique_ptr<EventLoopPrivate> d_ptr;
     FCITX_DECLARE_PRIVATE(EventLoop);
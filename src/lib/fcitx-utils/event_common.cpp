@@ -6,8 +6,13 @@
  *
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include "event.h"
+#include "event_p.h"
+#include "log.h"
+#include "stringutils.h"
 
 #define USEC_INFINITY ((uint64_t)-1)
 #define USEC_PER_SEC ((uint64_t)1000000ULL)
@@ -45,4 +50,148 @@ void EventSourceTime::setNextInterval(uint64_t time) {
 }
 
 EventSource::~EventSource() {}
+
+namespace {
+thread_local EventSourceLabelPtr currentLabel;
+} // namespace
+
+EventSourceLabelPtr currentEventSourceLabel() { return currentLabel; }
+
+EventSourceLabel::EventSourceLabel(const std::string &label)
+    : previous_(std::exchange(currentLabel,
+                              std::make_shared<const std::string>(label))) {}
+
+EventSourceLabel::~EventSourceLabel() { currentLabel = std::move(previous_); }
+
+EventLoopStatistics::DispatchScope::DispatchScope(EventSourceLabelPtr label)
+    : previous_(std::exchange(currentLabel, std::move(label))) {}
+
+EventLoopStatistics::DispatchScope::~DispatchScope() {
+    currentLabel = std::move(previous_);
+}
+
+EventLoopStatistics::~EventLoopStatistics() {
+    threshold_ = 0;
+    updateWatchdog();
+}
+
+void EventLoopStatistics::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    updateWatchdog();
+}
+
+void EventLoopStatistics::setStallThreshold(uint64_t usec) {
+    threshold_ = usec;
+    updateWatchdog();
+}
+
+std::vector<EventSourceStatistics> EventLoopStatistics::statistics() const {
+    std::vector<EventSourceStatistics> result;
+    result.reserve(statistics_.size());
+    for (const auto &item : statistics_) {
+        result.push_back(item.second);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const EventSourceStatistics &lhs,
+                 const EventSourceStatistics &rhs) {
+                  return lhs.totalTime > rhs.totalTime;
+              });
+    return result;
+}
+
+void EventLoopStatistics::reset() { statistics_.clear(); }
+
+uint64_t EventLoopStatistics::begin(const EventSourceLabelPtr &label) {
+    auto start = now(CLOCK_MONOTONIC);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stack_.emplace_back(label ? *label : std::string(), start);
+    ++serial_;
+    return start;
+}
+
+void EventLoopStatistics::end(const EventSourceLabelPtr &label,
+                              uint64_t start) {
+    auto time = now(CLOCK_MONOTONIC) - start;
+    std::string stack;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto threshold = threshold_.load();
+        if (threshold && time > threshold) {
+            stack = stackString();
+        }
+        stack_.pop_back();
+        // The callback of outer loop is still running.
+        ++serial_;
+    }
+    if (!stack.empty()) {
+        FCITX_WARN() << "Event source callback [" << stack << "] took "
+                     << time / 1000 << "ms.";
+    }
+
+    const std::string &key = label ? *label : std::string();
+    auto iter = statistics_.find(key);
+    if (iter == statistics_.end()) {
+        iter = statistics_.emplace(key, EventSourceStatistics()).first;
+        iter->second.label = key;
+    }
+    auto &stats = iter->second;
+    stats.count += 1;
+    stats.totalTime += time;
+    stats.maxTime = std::max(stats.maxTime, time);
+    const auto &bounds = EventSourceStatistics::histogramBounds;
+    auto bucket = std::upper_bound(bounds.begin(), bounds.end(), time) -
+                  bounds.begin();
+    stats.histogram[bucket] += 1;
+}
+
+std::string EventLoopStatistics::stackString() const {
+    std::vector<std::string> labels;
+    for (const auto &item : stack_) {
+        labels.push_back(item.first.empty() ? "unlabeled" : item.first);
+    }
+    return stringutils::join(labels, " > ");
+}
+
+void EventLoopStatistics::updateWatchdog() {
+    bool needWatchdog = enabled_ && threshold_;
+    if (needWatchdog == static_cast<bool>(watchdog_)) {
+        cond_.notify_all();
+        return;
+    }
+    if (needWatchdog) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = false;
+        }
+        watchdog_ = std::make_unique<std::thread>(
+            &EventLoopStatistics::runWatchdog, this);
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+        }
+        cond_.notify_all();
+        watchdog_->join();
+        watchdog_.reset();
+    }
+}
+
+void EventLoopStatistics::runWatchdog() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!exit_) {
+        auto threshold = threshold_.load();
+        cond_.wait_for(lock, std::chrono::microseconds(
+                                 std::max<uint64_t>(threshold / 2, 1000)));
+        if (exit_ || stack_.empty() || reportedSerial_ == serial_) {
+            continue;
+        }
+        auto time = now(CLOCK_MONOTONIC) - stack_.back().second;
+        if (time > threshold) {
+            reportedSerial_ = serial_;
+            FCITX_WARN() << "Event loop is blocked by [" << stackString()
+                         << "] for " << time / 1000 << "ms.";
+        }
+    }
+}
+
 } // namespace fcitx
@@ -11,6 +11,7 @@
 #include <functional>
 #include <vector>
 #include <event2/event.h>
+#include "event_p.h"
 #include "log.h"
 #include "trackableobject.h"
 
@@ -94,6 +95,9 @@ public:
         return state_ == LibEventSourceEnableState::Oneshot;
     }
 
+    EventLoopStatistics *statistics_ = nullptr;
+    const EventSourceLabelPtr label_ = currentEventSourceLabel();
+
 protected:
     std::shared_ptr<event_base> eventBase_;
     UniqueCPtr<event, event_free> event_;
@@ -256,6 +260,7 @@ struct LibEventSourceExit final : public EventSource,
 
     LibEventSourceEnableState state_ = LibEventSourceEnableState::Oneshot;
     EventCallback callback_;
+    const EventSourceLabelPtr label_ = currentEventSourceLabel();
 };
 
 class EventLoopPrivate {
@@ -276,6 +281,7 @@ public:
 
     std::shared_ptr<event_base> event_;
     std::vector<TrackableObjectReference<LibEventSourceExit>> exitEvents_;
+    EventLoopStatistics statistics_;
 };
 
 EventLoop::EventLoop() : d_ptr(std::make_unique<EventLoopPrivate>()) {}
@@ -310,7 +316,9 @@ bool EventLoop::exec() {
                     if (event->isOneShot()) {
                         event->setEnabled(false);
                     }
-                    event->callback_(event);
+                    d->statistics_.dispatch(event->label_, [event]() {
+                        return event->callback_(event);
+                    });
                 } catch (const std::exception &e) {
                     // some abnormal things threw
                     abort();
@@ -337,7 +345,10 @@ void IOEventCallback(evutil_socket_t fd, short events, void *arg) {
         if (source->isOneShot()) {
             source->setEnabled(false);
         }
-        source->callback_(source, fd, LibEventFlagsToIOEventFlags(events));
+        source->statistics_->dispatch(source->label_, [&]() {
+            return source->callback_(source, fd,
+                                     LibEventFlagsToIOEventFlags(events));
+        });
     } catch (const std::exception &e) {
         // some abnormal things threw{
         FCITX_FATAL() << e.what();
@@ -349,6 +360,7 @@ std::unique_ptr<EventSourceIO> EventLoop::addIOEvent(int fd, IOEventFlags flags,
     FCITX_D();
     auto source = std::make_unique<LibEventSourceIO>(std::move(callback),
                                                      d->event_, fd, flags);
+    source->statistics_ = &d->statistics_;
     return source;
 }
 
@@ -361,7 +373,9 @@ void TimeEventCallback(evutil_socket_t, short, void *arg) {
         if (source->isOneShot()) {
             source->setEnabled(false);
         }
-        source->callback_(source, source->time());
+        source->statistics_->dispatch(source->label_, [source]() {
+            return source->callback_(source, source->time());
+        });
         if (sourceRef.isValid() && source->isEnabled()) {
             source->resetEvent();
         }
@@ -377,6 +391,7 @@ EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
     FCITX_D();
     auto source = std::make_unique<LibEventSourceTime>(
         std::move(callback), d->event_, usec, clock, accuracy);
+    source->statistics_ = &d->statistics_;
     return source;
 }
 
@@ -394,4 +409,29 @@ std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback) {
             return callback(source);
         });
 }
+
+void EventLoop::setStatisticsEnabled(bool enabled) {
+    FCITX_D();
+    d->statistics_.setEnabled(enabled);
+}
+
+bool EventLoop::statisticsEnabled() const {
+    FCITX_D();
+    return d->statistics_.enabled();
+}
+
+void EventLoop::setStallThreshold(uint64_t usec) {
+    FCITX_D();
+    d->statistics_.setStallThreshold(usec);
+}
+
+std::vector<EventSourceStatistics> EventLoop::statistics() const {
+    FCITX_D();
+    return d->statistics_.statistics();
+}
+
+void EventLoop::resetStatistics() {
+    FCITX_D();
+    d->statistics_.reset();
+}
 } // namespace fcitx
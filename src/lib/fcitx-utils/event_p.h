@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_EVENT_P_H_
+#define _FCITX_UTILS_EVENT_P_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "event.h"
+
+namespace fcitx {
+
+using EventSourceLabelPtr = std::shared_ptr<const std::string>;
+
+// Label for new event source.
+EventSourceLabelPtr currentEventSourceLabel();
+
+// Callback statistics shared by the event loop implementations.
+class EventLoopStatistics {
+    // Make the label of the source being dispatched the current label.
+    class DispatchScope {
+    public:
+        DispatchScope(EventSourceLabelPtr label);
+        ~DispatchScope();
+
+    private:
+        EventSourceLabelPtr previous_;
+    };
+
+public:
+    EventLoopStatistics() = default;
+    ~EventLoopStatistics();
+
+    // Run callback of a source with given label.
+    template <typename Callback>
+    auto dispatch(EventSourceLabelPtr label, Callback &&callback) {
+        DispatchScope scope(label);
+        if (!enabled_) {
+            return callback();
+        }
+        auto start = begin(label);
+        struct Finish {
+            ~Finish() { statistics_->end(label_, start_); }
+            EventLoopStatistics *statistics_;
+            const EventSourceLabelPtr &label_;
+            uint64_t start_;
+        } finish{this, label, start};
+        return callback();
+    }
+
+    bool enabled() const { return enabled_; }
+    void setEnabled(bool enabled);
+    void setStallThreshold(uint64_t usec);
+    std::vector<EventSourceStatistics> statistics() const;
+    void reset();
+
+private:
+    uint64_t begin(const EventSourceLabelPtr &label);
+    void end(const EventSourceLabelPtr &label, uint64_t start);
+    void updateWatchdog();
+    void runWatchdog();
+    std::string stackString() const;
+
+    bool enabled_ = false;
+    std::atomic<uint64_t> threshold_{0};
+    std::unordered_map<std::string, EventSourceStatistics> statistics_;
+
+    // Protect the fields below, which are read by the watchdog.
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    // Labels and start time of callbacks being dispatched, more than one if
+    // event loop is nested.
+    std::vector<std::pair<std::string, uint64_t>> stack_;
+    // Increased for every callback, so watchdog only reports it once.
+    uint64_t serial_ = 0;
+    uint64_t reportedSerial_ = 0;
+    bool exit_ = false;
+    std::unique_ptr<std::thread> watchdog_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_EVENT_P_H_
@@ -14,6 +14,7 @@
 #endif
 #include <systemd/sd-event.h>
 #include "event.h"
+#include "event_p.h"
 #include "log.h"
 
 namespace fcitx {
@@ -59,6 +60,9 @@ public:
 
     void setEventSource(sd_event_source *event) { eventSource_ = event; }
 
+    EventLoopStatistics *statistics_ = nullptr;
+    const EventSourceLabelPtr label_ = currentEventSourceLabel();
+
     bool isEnabled() const override {
         int result = 0, err;
         if ((err = sd_event_source_get_enabled(eventSource_, &result)) < 0) {
@@ -201,6 +205,7 @@ public:
 
     std::mutex mutex_;
     sd_event *event_;
+    EventLoopStatistics statistics_;
 };
 
 EventLoop::EventLoop() : d_ptr(std::make_unique<EventLoopPrivate>()) {}
@@ -233,7 +238,10 @@ int IOEventCallback(sd_event_source *, int fd, uint32_t revents,
     }
     try {
         auto result =
-            source->callback_(source, fd, EpollFlagsToIOEventFlags(revents));
+            source->statistics_->dispatch(source->label_, [&]() {
+                return source->callback_(source, fd,
+                                         EpollFlagsToIOEventFlags(revents));
+            });
         return result ? 0 : -1;
     } catch (const std::exception &e) {
         FCITX_FATAL() << e.what();
@@ -253,6 +261,7 @@ std::unique_ptr<EventSourceIO> EventLoop::addIOEvent(int fd, IOEventFlags flags,
         throw EventLoopException(err);
     }
     source->setEventSource(sdEventSource);
+    source->statistics_ = &d->statistics_;
     return source;
 }
 
@@ -262,7 +271,8 @@ int TimeEventCallback(sd_event_source *, uint64_t usec, void *userdata) {
         return 0;
     }
     try {
-        auto result = source->callback_(source, usec);
+        auto result = source->statistics_->dispatch(
+            source->label_, [&]() { return source->callback_(source, usec); });
         return result ? 0 : -1;
     } catch (const std::exception &e) {
         // some abnormal things threw
@@ -285,6 +295,7 @@ EventLoop::addTimeEvent(clockid_t clock, uint64_t usec, uint64_t accuracy,
         throw EventLoopException(err);
     }
     source->setEventSource(sdEventSource);
+    source->statistics_ = &d->statistics_;
     return source;
 }
 
@@ -294,7 +305,8 @@ int StaticEventCallback(sd_event_source *, void *userdata) {
         return 0;
     }
     try {
-        auto result = source->callback_(source);
+        auto result = source->statistics_->dispatch(
+            source->label_, [&]() { return source->callback_(source); });
         return result ? 0 : -1;
     } catch (const std::exception &e) {
         // some abnormal things threw
@@ -314,6 +326,7 @@ std::unique_ptr<EventSource> EventLoop::addExitEvent(EventCallback callback) {
         throw EventLoopException(err);
     }
     source->setEventSource(sdEventSource);
+    source->statistics_ = &d->statistics_;
     return source;
 }
 
@@ -327,6 +340,32 @@ std::unique_ptr<EventSource> EventLoop::addDeferEvent(EventCallback callback) {
         throw EventLoopException(err);
     }
     source->setEventSource(sdEventSource);
+    source->statistics_ = &d->statistics_;
     return source;
 }
+
+void EventLoop::setStatisticsEnabled(bool enabled) {
+    FCITX_D();
+    d->statistics_.setEnabled(enabled);
+}
+
+bool EventLoop::statisticsEnabled() const {
+    FCITX_D();
+    return d->statistics_.enabled();
+}
+
+void EventLoop::setStallThreshold(uint64_t usec) {
+    FCITX_D();
+    d->statistics_.setStallThreshold(usec);
+}
+
+std::vector<EventSourceStatistics> EventLoop::statistics() const {
+    FCITX_D();
+    return d->statistics_.statistics();
+}
+
+void EventLoop::resetStatistics() {
+    FCITX_D();
+    d->statistics_.reset();
+}
 } // namespace fcitx
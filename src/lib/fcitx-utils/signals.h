@@ -164,6 +164,9 @@ public:
         return Connection{body->watch()};
     }
 
+    /// Whether any slot is connected to this signal.
+    bool hasConnections() const { return !d_ptr->connections_.empty(); }
+
     void disconnectAll() {
         while (!d_ptr->connections_.empty()) {
             delete &d_ptr->connections_.front();
@@ -0,0 +1,295 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UTILS_TASK_H_
+#define _FCITX_UTILS_TASK_H_
+
+/// \addtogroup FcitxUtils
+/// \{
+/// \file
+/// \brief Chain asynchronous operations with continuations.
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <fcitx-utils/event.h>
+
+namespace fcitx {
+
+template <typename T>
+class Task;
+
+template <typename T>
+class TaskPromise;
+
+namespace details {
+
+template <typename T>
+using TaskValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <typename T>
+struct TaskNext {
+    using type = T;
+};
+
+template <typename T>
+struct TaskNext<Task<T>> {
+    using type = T;
+};
+
+template <typename T>
+struct IsTask : std::false_type {};
+
+template <typename T>
+struct IsTask<Task<T>> : std::true_type {};
+
+template <typename T, typename F>
+using TaskCallbackResult =
+    typename std::conditional_t<std::is_void_v<T>, std::invoke_result<F &>,
+                                std::invoke_result<F &, T>>::type;
+
+template <typename T, typename F>
+decltype(auto) invokeTaskCallback(F &callback, TaskValue<T> &value) {
+    if constexpr (std::is_void_v<T>) {
+        return callback();
+    } else {
+        return callback(std::move(value));
+    }
+}
+
+template <typename T>
+class TaskState {
+public:
+    using Value = TaskValue<T>;
+
+    void resolve(Value value) {
+        if (resolved_) {
+            return;
+        }
+        resolved_ = true;
+        if (continuation_) {
+            auto continuation = std::move(continuation_);
+            continuation_ = nullptr;
+            continuation(std::move(value));
+        } else {
+            value_.emplace(std::move(value));
+        }
+    }
+
+    void setContinuation(std::function<void(Value)> continuation) {
+        if (value_) {
+            auto value = std::move(*value_);
+            value_.reset();
+            continuation(std::move(value));
+        } else {
+            continuation_ = std::move(continuation);
+        }
+    }
+
+    bool resolved() const { return resolved_; }
+
+    // The pending operation or the previous task in the chain.
+    std::shared_ptr<void> resource_;
+
+private:
+    bool resolved_ = false;
+    std::optional<Value> value_;
+    std::function<void(Value)> continuation_;
+};
+
+} // namespace details
+
+/**
+ * Resolve the value of a Task.
+ *
+ * The promise does not keep the task alive. Resolving a task that has been
+ * destroyed, or resolving it more than once, does nothing.
+ *
+ * @since 5.0.14
+ */
+template <typename T>
+class TaskPromise {
+    friend class Task<T>;
+
+public:
+    TaskPromise() = default;
+
+    /// Resolve the task, Task<void> takes no argument.
+    template <typename... Args>
+    void resolve(Args &&...args) const {
+        if (auto state = state_.lock()) {
+            state->resolve(
+                details::TaskValue<T>(std::forward<Args>(args)...));
+        }
+    }
+
+    /// Check if the task is still alive.
+    bool isValid() const { return !state_.expired(); }
+
+private:
+    explicit TaskPromise(std::weak_ptr<details::TaskState<T>> state)
+        : state_(std::move(state)) {}
+
+    std::weak_ptr<details::TaskState<T>> state_;
+};
+
+/**
+ * A move-only handle of an asynchronous operation that produces a T.
+ *
+ * Continuations are attached with then(), which returns a new task for the
+ * chain. The last task owns the whole chain, destroying it cancels the
+ * pending operation and no continuation is called afterwards. Everything
+ * runs on the thread that resolves the promise, usually the event loop.
+ *
+ * @code
+ * task_ = dbus::callTask(msg, 1000000)
+ *             .then([](dbus::Message reply) { ... });
+ * @endcode
+ *
+ * @since 5.0.14
+ */
+template <typename T>
+class Task {
+    template <typename U>
+    friend class Task;
+
+public:
+    using value_type = T;
+
+    Task() : state_(std::make_shared<details::TaskState<T>>()) {}
+    Task(Task &&) noexcept = default;
+    Task &operator=(Task &&) noexcept = default;
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    /// Create a task that is already resolved.
+    template <typename... Args>
+    static Task ready(Args &&...args) {
+        Task task;
+        task.promise().resolve(std::forward<Args>(args)...);
+        return task;
+    }
+
+    /// Return the promise that resolves this task.
+    TaskPromise<T> promise() const { return TaskPromise<T>(state_); }
+
+    /// Check if the value is already produced.
+    bool isResolved() const { return state_ && state_->resolved(); }
+
+    /**
+     * Keep the object that carries the operation, e.g. dbus::Slot or
+     * EventSource, alive as long as the task.
+     */
+    void attach(std::shared_ptr<void> resource) {
+        state_->resource_ = std::move(resource);
+    }
+
+    /**
+     * Call callback with the value once it is resolved.
+     *
+     * If callback returns a Task, the returned task resolves with the value
+     * of that task. Otherwise it resolves with the return value of callback.
+     *
+     * @return task for the result of callback.
+     */
+    template <typename F>
+    auto then(F callback) && {
+        using Result = details::TaskCallbackResult<T, F>;
+        using Next = typename details::TaskNext<Result>::type;
+        Task<Next> next;
+        auto *upstream = state_.get();
+        // Keep upstream alive until it is resolved.
+        next.state_->resource_ = std::move(state_);
+        std::weak_ptr<details::TaskState<Next>> weakNext = next.state_;
+        // std::function need to be copyable, while callback may capture
+        // another task.
+        auto sharedCallback = std::make_shared<F>(std::move(callback));
+        upstream->setContinuation([weakNext, sharedCallback](
+                                      details::TaskValue<T> value) {
+            if (weakNext.expired()) {
+                return;
+            }
+            if constexpr (details::IsTask<Result>::value) {
+                auto inner =
+                    details::invokeTaskCallback<T>(*sharedCallback, value);
+                auto nextState = weakNext.lock();
+                if (!nextState) {
+                    return;
+                }
+                auto *innerState = inner.state_.get();
+                // Upstream is done, hold the inner task instead.
+                nextState->resource_ = std::move(inner.state_);
+                innerState->setContinuation(
+                    [weakNext](details::TaskValue<Next> innerValue) {
+                        if (auto state = weakNext.lock()) {
+                            state->resolve(std::move(innerValue));
+                        }
+                    });
+            } else if constexpr (std::is_void_v<Result>) {
+                details::invokeTaskCallback<T>(*sharedCallback, value);
+                if (auto nextState = weakNext.lock()) {
+                    nextState->resolve(std::monostate());
+                }
+            } else {
+                auto result =
+                    details::invokeTaskCallback<T>(*sharedCallback, value);
+                if (auto nextState = weakNext.lock()) {
+                    nextState->resolve(std::move(result));
+                }
+            }
+        });
+        return next;
+    }
+
+private:
+    std::shared_ptr<details::TaskState<T>> state_;
+};
+
+/**
+ * Create a task that resolves with the time when the one shot timer fires.
+ *
+ * @see EventLoop::addTimeEvent
+ * @since 5.0.14
+ */
+inline Task<uint64_t> timeTask(EventLoop &loop, clockid_t clock,
+                               uint64_t usec, uint64_t accuracy) {
+    Task<uint64_t> task;
+    task.attach(loop.addTimeEvent(
+        clock, usec, accuracy,
+        [promise = task.promise()](EventSourceTime *, uint64_t time) {
+            promise.resolve(time);
+            return true;
+        }));
+    return task;
+}
+
+/**
+ * Create a task that resolves with the returned events once fd is ready.
+ *
+ * @see EventLoop::addIOEvent
+ * @since 5.0.14
+ */
+inline Task<IOEventFlags> ioTask(EventLoop &loop, int fd,
+                                 IOEventFlags flags) {
+    Task<IOEventFlags> task;
+    task.attach(loop.addIOEvent(fd, flags,
+                                [promise = task.promise()](
+                                    EventSourceIO *source, int,
+                                    IOEventFlags revents) {
+                                    // Only the first event is needed.
+                                    source->setEnabled(false);
+                                    promise.resolve(revents);
+                                    return true;
+                                }));
+    return task;
+}
+
+} // namespace fcitx
+
+#endif // _FCITX_UTILS_TASK_H_
@@ -12,6 +12,9 @@ namespace fcitx {
 class AddonInstancePrivate {
 public:
     std::unordered_map<std::string, AddonFunctionAdaptorBase *> callbackMap_;
+    std::function<AddonMemoryUsage()> memoryUsageCallback_;
+    std::function<void()> trimMemoryCallback_;
+    std::function<AddonCacheStatistics()> cacheStatisticsCallback_;
 };
 
 AddonInstance::AddonInstance()
@@ -24,6 +27,46 @@ void AddonInstance::registerCallback(const std::string &name,
     d->callbackMap_[name] = adaptor;
 }
 
+AddonMemoryUsage AddonInstance::memoryUsage() const {
+    FCITX_D();
+    if (!d->memoryUsageCallback_) {
+        return {};
+    }
+    return d->memoryUsageCallback_();
+}
+
+void AddonInstance::trimMemory() {
+    FCITX_D();
+    if (d->trimMemoryCallback_) {
+        d->trimMemoryCallback_();
+    }
+}
+
+AddonCacheStatistics AddonInstance::cacheStatistics() const {
+    FCITX_D();
+    if (!d->cacheStatisticsCallback_) {
+        return {};
+    }
+    return d->cacheStatisticsCallback_();
+}
+
+void AddonInstance::setMemoryUsageCallback(
+    std::function<AddonMemoryUsage()> callback) {
+    FCITX_D();
+    d->memoryUsageCallback_ = std::move(callback);
+}
+
+void AddonInstance::setTrimMemoryCallback(std::function<void()> callback) {
+    FCITX_D();
+    d->trimMemoryCallback_ = std::move(callback);
+}
+
+void AddonInstance::setCacheStatisticsCallback(
+    std::function<AddonCacheStatistics()> callback) {
+    FCITX_D();
+    d->cacheStatisticsCallback_ = std::move(callback);
+}
+
 AddonFunctionAdaptorBase *AddonInstance::findCall(const std::string &name) {
     FCITX_D();
     auto iter = d->callbackMap_.find(name);
@@ -7,10 +7,14 @@
 #ifndef _FCITX_ADDONINSTANCE_H_
 #define _FCITX_ADDONINSTANCE_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <fcitx-config/configuration.h>
 #include <fcitx-utils/library.h>
 #include <fcitx-utils/metastring.h>
@@ -24,12 +28,19 @@
 
 namespace fcitx {
 
+/// Estimated memory usage of named data structures, in bytes.
+using AddonMemoryUsage = std::vector<std::pair<std::string, size_t>>;
+
+/// Counters of addon caches, e.g. how many times the data is released.
+using AddonCacheStatistics = std::vector<std::pair<std::string, uint64_t>>;
+
 /// \brief Base class for any addon in fcitx.
 /// To implement addon in fcitx, you will need to create a sub class for this
 /// class.
 ///
 /// To make an SharedLibrary Addon, you will also need to use
-/// FCITX_ADDON_FACTORY to export the factory for addon.
+/// FCITX_ADDON_FACTORY or FCITX_ADDON_FACTORY_V2 to export the factory for
+/// addon.
 ///
 ///  An addon can export several function to be invoked by other addons.
 /// When you need to do so, you will need some extra command in your
@@ -89,6 +100,35 @@ public:
     }
     virtual void setSubConfig(const std::string &, const RawConfig &) {}
 
+    /**
+     * Report the estimated memory used by major data structures of addon.
+     *
+     * It is only used for diagnosis, so it does not need to be exact. Returns
+     * empty value unless addon sets the callback with setMemoryUsageCallback.
+     *
+     * @since 5.0.14
+     */
+    AddonMemoryUsage memoryUsage() const;
+
+    /**
+     * Drop the data that can be rebuilt on demand.
+     *
+     * Does nothing unless addon sets the callback with setTrimMemoryCallback.
+     *
+     * @since 5.0.14
+     */
+    void trimMemory();
+
+    /**
+     * Report the statistics of caches, used for tuning of cache policy.
+     *
+     * Returns empty value unless addon sets the callback with
+     * setCacheStatisticsCallback.
+     *
+     * @since 5.0.14
+     */
+    AddonCacheStatistics cacheStatistics() const;
+
     template <typename Signature, typename... Args>
     typename std::function<Signature>::result_type
     callWithSignature(const std::string &name, Args &&...args) {
@@ -114,6 +154,28 @@ public:
     void registerCallback(const std::string &name,
                           AddonFunctionAdaptorBase *adaptor);
 
+    /**
+     * Set the function that implements memoryUsage.
+     *
+     * @since 5.0.14
+     */
+    void setMemoryUsageCallback(std::function<AddonMemoryUsage()> callback);
+
+    /**
+     * Set the function that implements trimMemory.
+     *
+     * @since 5.0.14
+     */
+    void setTrimMemoryCallback(std::function<void()> callback);
+
+    /**
+     * Set the function that implements cacheStatistics.
+     *
+     * @since 5.0.14
+     */
+    void
+    setCacheStatisticsCallback(std::function<AddonCacheStatistics()> callback);
+
 private:
     AddonFunctionAdaptorBase *findCall(const std::string &name);
     std::unique_ptr<AddonInstancePrivate> d_ptr;
@@ -156,6 +218,48 @@ private:
     }                                                                          \
     }
 
+/**
+ * Export the factory of addon with a symbol name that contains the addon
+ * name, so multiple addons can be linked into the same binary.
+ *
+ * SharedLibrary loader looks up this symbol before the one defined by
+ * FCITX_ADDON_FACTORY. The addon name must be a valid identifier.
+ *
+ * @see FCITX_IMPORT_ADDON_FACTORY
+ * @since 5.0.14
+ */
+#define FCITX_ADDON_FACTORY_V2(AddonName, ClassName)                           \
+    extern "C" {                                                               \
+    FCITXCORE_EXPORT                                                           \
+    ::fcitx::AddonFactory *fcitx_addon_factory_instance_##AddonName() {        \
+        static ClassName factory;                                              \
+        return &factory;                                                       \
+    }                                                                          \
+    }
+
+/**
+ * Add an addon exported by FCITX_ADDON_FACTORY_V2 and linked statically to a
+ * StaticAddonRegistry.
+ *
+ * Must be used at namespace scope, after the definition of registry in the
+ * same file.
+ *
+ * @since 5.0.14
+ */
+#define FCITX_IMPORT_ADDON_FACTORY(RegistryName, AddonName)                    \
+    extern "C" {                                                               \
+    ::fcitx::AddonFactory *fcitx_addon_factory_instance_##AddonName();         \
+    }                                                                          \
+    class StaticAddonRegistrar_##AddonName {                                   \
+    public:                                                                    \
+        StaticAddonRegistrar_##AddonName() {                                   \
+            (RegistryName)                                                     \
+                .emplace(#AddonName,                                           \
+                         fcitx_addon_factory_instance_##AddonName());          \
+        }                                                                      \
+    };                                                                         \
+    StaticAddonRegistrar_##AddonName staticAddonRegistrar_##AddonName
+
 /// A convenient macro to obtain the addon pointer of another addon.
 #define FCITX_ADDON_DEPENDENCY_LOADER(NAME, ADDONMANAGER)                      \
     auto NAME() {                                                              \
@@ -41,9 +41,9 @@ AddonInstance *SharedLibraryLoader::load(const AddonInfo &info,
                 continue;
             }
             try {
-                registry_.emplace(
-                    info.uniqueName(),
-                    std::make_unique<SharedLibraryFactory>(std::move(lib)));
+                registry_.emplace(info.uniqueName(),
+                                  std::make_unique<SharedLibraryFactory>(
+                                      info, std::move(lib)));
             } catch (const std::exception &e) {
             }
             break;
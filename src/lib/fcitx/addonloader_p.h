@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include "fcitx-utils/library.h"
 #include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
 #include "addonfactory.h"
 #include "addoninfo.h"
 #include "addoninstance.h"
@@ -19,8 +20,14 @@ namespace fcitx {
 
 class SharedLibraryFactory {
 public:
-    SharedLibraryFactory(Library lib) : library_(std::move(lib)) {
-        auto *funcPtr = library_.resolve("fcitx_addon_factory_instance");
+    SharedLibraryFactory(const AddonInfo &info, Library lib)
+        : library_(std::move(lib)) {
+        std::string v2Name = stringutils::concat(
+            "fcitx_addon_factory_instance_", info.uniqueName());
+        auto *funcPtr = library_.resolve(v2Name.c_str());
+        if (!funcPtr) {
+            funcPtr = library_.resolve("fcitx_addon_factory_instance");
+        }
         if (!funcPtr) {
             throw std::runtime_error(library_.error());
         }
@@ -10,7 +10,9 @@
 #include <unistd.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/log.h"
 #include "addonloader.h"
 #include "addonloader_p.h"
@@ -37,6 +39,11 @@ public:
 
     bool loaded() const { return !!instance_; }
 
+    // Loaded and usable by other addons.
+    bool ready() const { return loaded() && ready_; }
+
+    void setReady(bool ready) { ready_ = ready; }
+
     AddonInstance *instance() { return instance_.get(); }
 
     void setFailed(bool failed = true) { failed_ = failed; }
@@ -47,6 +54,7 @@ public:
 private:
     AddonInfo info_;
     bool failed_;
+    bool ready_ = true;
     std::unique_ptr<AddonInstance> instance_;
 };
 
@@ -88,8 +96,8 @@ public:
                 return DependencyCheckStatus::Failed;
             }
 
-            if (!dep->loaded()) {
-                if (dep->info().onDemand() &&
+            if (!dep->ready()) {
+                if (!dep->loaded() && dep->info().onDemand() &&
                     requested_.insert(dep->info().uniqueName()).second) {
                     return DependencyCheckStatus::PendingUpdateRequest;
                 }
@@ -105,7 +113,7 @@ public:
             }
 
             // otherwise wait for it
-            if (!dep->loaded() && !dep->info().onDemand()) {
+            if (!dep->ready() && (dep->loaded() || !dep->info().onDemand())) {
                 return DependencyCheckStatus::Pending;
             }
         }
@@ -134,7 +142,7 @@ public:
                     break;
                 }
             }
-        } while (changed);
+        } while (changed || std::exchange(readyChanged_, false));
         inLoadAddons_ = false;
     }
 
@@ -178,6 +186,8 @@ public:
         }
 
         if (auto *loader = findValue(loaders_, addon.info().type())) {
+            // Attribute the event sources created by addon to it.
+            EventSourceLabel label(addon.info().uniqueName());
             addon.instance_.reset((*loader)->load(addon.info(), q_ptr));
         } else {
             FCITX_ERROR() << "Failed to find addon loader for: "
@@ -196,6 +206,7 @@ public:
 
     bool unloading_ = false;
     bool inLoadAddons_ = false;
+    bool readyChanged_ = false;
 
     std::unordered_map<std::string, std::unique_ptr<Addon>> addons_;
     std::unordered_map<std::string, std::unique_ptr<AddonLoader>> loaders_;
@@ -327,9 +338,34 @@ AddonInstance *AddonManager::addon(const std::string &name, bool load) {
         d->requested_.insert(name);
         d->loadAddons(this);
     }
+    if (!addon->ready()) {
+        return nullptr;
+    }
     return addon->instance();
 }
 
+void AddonManager::deferAddonReady(const std::string &name) {
+    FCITX_D();
+    if (auto *addon = d->addon(name)) {
+        addon->setReady(false);
+    }
+}
+
+void AddonManager::setAddonReady(const std::string &name) {
+    FCITX_D();
+    auto *addon = d->addon(name);
+    if (!addon || addon->ready()) {
+        return;
+    }
+    addon->setReady(true);
+    if (d->inLoadAddons_) {
+        // Let the running loadAddons pick up the dependents.
+        d->readyChanged_ = true;
+    } else if (addon->loaded()) {
+        d->loadAddons(this);
+    }
+}
+
 const AddonInfo *AddonManager::addonInfo(const std::string &name) const {
     FCITX_D();
     auto *addon = d->addon(name);
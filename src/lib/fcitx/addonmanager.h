@@ -128,6 +128,29 @@ public:
     const AddonInfo *addonInfo(const std::string &name) const;
     std::unordered_set<std::string> addonNames(AddonCategory category);
 
+    /**
+     * Hold back the addons that depend on the given addon.
+     *
+     * It should be called from the constructor of the addon, when it needs
+     * to wait for something asynchronously before others can use it. Until
+     * setAddonReady is called, addon() returns nullptr for it, and addons
+     * depending on it are not loaded.
+     *
+     * @param name name of addon.
+     * @see setAddonReady
+     * @since 5.0.14
+     */
+    void deferAddonReady(const std::string &name);
+
+    /**
+     * Mark the addon as ready and load the addons depending on it.
+     *
+     * @param name name of addon.
+     * @see deferAddonReady
+     * @since 5.0.14
+     */
+    void setAddonReady(const std::string &name);
+
     /**
      * Return the fcitx instance when it is created by Fcitx.
      *
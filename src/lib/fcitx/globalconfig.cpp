@@ -176,6 +176,14 @@ FCITX_CONFIGURATION(
     HiddenOption<std::string>
 #endif
         customXkbOption{this, "CustomXkbOption", _("Custom Xkb Option"), ""};
+    Option<int, IntConstrain> idleCacheTimeout{
+        this, "IdleCacheTimeout",
+        _("Release unused addon data after minutes (0 to disable)"), 10,
+        IntConstrain(0, 1440)};
+    Option<int, IntConstrain> workerThreads{
+        this, "WorkerThreads",
+        _("Maximum number of worker threads (0 for automatic)"), 0,
+        IntConstrain(0, 64)};
     HiddenOption<std::vector<std::string>> enabledAddons{
         this, "EnabledAddons", "Force Enabled Addons"};
     HiddenOption<std::vector<std::string>> disabledAddons{
@@ -356,6 +364,16 @@ void GlobalConfig::setDisabledAddons(const std::vector<std::string> &addons) {
     d->behavior.mutableValue()->disabledAddons.setValue(addons);
 }
 
+int GlobalConfig::idleCacheTimeout() const {
+    FCITX_D();
+    return *d->behavior->idleCacheTimeout;
+}
+
+int GlobalConfig::workerThreads() const {
+    FCITX_D();
+    return *d->behavior->workerThreads;
+}
+
 bool GlobalConfig::preloadInputMethod() const {
     FCITX_D();
     return *d->behavior->preloadInputMethod;
@@ -76,6 +76,25 @@ public:
      */
     const std::string &customXkbOption() const;
 
+    /**
+     * Minutes before the data of an addon is released when not being used.
+     *
+     * Data like unicode or emoji tables is loaded again upon next use.
+     *
+     * @return timeout in minutes, 0 means never release.
+     * @since 5.0.14
+     */
+    int idleCacheTimeout() const;
+
+    /**
+     * Maximum number of threads of the worker pool.
+     *
+     * @return number of threads, 0 means decided by number of CPU.
+     * @see Instance::workerPool
+     * @since 5.0.14
+     */
+    int workerThreads() const;
+
     const std::vector<std::string> &enabledAddons() const;
     const std::vector<std::string> &disabledAddons() const;
 
@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_IDLECACHE_P_H_
+#define _FCITX_IDLECACHE_P_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/stringutils.h"
+#include "fcitx/addoninstance.h"
+#include "fcitx/globalconfig.h"
+#include "fcitx/instance.h"
+
+// Release the data of an addon after it is not used for
+// GlobalConfig::idleCacheTimeout minutes. The owner calls touch() whenever the
+// data is used, and is expected to load the data again transparently after it
+// is released.
+namespace fcitx {
+
+class IdleCacheReleaser {
+public:
+    // Return false if the data is still in use and can not be released now.
+    using ReleaseCallback = std::function<bool()>;
+
+    IdleCacheReleaser(Instance *instance, std::string name,
+                      ReleaseCallback release)
+        : instance_(instance), name_(std::move(name)),
+          release_(std::move(release)) {}
+
+    void touch() {
+        lastUse_ = now(CLOCK_MONOTONIC);
+        if (released_) {
+            released_ = false;
+            ++reloads_;
+        }
+        auto timeout = this->timeout();
+        if (!timeout) {
+            timer_.reset();
+            return;
+        }
+        // Timer is only moved forward when it fires, so touch stays cheap.
+        if (!timer_) {
+            timer_ = instance_->eventLoop().addTimeEvent(
+                CLOCK_MONOTONIC, lastUse_ + timeout, 1000000,
+                [this](EventSourceTime *source, uint64_t) {
+                    onTimeout(source);
+                    return true;
+                });
+        } else if (!timer_->isEnabled()) {
+            timer_->setTime(lastUse_ + timeout);
+            timer_->setOneShot();
+        }
+    }
+
+    /// Mark data as released by other means, e.g. AddonInstance::trimMemory.
+    void markReleased() { released_ = true; }
+
+    AddonCacheStatistics statistics() const {
+        return {{stringutils::concat(name_, ":evictions"), evictions_},
+                {stringutils::concat(name_, ":reloads"), reloads_},
+                {stringutils::concat(name_, ":busy"), busy_}};
+    }
+
+private:
+    uint64_t timeout() const {
+        // Addon may be loaded without instance, e.g. in test.
+        if (!instance_) {
+            return 0;
+        }
+        return static_cast<uint64_t>(
+                   instance_->globalConfig().idleCacheTimeout()) *
+               60 * 1000000;
+    }
+
+    void onTimeout(EventSourceTime *source) {
+        auto timeout = this->timeout();
+        if (!timeout || released_) {
+            return;
+        }
+        auto current = now(CLOCK_MONOTONIC);
+        if (current < lastUse_ + timeout) {
+            source->setTime(lastUse_ + timeout);
+            source->setOneShot();
+            return;
+        }
+        if (!release_()) {
+            ++busy_;
+            source->setTime(current + timeout);
+            source->setOneShot();
+            return;
+        }
+        released_ = true;
+        ++evictions_;
+    }
+
+    Instance *instance_;
+    std::string name_;
+    ReleaseCallback release_;
+    std::unique_ptr<EventSourceTime> timer_;
+    uint64_t lastUse_ = 0;
+    bool released_ = false;
+    uint64_t evictions_ = 0;
+    uint64_t reloads_ = 0;
+    uint64_t busy_ = 0;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_IDLECACHE_P_H_
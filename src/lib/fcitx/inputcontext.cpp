@@ -13,6 +13,7 @@
 #include "focusgroup.h"
 #include "inputcontext_p.h"
 #include "inputcontextmanager.h"
+#include "inputcontextproperty_p.h"
 #include "instance.h"
 #include "misc_p.h"
 
@@ -89,6 +90,13 @@ InputContext::property(const InputContextPropertyFactory *factory) {
     return d->manager_.property(*this, factory);
 }
 
+bool InputContext::hasProperty(
+    const InputContextPropertyFactory *factory) const {
+    FCITX_D();
+    assert(factory->d_func()->manager_ == &d->manager_);
+    return d->property(factory->d_func()->slot_);
+}
+
 void InputContext::updateProperty(const std::string &name) {
     FCITX_D();
     auto *factory = d->manager_.factoryForName(name);
@@ -203,6 +203,16 @@ public:
     /// Returns the input context property by factory.
     InputContextProperty *property(const InputContextPropertyFactory *factory);
 
+    /**
+     * Check whether the property of given factory is already created.
+     *
+     * Properties are created on the first access, so this can be used to skip
+     * input contexts that never use it, without creating it.
+     *
+     * @since 5.0.14
+     */
+    bool hasProperty(const InputContextPropertyFactory *factory) const;
+
     /// Returns the associated input panel.
     InputPanel &inputPanel();
 
@@ -64,6 +64,9 @@ public:
         }
     }
 
+    // Slots of properties that are not created yet are null.
+    void initProperties(size_t size) { properties_.resize(size); }
+
     void registerProperty(int slot, InputContextProperty *property) {
         if (slot < 0) {
             return;
@@ -133,7 +136,9 @@ public:
         blockedEvents_.clear();
     }
 
-    InputContextProperty *property(int slot) { return properties_[slot].get(); }
+    InputContextProperty *property(int slot) const {
+        return properties_[slot].get();
+    }
 
     InputContextManager &manager_;
     FocusGroup *group_;
@@ -89,9 +89,9 @@ public:
         factory->name_ = name;
 
         propertyFactoriesSlots_.push_back(factory);
+        // Only reserve the slot, property is created on first access.
         for (auto &inputContext : inputContexts_) {
-            inputContext.d_func()->registerProperty(
-                factory->slot_, factory->q_func()->create(inputContext));
+            inputContext.d_func()->registerProperty(factory->slot_, nullptr);
         }
         return true;
     }
@@ -129,36 +129,46 @@ public:
         if (!inputContext.program().empty()) {
             programMap_[inputContext.program()].insert(&inputContext);
         }
-        for (auto &p : propertyFactories_) {
-            auto *property = p.second->q_func()->create(inputContext);
-            inputContext.d_func()->registerProperty(p.second->slot_, property);
-            if (property->needCopy() &&
-                (propertyPropagatePolicy_ == PropertyPropagatePolicy::All ||
-                 (!inputContext.program().empty() &&
-                  propertyPropagatePolicy_ ==
-                      PropertyPropagatePolicy::Program))) {
-                auto copyProperty = [&p, &inputContext,
-                                     &property](auto &container) {
-                    for (auto &dstInputContext : container) {
-                        if (toInputContextPointer(dstInputContext) !=
-                            &inputContext) {
-                            toInputContextPointer(dstInputContext)
-                                ->property(p.first)
-                                ->copyTo(property);
-                            break;
-                        }
-                    }
-                };
-                if (propertyPropagatePolicy_ == PropertyPropagatePolicy::All) {
-                    copyProperty(inputContexts_);
-                } else {
-                    auto iter = programMap_.find(inputContext.program());
-                    if (iter != programMap_.end()) {
-                        copyProperty(iter->second);
-                    }
+        // Properties are created on first access, see createProperty.
+        inputContext.d_func()->initProperties(propertyFactoriesSlots_.size());
+    }
+
+    InputContextProperty *
+    createProperty(InputContext &inputContext,
+                   InputContextPropertyFactoryPrivate *factory) {
+        auto *property = factory->q_func()->create(inputContext);
+        inputContext.d_func()->registerProperty(factory->slot_, property);
+        if (!property->needCopy() ||
+            propertyPropagatePolicy_ == PropertyPropagatePolicy::No ||
+            (inputContext.program().empty() &&
+             propertyPropagatePolicy_ == PropertyPropagatePolicy::Program)) {
+            return property;
+        }
+        // Propagation creates the property in the whole scope, so any input
+        // context that already has it holds the latest propagated value.
+        auto copyProperty = [factory, &inputContext,
+                             property](auto &container) {
+            for (auto &srcInputContext : container) {
+                auto *src = toInputContextPointer(srcInputContext);
+                if (src == &inputContext) {
+                    continue;
+                }
+                if (auto *srcProperty =
+                        src->d_func()->property(factory->slot_)) {
+                    srcProperty->copyTo(property);
+                    break;
                 }
             }
+        };
+        if (propertyPropagatePolicy_ == PropertyPropagatePolicy::All) {
+            copyProperty(inputContexts_);
+        } else {
+            auto iter = programMap_.find(inputContext.program());
+            if (iter != programMap_.end()) {
+                copyProperty(iter->second);
+            }
         }
+        return property;
     }
 
     std::unordered_map<ICUUID, InputContext *, container_hasher> uuidMap_;
@@ -331,9 +341,15 @@ InputContextManager::factoryForName(const std::string &name) {
 InputContextProperty *
 InputContextManager::property(InputContext &inputContext,
                               const InputContextPropertyFactory *factory) {
+    FCITX_D();
     assert(factory->d_func()->manager_ == this);
-    return InputContextManagerPrivate::toInputContextPrivate(inputContext)
-        ->property(factory->d_func()->slot_);
+    auto slot = factory->d_func()->slot_;
+    if (auto *property =
+            InputContextManagerPrivate::toInputContextPrivate(inputContext)
+                ->property(slot)) {
+        return property;
+    }
+    return d->createProperty(inputContext, d->propertyFactoriesSlots_[slot]);
 }
 
 void InputContextManager::propagateProperty(
@@ -353,6 +369,9 @@ void InputContextManager::propagateProperty(
         for (auto &dstInputContext_ : container) {
             if (const auto *factory = factoryRef.get()) {
                 auto dstInputContext = toInputContextPointer(dstInputContext_);
+                // Also create the property for those do not have it yet,
+                // otherwise the value is lost once all the input contexts
+                // having it are destroyed.
                 if (dstInputContext != &inputContext) {
                     property->copyTo(this->property(*dstInputContext, factory));
                 }
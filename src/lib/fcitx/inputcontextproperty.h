@@ -27,6 +27,7 @@ class InputContextPropertyFactoryPrivate;
 
 class FCITXCORE_EXPORT InputContextPropertyFactory
     : public fcitx::TrackableObject<InputContextPropertyFactory> {
+    friend class InputContext;
     friend class InputContextManager;
 
 public:
@@ -10,11 +10,13 @@
 #include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <cstring>
 #include <stdexcept>
 #include <utility>
 #include <fmt/format.h>
 #include <getopt.h>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/diskcache.h"
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/log.h"
@@ -32,7 +34,10 @@
 #include "inputmethodmanager.h"
 #include "instance.h"
 #include "misc_p.h"
+#include "programstate_p.h"
+#include "restartstate_p.h"
 #include "userinterfacemanager.h"
+#include "workerpool.h"
 
 #ifdef ENABLE_X11
 #include <../modules/xcb/xcb_public.h>
@@ -163,6 +168,15 @@ struct InputState : public InputContextProperty {
     void setActive(bool active);
     void setLocalIM(const std::string &localIM);
 
+    ProgramState programState() const {
+        return {active_, ic_->isPreeditEnabled(), localIM_};
+    }
+    void restoreProgramState(const ProgramState &state) {
+        setActive(state.active);
+        setLocalIM(state.localIM);
+        ic_->setEnablePreedit(state.preeditEnabled);
+    }
+
     CheckInputMethodChanged *imChanged_ = nullptr;
     int keyReleased_ = -1;
     Key lastKeyPressed_;
@@ -247,6 +261,10 @@ struct InstanceArgument {
             << "\t\t\t\t\tkey_trace - print the key event received by fcitx.\n"
             << "\t\t\t\t\t\"*\" may be used to represent all logging "
                "category.\n"
+            << "  --stall-threshold <ms>\tRecord time spent in event "
+               "callbacks, and warn\n"
+            << "\t\t\t\tabout callbacks that take longer than the "
+               "threshold.\n"
             << "  -u, --ui <addon name>\t\tSet the UI addon to be used.\n"
             << "  -d\t\t\t\tRun as a daemon.\n"
             << "  -D\t\t\t\tDo not run as a daemon (default).\n"
@@ -259,6 +277,7 @@ struct InstanceArgument {
     }
 
     int overrideDelay = -1;
+    int stallThreshold = 0;
     bool tryReplace = false;
     bool quietQuit = false;
     bool runAsDaemon = false;
@@ -360,6 +379,9 @@ public:
 
     void buildDefaultGroup();
 
+    UnixFD saveRestartStates();
+    void restoreKeymaps();
+
     void showInputMethodInformation(InputContext *ic) {
         FCITX_Q();
         auto *inputState = ic->propertyFor(&inputStateFactory_);
@@ -449,6 +471,29 @@ public:
         inputState->pendingGroupIndex_ = 0;
     }
 
+    void saveProgramState(InputContext *ic) {
+        if (!programStates_.isOpen() ||
+            globalConfig_.shareInputState() !=
+                PropertyPropagatePolicy::Program) {
+            return;
+        }
+        auto *inputState = ic->propertyFor(&inputStateFactory_);
+        programStates_.update(ic->program(), inputState->programState());
+    }
+
+    void restoreProgramState(InputContext *ic) {
+        if (!programStates_.isOpen() ||
+            globalConfig_.shareInputState() !=
+                PropertyPropagatePolicy::Program ||
+            ic->program().empty()) {
+            return;
+        }
+        if (auto state = programStates_.find(ic->program())) {
+            auto *inputState = ic->propertyFor(&inputStateFactory_);
+            inputState->restoreProgramState(*state);
+        }
+    }
+
     InstanceArgument arg_;
 
     int signalPipe_ = -1;
@@ -463,6 +508,7 @@ public:
     InputMethodManager imManager_{&this->addonManager_};
     UserInterfaceManager uiManager_{&this->addonManager_};
     GlobalConfig globalConfig_;
+    WorkerPool workerPool_{&eventLoop_};
     std::unordered_map<EventType,
                        std::unordered_map<EventWatcherPhase,
                                           HandlerTable<EventHandler>, EnumHash>,
@@ -475,6 +521,10 @@ public:
     uint64_t idleStartTimestamp_ = now(CLOCK_MONOTONIC);
     std::unique_ptr<EventSourceTime> periodicalSave_;
 
+    // Last known input state of programs, used to restore the state when a
+    // program creates a new input context with ShareInputState=Program.
+    ProgramStateStore programStates_;
+
     FCITX_DEFINE_SIGNAL_PRIVATE(Instance, CommitFilter);
     FCITX_DEFINE_SIGNAL_PRIVATE(Instance, OutputFilter);
     FCITX_DEFINE_SIGNAL_PRIVATE(Instance, KeyEventResult);
@@ -505,6 +555,10 @@ public:
         xkbParams_;
 
     bool restart_ = false;
+    MultiHandlerTable<std::string, RestartStateCallback> restartStateCallbacks_;
+    // State saved by the process before restart, only kept during
+    // initialization.
+    RestartStates restartStates_;
 
     AddonInstance *notifications_ = nullptr;
 
@@ -624,6 +678,107 @@ CheckInputMethodChanged::~CheckInputMethodChanged() {
     }
 }
 
+UnixFD InstancePrivate::saveRestartStates() {
+    RestartStates states;
+    for (const auto &name : restartStateCallbacks_.keys()) {
+        // Use the most recently added one if there are multiple.
+        for (const auto &callback : restartStateCallbacks_.view(name)) {
+            states[name] = callback();
+        }
+    }
+    states["group"] = imManager_.currentGroup().name();
+#ifdef ENABLE_KEYBOARD
+    // Compiling keymap from names is slow, pass the compiled ones so the new
+    // process doesn't need to do it again on first key event.
+    DiskCacheWriter writer;
+    writer.writeUInt32(globalConfig_.overrideXkbOption());
+    writer.writeString(globalConfig_.customXkbOption());
+    writer.writeUInt32(xkbParams_.size());
+    for (const auto &[display, param] : xkbParams_) {
+        writer.writeString(display);
+        writer.writeString(std::get<0>(param));
+        writer.writeString(std::get<1>(param));
+        writer.writeString(std::get<2>(param));
+    }
+    std::vector<std::tuple<const std::string *, const std::string *,
+                           UniqueCPtr<char>>>
+        keymaps;
+    for (const auto &[display, displayKeymaps] : keymapCache_) {
+        for (const auto &[layoutAndVariant, keymap] : displayKeymaps) {
+            if (!keymap) {
+                continue;
+            }
+            UniqueCPtr<char> keymapString(xkb_keymap_get_as_string(
+                keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1));
+            if (keymapString) {
+                keymaps.emplace_back(&display, &layoutAndVariant,
+                                     std::move(keymapString));
+            }
+        }
+    }
+    writer.writeUInt32(keymaps.size());
+    for (const auto &[display, layoutAndVariant, keymapString] : keymaps) {
+        writer.writeString(*display);
+        writer.writeString(*layoutAndVariant);
+        writer.writeString(keymapString.get());
+    }
+    states["keymap"] = writer.data();
+#endif
+    return writeRestartState(states);
+}
+
+void InstancePrivate::restoreKeymaps() {
+#ifdef ENABLE_KEYBOARD
+    const auto *state = findValue(restartStates_, "keymap");
+    if (!state || !xkbContext_) {
+        return;
+    }
+    DiskCacheReader reader(*state);
+    uint32_t overrideXkbOption;
+    std::string customXkbOption;
+    uint32_t size;
+    if (!reader.readUInt32(overrideXkbOption) ||
+        !reader.readString(customXkbOption) || !reader.readUInt32(size)) {
+        return;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        std::string display;
+        std::tuple<std::string, std::string, std::string> param;
+        if (!reader.readString(display) ||
+            !reader.readString(std::get<0>(param)) ||
+            !reader.readString(std::get<1>(param)) ||
+            !reader.readString(std::get<2>(param))) {
+            return;
+        }
+        xkbParams_[display] = std::move(param);
+    }
+    // Keymaps are compiled with the option override from config.
+    if (static_cast<bool>(overrideXkbOption) !=
+            globalConfig_.overrideXkbOption() ||
+        customXkbOption != globalConfig_.customXkbOption() ||
+        !reader.readUInt32(size)) {
+        return;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        std::string display;
+        std::string layoutAndVariant;
+        std::string keymapString;
+        if (!reader.readString(display) ||
+            !reader.readString(layoutAndVariant) ||
+            !reader.readString(keymapString)) {
+            return;
+        }
+        UniqueCPtr<xkb_keymap, xkb_keymap_unref> keymap(
+            xkb_keymap_new_from_string(xkbContext_.get(), keymapString.data(),
+                                       XKB_KEYMAP_FORMAT_TEXT_V1,
+                                       XKB_KEYMAP_COMPILE_NO_FLAGS));
+        if (keymap) {
+            keymapCache_[display][layoutAndVariant] = std::move(keymap);
+        }
+    }
+#endif
+}
+
 void InstancePrivate::buildDefaultGroup() {
     /// Figure out XKB layout information from system.
     auto *defaultGroup = q_func()->defaultFocusGroup();
@@ -777,6 +932,10 @@ Instance::Instance(int argc, char **argv) {
     d_ptr.reset(new InstancePrivate(this));
     FCITX_D();
     d->arg_ = arg;
+    if (arg.stallThreshold > 0) {
+        d->eventLoop_.setStatisticsEnabled(true);
+        d->eventLoop_.setStallThreshold(arg.stallThreshold * 1000ULL);
+    }
     d->addonManager_.setInstance(this);
     d->icManager_.setInstance(this);
     d->connections_.emplace_back(
@@ -972,6 +1131,7 @@ Instance::Instance(int argc, char **argv) {
                 keyEvent.key().checkKeyList(
                     d->globalConfig_.togglePreeditKeys())) {
                 ic->setEnablePreedit(!ic->isPreeditEnabled());
+                d->saveProgramState(ic);
                 if (d->notifications_) {
                     d->notifications_->call<INotifications::showTip>(
                         "toggle-preedit", _("Input Method"), "", _("Preedit"),
@@ -1197,6 +1357,7 @@ Instance::Instance(int argc, char **argv) {
             auto &icEvent =
                 static_cast<InputContextSwitchInputMethodEvent &>(event);
             auto *ic = icEvent.inputContext();
+            d->saveProgramState(ic);
             if (!ic->hasFocus()) {
                 return;
             }
@@ -1247,10 +1408,17 @@ Instance::Instance(int argc, char **argv) {
                 d->uiUpdateEvent_->setOneShot();
             }
         }));
+    d->eventWatchers_.emplace_back(d->watchEvent(
+        EventType::InputContextCreated, EventWatcherPhase::ReservedFirst,
+        [d](Event &event) {
+            auto &icEvent = static_cast<InputContextEvent &>(event);
+            d->restoreProgramState(icEvent.inputContext());
+        }));
     d->eventWatchers_.emplace_back(d->watchEvent(
         EventType::InputContextDestroyed, EventWatcherPhase::ReservedFirst,
         [d](Event &event) {
             auto &icEvent = static_cast<InputContextEvent &>(event);
+            d->saveProgramState(icEvent.inputContext());
             d->uiManager_.expire(icEvent.inputContext());
         }));
     d->uiUpdateEvent_ = d->eventLoop_.addDeferEvent([d](EventSource *) {
@@ -1301,6 +1469,8 @@ void InstanceArgument::parseOption(int argc, char **argv) {
     struct option longOptions[] = {{"enable", required_argument, nullptr, 0},
                                    {"disable", required_argument, nullptr, 0},
                                    {"verbose", required_argument, nullptr, 0},
+                                   {"stall-threshold", required_argument,
+                                    nullptr, 0},
                                    {"keep", no_argument, nullptr, 'k'},
                                    {"ui", required_argument, nullptr, 'u'},
                                    {"replace", no_argument, nullptr, 'r'},
@@ -1324,6 +1494,9 @@ void InstanceArgument::parseOption(int argc, char **argv) {
             case 2:
                 Log::setLogRule(optarg);
                 break;
+            case 3:
+                stallThreshold = std::atoi(optarg);
+                break;
             default:
                 quietQuit = true;
                 printUsage();
@@ -1409,7 +1582,19 @@ void Instance::initialize() {
     if (!d->arg_.uiName.empty()) {
         d->arg_.enableList.push_back(d->arg_.uiName);
     }
+    if (const char *stateFd = getenv(restartStateEnv)) {
+        UnixFD fd;
+        try {
+            fd.give(std::stoi(stateFd));
+        } catch (const std::exception &) {
+        }
+        unsetenv(restartStateEnv);
+        if (fd.isValid()) {
+            d->restartStates_ = readRestartState(fd.fd());
+        }
+    }
     reloadConfig();
+    d->restoreKeymaps();
     std::unordered_set<std::string> enabled;
     std::unordered_set<std::string> disabled;
     std::tie(enabled, disabled) = d->overrideAddons();
@@ -1420,6 +1605,10 @@ void Instance::initialize() {
         return;
     }
     d->imManager_.load([d](InputMethodManager &) { d->buildDefaultGroup(); });
+    if (const auto &group = restartState("group");
+        !group.empty() && d->imManager_.group(group)) {
+        d->imManager_.setCurrentGroup(group);
+    }
     d->uiManager_.load(d->arg_.uiName);
 
     const auto *entry = d->imManager_.entry("keyboard-us");
@@ -1452,6 +1641,11 @@ void Instance::initialize() {
         FCITX_D();
         save();
         if (d->restart_) {
+            auto stateFd = d->saveRestartStates();
+            if (stateFd.isValid()) {
+                setenv(restartStateEnv, std::to_string(stateFd.fd()).data(),
+                       1);
+            }
             auto fcitxBinary = StandardPath::fcitxPath("bindir", "fcitx5");
             std::vector<char> command{fcitxBinary.begin(), fcitxBinary.end()};
             command.push_back('\0');
@@ -1463,6 +1657,8 @@ void Instance::initialize() {
         return false;
     });
     d->notifications_ = d->addonManager_.addon("notifications", true);
+    // Addons that are loaded on demand won't see the state anyway.
+    d->restartStates_.clear();
 }
 
 int Instance::exec() {
@@ -1497,6 +1693,11 @@ EventLoop &Instance::eventLoop() {
     return d->eventLoop_;
 }
 
+WorkerPool &Instance::workerPool() {
+    FCITX_D();
+    return d->workerPool_;
+}
+
 InputContextManager &Instance::inputContextManager() {
     FCITX_D();
     return d->icManager_;
@@ -1905,10 +2106,21 @@ void Instance::reloadConfig() {
     RawConfig config;
     readFromIni(config, file.fd());
     d->globalConfig_.load(config);
+    d->workerPool_.setMaxThreads(d->globalConfig_.workerThreads());
     FCITX_DEBUG() << "Trigger Key: "
                   << Key::keyListToString(d->globalConfig_.triggerKeys());
     d->icManager_.setPropertyPropagatePolicy(
         d->globalConfig_.shareInputState());
+    if (d->globalConfig_.shareInputState() ==
+            PropertyPropagatePolicy::Program &&
+        !d->programStates_.isOpen()) {
+        // Without a user directory, the state is only kept in memory.
+        auto path = standardPath.userDirectory(StandardPath::Type::PkgData);
+        if (!path.empty()) {
+            path = stringutils::joinPath(path, "program_state");
+        }
+        d->programStates_.open(path);
+    }
     if (d->globalConfig_.preeditEnabledByDefault() !=
         d->icManager_.isPreeditEnabledByDefault()) {
         d->icManager_.setPreeditEnabledByDefault(
@@ -1921,8 +2133,11 @@ void Instance::reloadConfig() {
 #ifdef ENABLE_KEYBOARD
     d->keymapCache_.clear();
     d->icManager_.foreach([d](InputContext *ic) {
-        auto *inputState = ic->propertyFor(&d->inputStateFactory_);
-        inputState->resetXkbState();
+        // Newly created state will use the new keymap.
+        if (ic->hasProperty(&d->inputStateFactory_)) {
+            auto *inputState = ic->propertyFor(&d->inputStateFactory_);
+            inputState->resetXkbState();
+        }
         return true;
     });
 #endif
@@ -1939,6 +2154,22 @@ void Instance::restart() {
     exit();
 }
 
+std::unique_ptr<HandlerTableEntry<RestartStateCallback>>
+Instance::addRestartStateCallback(const std::string &name,
+                                  RestartStateCallback callback) {
+    FCITX_D();
+    return d->restartStateCallbacks_.add(name, std::move(callback));
+}
+
+const std::string &Instance::restartState(const std::string &name) const {
+    FCITX_D();
+    static const std::string empty;
+    if (const auto *state = findValue(d->restartStates_, name)) {
+        return *state;
+    }
+    return empty;
+}
+
 void Instance::setCurrentInputMethod(const std::string &name) {
     if (auto *ic = lastFocusedInputContext()) {
         setCurrentInputMethod(ic, name, false);
@@ -2194,17 +2425,25 @@ bool Instance::enumerate(InputContext *ic, bool forward) {
 
 std::string Instance::commitFilter(InputContext *inputContext,
                                    const std::string &orig) {
+    if (!hasConnections<Instance::CommitFilter>()) {
+        return orig;
+    }
     std::string result = orig;
     emit<Instance::CommitFilter>(inputContext, result);
     return result;
 }
 
 Text Instance::outputFilter(InputContext *inputContext, const Text &orig) {
-    Text result = orig;
-    emit<Instance::OutputFilter>(inputContext, result);
-    if ((&orig == &inputContext->inputPanel().clientPreedit() ||
+    const bool maskPassword =
+        (&orig == &inputContext->inputPanel().clientPreedit() ||
          &orig == &inputContext->inputPanel().preedit()) &&
-        inputContext->capabilityFlags().test(CapabilityFlag::Password)) {
+        inputContext->capabilityFlags().test(CapabilityFlag::Password);
+    // Text shares the segments with orig, so this does not copy any string.
+    Text result = orig;
+    if (hasConnections<Instance::OutputFilter>()) {
+        emit<Instance::OutputFilter>(inputContext, result);
+    }
+    if (maskPassword) {
         Text newText;
         for (int i = 0, e = result.size(); i < e; i++) {
             auto length = utf8::length(result.stringAt(i));
@@ -2407,8 +2646,9 @@ void Instance::setXkbParameters(const std::string &display,
     if (resetState) {
         d->keymapCache_[display].clear();
         d->icManager_.foreach([d, &display](InputContext *ic) {
-            if (ic->display() == display ||
-                d->xkbParams_.count(ic->display()) == 0) {
+            if (ic->hasProperty(&d->inputStateFactory_) &&
+                (ic->display() == display ||
+                 d->xkbParams_.count(ic->display()) == 0)) {
                 auto *inputState = ic->propertyFor(&d->inputStateFactory_);
                 inputState->resetXkbState();
             }
@@ -2431,6 +2671,38 @@ void Instance::updateXkbStateMask(const std::string &display,
         std::make_tuple(depressed_mods, latched_mods, locked_mods);
 }
 
+AddonMemoryUsage Instance::memoryUsage() const {
+    AddonMemoryUsage usage;
+#ifdef ENABLE_KEYBOARD
+    FCITX_D();
+    size_t keymapCache = 0;
+    for (const auto &[display, displayKeymaps] : d->keymapCache_) {
+        for (const auto &[layoutAndVariant, keymap] : displayKeymaps) {
+            if (!keymap) {
+                continue;
+            }
+            // The size of text form is close enough to the compiled one.
+            UniqueCPtr<char> keymapString(xkb_keymap_get_as_string(
+                keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1));
+            if (keymapString) {
+                keymapCache += strlen(keymapString.get());
+            }
+        }
+    }
+    usage.emplace_back("keymapCache", keymapCache);
+#endif
+    return usage;
+}
+
+void Instance::trimMemory() {
+#ifdef ENABLE_KEYBOARD
+    FCITX_D();
+    // Keymaps that are still used are referenced by the xkb_state of input
+    // context, so they are only freed when they are not used anymore.
+    d->keymapCache_.clear();
+#endif
+}
+
 const char *Instance::version() { return FCITX_VERSION_STRING; }
 
 } // namespace fcitx
@@ -11,6 +11,7 @@
 #include <fcitx-utils/connectableobject.h>
 #include <fcitx-utils/handlertable.h>
 #include <fcitx-utils/macros.h>
+#include <fcitx/addoninstance.h>
 #include <fcitx/event.h>
 #include <fcitx/globalconfig.h>
 #include <fcitx/text.h>
@@ -32,8 +33,10 @@ class InputMethodEntry;
 class UserInterfaceManager;
 class GlobalConfig;
 class FocusGroup;
+class WorkerPool;
 
 typedef std::function<void(Event &event)> EventHandler;
+typedef std::function<std::string()> RestartStateCallback;
 
 /**
  * The event handling phase of event pipeline.
@@ -169,6 +172,13 @@ public:
     /// Get the global config.
     GlobalConfig &globalConfig();
 
+    /**
+     * Get the worker thread pool shared by addons.
+     *
+     * @since 5.0.14
+     */
+    WorkerPool &workerPool();
+
     // TODO: Merge this when we can break API.
     bool postEvent(Event &event);
     bool postEvent(Event &&event) { return postEvent(event); }
@@ -428,6 +438,22 @@ public:
      */
     bool checkUpdate() const;
 
+    /**
+     * Report the estimated memory used by caches of fcitx itself.
+     *
+     * @see AddonInstance::memoryUsage
+     * @since 5.0.14
+     */
+    AddonMemoryUsage memoryUsage() const;
+
+    /**
+     * Drop the caches of fcitx itself that can be rebuilt on demand.
+     *
+     * @see AddonInstance::trimMemory
+     * @since 5.0.14
+     */
+    void trimMemory();
+
     /// Return the version string of Fcitx.
     static const char *version();
 
@@ -464,6 +490,36 @@ public:
      */
     bool isRunning() const;
 
+    /**
+     * Add a callback to save state that should be kept by Instance::restart.
+     *
+     * The callback is invoked right before the new process is executed. The
+     * returned data can be read from the new process with restartState during
+     * initialization. Addon name is a good choice of the name.
+     *
+     * @param name unique name of the state.
+     * @param callback callback function that returns the serialized state.
+     * @return Handle to the callback, the callback will be removed when it is
+     * deleted.
+     * @since 5.0.14
+     */
+    FCITX_NODISCARD std::unique_ptr<HandlerTableEntry<RestartStateCallback>>
+    addRestartStateCallback(const std::string &name,
+                            RestartStateCallback callback);
+
+    /**
+     * Return the state saved by the process before restart.
+     *
+     * The state is only available during initialize(), so it should be read
+     * from the constructor of addon. Return empty string if there is no such
+     * state.
+     *
+     * @param name name of the state.
+     * @see addRestartStateCallback
+     * @since 5.0.14
+     */
+    const std::string &restartState(const std::string &name) const;
+
 private:
     void handleSignal();
 
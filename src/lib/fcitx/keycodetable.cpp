@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "config.h"
+
+#include "keycodetable.h"
+#include <unordered_map>
+#include <vector>
+#include "fcitx-utils/misc.h"
+
+#ifdef ENABLE_KEYBOARD
+#include <xkbcommon/xkbcommon.h>
+#endif
+
+namespace fcitx {
+
+#ifdef ENABLE_KEYBOARD
+
+class KeycodeTablePrivate {
+    struct Entry {
+        xkb_keycode_t keycode;
+        xkb_layout_index_t layout;
+        xkb_level_index_t level;
+    };
+
+public:
+    explicit KeycodeTablePrivate(xkb_keymap *keymap)
+        : keymap_(keymap ? xkb_keymap_ref(keymap) : nullptr) {
+        if (!keymap) {
+            return;
+        }
+        xkb_keymap_key_for_each(
+            keymap,
+            [](xkb_keymap *keymap, xkb_keycode_t keycode, void *data) {
+                static_cast<KeycodeTablePrivate *>(data)->addKey(keymap,
+                                                                 keycode);
+            },
+            this);
+    }
+
+    void addKey(xkb_keymap *keymap, xkb_keycode_t keycode) {
+        auto numLayouts = xkb_keymap_num_layouts_for_key(keymap, keycode);
+        for (xkb_layout_index_t layout = 0; layout < numLayouts; layout++) {
+            auto numLevels =
+                xkb_keymap_num_levels_for_key(keymap, keycode, layout);
+            for (xkb_level_index_t level = 0; level < numLevels; level++) {
+                const xkb_keysym_t *syms;
+                auto numSyms = xkb_keymap_key_get_syms_by_level(
+                    keymap, keycode, layout, level, &syms);
+                // Same as xkb_state_key_get_one_sym, only keys producing
+                // exactly one keysym count.
+                if (numSyms != 1) {
+                    continue;
+                }
+                table_[syms[0]].push_back({keycode, layout, level});
+            }
+        }
+    }
+
+    xkb_keycode_t keycode(xkb_state *state, xkb_keysym_t sym) const {
+        auto iter = table_.find(sym);
+        if (!state || iter == table_.end()) {
+            return 0;
+        }
+        // Entries are added in keycode order, so the lowest keycode wins,
+        // same as the scan.
+        for (const auto &entry : iter->second) {
+            auto layout = xkb_state_key_get_layout(state, entry.keycode);
+            if (entry.layout == layout &&
+                xkb_state_key_get_level(state, entry.keycode, layout) ==
+                    entry.level) {
+                return entry.keycode;
+            }
+        }
+        return 0;
+    }
+
+    xkb_keymap *keymap() const { return keymap_.get(); }
+
+private:
+    UniqueCPtr<xkb_keymap, xkb_keymap_unref> keymap_;
+    std::unordered_map<xkb_keysym_t, std::vector<Entry>> table_;
+};
+
+#else
+
+class KeycodeTablePrivate {
+public:
+    explicit KeycodeTablePrivate(xkb_keymap *keymap) : keymap_(keymap) {}
+
+    uint32_t keycode(xkb_state *, uint32_t) const { return 0; }
+
+    xkb_keymap *keymap() const { return keymap_; }
+
+private:
+    xkb_keymap *keymap_;
+};
+
+#endif
+
+KeycodeTable::KeycodeTable(xkb_keymap *keymap)
+    : d_ptr(std::make_unique<KeycodeTablePrivate>(keymap)) {}
+
+KeycodeTable::~KeycodeTable() = default;
+
+xkb_keymap *KeycodeTable::keymap() const {
+    FCITX_D();
+    return d->keymap();
+}
+
+uint32_t KeycodeTable::keycode(xkb_state *state, KeySym sym) const {
+    FCITX_D();
+    return d->keycode(state, sym);
+}
+
+} // namespace fcitx
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_KEYCODETABLE_H_
+#define _FCITX_KEYCODETABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <fcitx-utils/key.h>
+#include <fcitx-utils/macros.h>
+#include "fcitxcore_export.h"
+
+/// \addtogroup FcitxCore
+/// \{
+/// \file
+/// \brief Reverse lookup from keysym to keycode for a compiled xkb keymap.
+
+struct xkb_keymap;
+struct xkb_state;
+
+namespace fcitx {
+
+class KeycodeTablePrivate;
+
+/**
+ * Map keysym to the keycode that produces it in a xkb keymap.
+ *
+ * Scanning every keycode of the keymap for a forwarded key is expensive, so
+ * the owner of a compiled keymap builds the table once together with the
+ * keymap, and frontends look it up through the owner.
+ *
+ * The table holds a reference to the keymap. It is immutable after
+ * construction, so it may be built in a worker thread.
+ *
+ * Without keyboard support the table is always empty.
+ *
+ * @since 5.0.14
+ */
+class FCITXCORE_EXPORT KeycodeTable {
+public:
+    explicit KeycodeTable(struct xkb_keymap *keymap);
+    virtual ~KeycodeTable();
+
+    /// The keymap this table is built from.
+    struct xkb_keymap *keymap() const;
+
+    /**
+     * Find the keycode that produces given keysym under the state.
+     *
+     * Only a key that produces the keysym with the current layout and
+     * modifiers of state is returned, which gives the same result as
+     * scanning all the keys with xkb_state_key_get_one_sym. A key that needs
+     * other modifiers is not returned, since the receiver would read it with
+     * its own modifier state and get a different keysym.
+     *
+     * @param state xkb state of the keymap of this table.
+     * @param sym keysym to look up.
+     * @return keycode, or 0 if no key produces the keysym.
+     */
+    uint32_t keycode(struct xkb_state *state, KeySym sym) const;
+
+private:
+    std::unique_ptr<KeycodeTablePrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(KeycodeTable);
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_KEYCODETABLE_H_
@@ -0,0 +1,211 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "programstate_p.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/unixfd.h"
+
+namespace fcitx {
+
+namespace {
+constexpr char programStateMagic[4] = {'F', 'X', 'P', 'S'};
+constexpr uint32_t programStateVersion = 1;
+
+template <size_t N>
+bool copyString(char (&dest)[N], const std::string &str) {
+    if (str.size() >= N) {
+        return false;
+    }
+    memcpy(dest, str.data(), str.size());
+    memset(dest + str.size(), 0, N - str.size());
+    return true;
+}
+
+template <size_t N>
+bool isValidString(const char (&str)[N]) {
+    return memchr(str, 0, N) != nullptr;
+}
+} // namespace
+
+struct ProgramStateStore::Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t reserved;
+};
+
+struct ProgramStateStore::Record {
+    uint64_t tick;
+    uint8_t used;
+    uint8_t active;
+    uint8_t preeditEnabled;
+    uint8_t reserved[5];
+    char program[112];
+    char localIM[128];
+};
+
+ProgramStateStore::~ProgramStateStore() { close(); }
+
+void ProgramStateStore::close() {
+    if (memory_) {
+        munmap(memory_, size_);
+    }
+    memory_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+    tick_ = 0;
+    index_.clear();
+}
+
+ProgramStateStore::Header *ProgramStateStore::header() const {
+    return static_cast<Header *>(memory_);
+}
+
+ProgramStateStore::Record *ProgramStateStore::record(uint32_t slot) const {
+    static_assert(sizeof(Record) == 256, "Record size is part of file format.");
+    return reinterpret_cast<Record *>(static_cast<char *>(memory_) +
+                                      sizeof(Header)) +
+           slot;
+}
+
+void ProgramStateStore::open(const std::string &path, uint32_t capacity) {
+    close();
+    size_t size = sizeof(Header) + sizeof(Record) * capacity;
+    if (!path.empty() && fs::makePath(fs::dirName(path))) {
+        UnixFD fd = UnixFD::own(
+            ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+        struct stat st;
+        if (fd.isValid() && fstat(fd.fd(), &st) == 0 &&
+            (static_cast<size_t>(st.st_size) == size ||
+             ftruncate(fd.fd(), size) == 0)) {
+            void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, fd.fd(), 0);
+            if (memory != MAP_FAILED) {
+                memory_ = memory;
+            }
+        }
+    }
+    if (!memory_) {
+        FCITX_DEBUG() << "Program state is not persistent: " << path;
+        void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        memory_ = memory;
+    }
+    size_ = size;
+    capacity_ = capacity;
+
+    if (!initialize(capacity)) {
+        clear();
+    }
+    rebuildIndex();
+}
+
+bool ProgramStateStore::initialize(uint32_t capacity) {
+    auto *head = header();
+    if (memcmp(head->magic, programStateMagic, sizeof(head->magic)) == 0 &&
+        head->version == programStateVersion && head->capacity == capacity) {
+        return true;
+    }
+    memcpy(head->magic, programStateMagic, sizeof(head->magic));
+    head->version = programStateVersion;
+    head->capacity = capacity;
+    head->reserved = 0;
+    return false;
+}
+
+void ProgramStateStore::rebuildIndex() {
+    index_.clear();
+    tick_ = 0;
+    for (uint32_t slot = 0; slot < capacity_; slot++) {
+        auto *rec = record(slot);
+        if (!rec->used) {
+            continue;
+        }
+        // Drop anything that looks corrupted.
+        if (!isValidString(rec->program) || !isValidString(rec->localIM) ||
+            !rec->program[0] || !index_.emplace(rec->program, slot).second) {
+            memset(rec, 0, sizeof(Record));
+            continue;
+        }
+        tick_ = std::max(tick_, rec->tick);
+    }
+}
+
+void ProgramStateStore::clear() {
+    if (!memory_) {
+        return;
+    }
+    memset(record(0), 0, sizeof(Record) * capacity_);
+    index_.clear();
+    tick_ = 0;
+}
+
+std::optional<ProgramState>
+ProgramStateStore::find(const std::string &program) const {
+    auto iter = index_.find(program);
+    if (iter == index_.end()) {
+        return std::nullopt;
+    }
+    const auto *rec = record(iter->second);
+    ProgramState state;
+    state.active = rec->active;
+    state.preeditEnabled = rec->preeditEnabled;
+    state.localIM = rec->localIM;
+    return state;
+}
+
+void ProgramStateStore::update(const std::string &program,
+                               const ProgramState &state) {
+    if (!memory_ || program.empty() ||
+        program.size() >= sizeof(Record::program)) {
+        return;
+    }
+
+    Record *rec = nullptr;
+    if (auto iter = index_.find(program); iter != index_.end()) {
+        rec = record(iter->second);
+    } else {
+        // Take a free slot, or the least recently used one.
+        uint32_t target = 0;
+        for (uint32_t slot = 0; slot < capacity_; slot++) {
+            auto *candidate = record(slot);
+            if (!candidate->used) {
+                target = slot;
+                break;
+            }
+            if (candidate->tick < record(target)->tick) {
+                target = slot;
+            }
+        }
+        rec = record(target);
+        if (rec->used) {
+            index_.erase(rec->program);
+        }
+        copyString(rec->program, program);
+        index_[program] = target;
+    }
+
+    rec->active = state.active;
+    rec->preeditEnabled = state.preeditEnabled;
+    if (!copyString(rec->localIM, state.localIM)) {
+        rec->localIM[0] = '\0';
+    }
+    rec->tick = ++tick_;
+    rec->used = 1;
+}
+
+} // namespace fcitx
@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_PROGRAMSTATE_P_H_
+#define _FCITX_PROGRAMSTATE_P_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace fcitx {
+
+struct ProgramState {
+    bool active = false;
+    bool preeditEnabled = true;
+    std::string localIM;
+};
+
+/**
+ * A fixed size LRU table of per program input state.
+ *
+ * The table lives in a memory mapped file, so the state of a program is kept
+ * after all its input contexts are gone and also across restart. Each record
+ * is updated in place, which makes the write cheap enough to be done on every
+ * state change. If the file can not be mapped, anonymous memory is used and
+ * the state only lives as long as the process.
+ */
+class ProgramStateStore {
+public:
+    static constexpr uint32_t defaultCapacity = 256;
+
+    ProgramStateStore() = default;
+    ~ProgramStateStore();
+
+    ProgramStateStore(const ProgramStateStore &) = delete;
+    ProgramStateStore &operator=(const ProgramStateStore &) = delete;
+
+    /// Map the store file, an empty path means not persistent.
+    void open(const std::string &path, uint32_t capacity = defaultCapacity);
+    bool isOpen() const { return memory_ != nullptr; }
+
+    std::optional<ProgramState> find(const std::string &program) const;
+    void update(const std::string &program, const ProgramState &state);
+    void clear();
+
+    size_t size() const { return index_.size(); }
+
+private:
+    struct Header;
+    struct Record;
+
+    void close();
+    Header *header() const;
+    Record *record(uint32_t slot) const;
+    bool initialize(uint32_t capacity);
+    void rebuildIndex();
+
+    void *memory_ = nullptr;
+    size_t size_ = 0;
+    uint32_t capacity_ = 0;
+    uint64_t tick_ = 0;
+    std::unordered_map<std::string, uint32_t> index_;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_PROGRAMSTATE_P_H_
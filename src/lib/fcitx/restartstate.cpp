@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include "restartstate_p.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fcitx-utils/diskcache.h"
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/log.h"
+
+namespace fcitx {
+
+namespace {
+
+constexpr char restartStateMagic[] = "fcitx5-restart-state";
+constexpr uint32_t restartStateVersion = 1;
+
+} // namespace
+
+UnixFD writeRestartState(const RestartStates &states) {
+#ifdef MFD_CLOEXEC
+    DiskCacheWriter writer;
+    writer.writeString(restartStateMagic);
+    writer.writeUInt32(restartStateVersion);
+    writer.writeUInt32(states.size());
+    for (const auto &[name, data] : states) {
+        writer.writeString(name);
+        writer.writeString(data);
+    }
+    const auto &payload = writer.data();
+
+    // No MFD_CLOEXEC, the fd need to be inherited by the new process.
+    UnixFD fd = UnixFD::own(memfd_create("fcitx5-restart-state", 0));
+    if (!fd.isValid() ||
+        fs::safeWrite(fd.fd(), payload.data(), payload.size()) !=
+            static_cast<ssize_t>(payload.size()) ||
+        lseek(fd.fd(), 0, SEEK_SET) != 0) {
+        FCITX_WARN() << "Failed to save state for restart.";
+        return {};
+    }
+    return fd;
+#else
+    FCITX_UNUSED(states);
+    return {};
+#endif
+}
+
+RestartStates readRestartState(int fd) {
+    struct stat stats;
+    if (fstat(fd, &stats) != 0 || lseek(fd, 0, SEEK_SET) != 0) {
+        return {};
+    }
+    std::string payload(stats.st_size, '\0');
+    if (fs::safeRead(fd, payload.data(), payload.size()) !=
+        static_cast<ssize_t>(payload.size())) {
+        return {};
+    }
+
+    DiskCacheReader reader(payload);
+    std::string_view magic;
+    uint32_t version;
+    uint32_t size;
+    if (!reader.readString(magic) || magic != restartStateMagic ||
+        !reader.readUInt32(version) || version != restartStateVersion ||
+        !reader.readUInt32(size)) {
+        return {};
+    }
+    RestartStates states;
+    for (uint32_t i = 0; i < size; i++) {
+        std::string name;
+        std::string data;
+        if (!reader.readString(name) || !reader.readString(data)) {
+            FCITX_WARN() << "State from previous process is truncated.";
+            return {};
+        }
+        states[std::move(name)] = std::move(data);
+    }
+    return states;
+}
+
+} // namespace fcitx
@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_RESTARTSTATE_P_H_
+#define _FCITX_RESTARTSTATE_P_H_
+
+#include <string>
+#include <unordered_map>
+#include "fcitx-utils/unixfd.h"
+
+namespace fcitx {
+
+// Holds the file descriptor of the state passed to the new process by
+// Instance::restart.
+constexpr char restartStateEnv[] = "FCITX_RESTART_STATE_FD";
+
+using RestartStates = std::unordered_map<std::string, std::string>;
+
+/**
+ * Write named states into an in-memory file that is kept open across exec.
+ *
+ * Returns an invalid fd if the platform has no memfd or it fails.
+ */
+UnixFD writeRestartState(const RestartStates &states);
+
+/// Read the states written by writeRestartState, empty if it is invalid.
+RestartStates readRestartState(int fd);
+
+} // namespace fcitx
+
+#endif // _FCITX_RESTARTSTATE_P_H_
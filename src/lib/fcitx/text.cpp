@@ -14,12 +14,31 @@
 
 namespace fcitx {
 
+using TextSegments = std::vector<std::tuple<std::string, TextFormatFlags>>;
+
 class TextPrivate {
 public:
     TextPrivate() = default;
     FCITX_INLINE_DEFINE_DEFAULT_DTOR_AND_COPY(TextPrivate)
 
-    std::vector<std::tuple<std::string, TextFormatFlags>> texts_;
+    const TextSegments &texts() const {
+        static const TextSegments empty;
+        return texts_ ? *texts_ : empty;
+    }
+
+    TextSegments &mutableTexts() {
+        if (!texts_) {
+            texts_ = std::make_shared<TextSegments>();
+        } else if (texts_.use_count() > 1) {
+            texts_ = std::make_shared<TextSegments>(*texts_);
+        }
+        return *texts_;
+    }
+
+    // Segments are shared between copies of Text, since Text is copied a lot
+    // when passing through frontends and output filters but rarely modified.
+    // They are only copied upon modification.
+    std::shared_ptr<TextSegments> texts_;
     int cursor_ = -1;
 };
 
@@ -33,7 +52,7 @@ FCITX_DEFINE_DPTR_COPY_AND_DEFAULT_DTOR_AND_MOVE(Text)
 
 void Text::clear() {
     FCITX_D();
-    d->texts_.clear();
+    d->texts_.reset();
     setCursor();
 }
 
@@ -52,33 +71,33 @@ void Text::append(std::string str, TextFormatFlags flag) {
     if (!utf8::validate(str)) {
         throw std::invalid_argument("Invalid utf8 string");
     }
-    d->texts_.emplace_back(std::move(str), flag);
+    d->mutableTexts().emplace_back(std::move(str), flag);
 }
 
 const std::string &Text::stringAt(int idx) const {
     FCITX_D();
-    return std::get<std::string>(d->texts_[idx]);
+    return std::get<std::string>(d->texts()[idx]);
 }
 
 TextFormatFlags Text::formatAt(int idx) const {
     FCITX_D();
-    return std::get<TextFormatFlags>(d->texts_[idx]);
+    return std::get<TextFormatFlags>(d->texts()[idx]);
 }
 
 size_t Text::size() const {
     FCITX_D();
-    return d->texts_.size();
+    return d->texts().size();
 }
 
 bool Text::empty() const {
     FCITX_D();
-    return d->texts_.empty();
+    return d->texts().empty();
 }
 
 std::string Text::toString() const {
     FCITX_D();
     std::string result;
-    for (const auto &p : d->texts_) {
+    for (const auto &p : d->texts()) {
         result += std::get<std::string>(p);
     }
 
@@ -88,7 +107,7 @@ std::string Text::toString() const {
 size_t Text::textLength() const {
     FCITX_D();
     size_t length = 0;
-    for (const auto &p : d->texts_) {
+    for (const auto &p : d->texts()) {
         length += std::get<std::string>(p).size();
     }
 
@@ -98,7 +117,7 @@ size_t Text::textLength() const {
 std::string Text::toStringForCommit() const {
     FCITX_D();
     std::string result;
-    for (const auto &p : d->texts_) {
+    for (const auto &p : d->texts()) {
         if (!(std::get<TextFormatFlags>(p) & TextFormatFlag::DontCommit)) {
             result += std::get<std::string>(p);
         }
@@ -124,7 +143,7 @@ std::vector<Text> Text::splitByLine() const {
     std::vector<Text> texts;
     // Put first line.
     texts.emplace_back();
-    for (const auto &p : d->texts_) {
+    for (const auto &p : d->texts()) {
         if (std::get<std::string>(p).empty()) {
             continue;
         }
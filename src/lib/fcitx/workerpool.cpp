@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "workerpool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/log.h"
+
+namespace fcitx {
+
+namespace {
+
+// Threads exit after being idle for this long, so an idle fcitx doesn't keep
+// stacks around.
+constexpr auto idleTimeout = std::chrono::seconds(30);
+
+size_t automaticThreads() {
+    size_t cpu = std::thread::hardware_concurrency();
+    return std::clamp<size_t>(cpu, 1, 4);
+}
+
+} // namespace
+
+class WorkerJobState {
+public:
+    enum class Status { Pending, Running, Finished };
+
+    WorkerJobState(WorkerPool::JobFunction work, WorkerPool::DoneFunction done)
+        : work_(std::move(work)), done_(std::move(done)) {}
+
+    // Set from event loop thread with mutex_ held, may be read without lock.
+    std::atomic<bool> cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    Status status_ = Status::Pending;
+    WorkerPool::JobFunction work_;
+    WorkerPool::DoneFunction done_;
+};
+
+WorkerJobToken::WorkerJobToken(const WorkerJobState *state) : state_(state) {}
+
+bool WorkerJobToken::isCancelled() const { return state_->cancelled_; }
+
+WorkerJob::WorkerJob(std::shared_ptr<WorkerJobState> state)
+    : state_(std::move(state)) {}
+
+WorkerJob::~WorkerJob() {
+    std::unique_lock<std::mutex> lock(state_->mutex_);
+    state_->cancelled_ = true;
+    if (!detached_) {
+        state_->cond_.wait(lock, [this]() {
+            return state_->status_ != WorkerJobState::Status::Running;
+        });
+    }
+    state_->done_ = nullptr;
+}
+
+void WorkerJob::detach() { detached_ = true; }
+
+bool WorkerJob::isFinished() const {
+    std::lock_guard<std::mutex> lock(state_->mutex_);
+    return state_->status_ == WorkerJobState::Status::Finished;
+}
+
+class WorkerPoolPrivate {
+public:
+    WorkerPoolPrivate(EventLoop *loop) { dispatcher_.attach(loop); }
+
+    ~WorkerPoolPrivate() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+        }
+        cond_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    size_t computeLimit() const {
+        size_t limit = maxThreads_ ? maxThreads_ : automaticThreads();
+        for (auto reserved : reservations_.view()) {
+            limit = std::max(limit, reserved);
+        }
+        return limit;
+    }
+
+    // Called from event loop thread only.
+    void reapThreads() {
+        std::vector<std::thread::id> retired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            retired.swap(retired_);
+        }
+        for (auto id : retired) {
+            auto iter = std::find_if(threads_.begin(), threads_.end(),
+                                     [id](const std::thread &thread) {
+                                         return thread.get_id() == id;
+                                     });
+            if (iter != threads_.end()) {
+                iter->join();
+                threads_.erase(iter);
+            }
+        }
+    }
+
+    void submit(WorkerJobPriority priority,
+                std::shared_ptr<WorkerJobState> job) {
+        reapThreads();
+        bool spawn = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            limit_ = computeLimit();
+            queues_[static_cast<size_t>(priority)].push_back(std::move(job));
+            if (idle_ == 0 && running_ < limit_) {
+                ++running_;
+                spawn = true;
+            }
+        }
+        if (spawn) {
+            threads_.emplace_back(&WorkerPoolPrivate::run, this);
+        }
+        cond_.notify_one();
+    }
+
+    std::shared_ptr<WorkerJobState> takeJob() {
+        for (auto &queue : queues_) {
+            if (!queue.empty()) {
+                auto job = std::move(queue.front());
+                queue.pop_front();
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool hasJob() const {
+        return std::any_of(std::begin(queues_), std::end(queues_),
+                           [](const auto &queue) { return !queue.empty(); });
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!exit_ && running_ <= limit_) {
+            auto job = takeJob();
+            if (!job) {
+                ++idle_;
+                bool wakeUp = cond_.wait_for(lock, idleTimeout, [this]() {
+                    return exit_ || hasJob();
+                });
+                --idle_;
+                if (!wakeUp) {
+                    break;
+                }
+                continue;
+            }
+            lock.unlock();
+            runJob(job);
+            job.reset();
+            lock.lock();
+        }
+        --running_;
+        retired_.push_back(std::this_thread::get_id());
+    }
+
+    void runJob(const std::shared_ptr<WorkerJobState> &job) {
+        {
+            std::lock_guard<std::mutex> lock(job->mutex_);
+            if (job->cancelled_) {
+                job->status_ = WorkerJobState::Status::Finished;
+                return;
+            }
+            job->status_ = WorkerJobState::Status::Running;
+        }
+
+        bool success = true;
+        try {
+            job->work_(WorkerJobToken(job.get()));
+        } catch (const std::exception &e) {
+            FCITX_WARN() << "Worker job failed: " << e.what();
+            success = false;
+        } catch (...) {
+            FCITX_WARN() << "Worker job failed with unknown exception.";
+            success = false;
+        }
+        job->work_ = nullptr;
+
+        bool hasDone;
+        {
+            std::lock_guard<std::mutex> lock(job->mutex_);
+            job->status_ = WorkerJobState::Status::Finished;
+            hasDone = success && job->done_ && !job->cancelled_;
+        }
+        job->cond_.notify_all();
+        if (hasDone) {
+            dispatcher_.schedule([job]() {
+                if (job->cancelled_ || !job->done_) {
+                    return;
+                }
+                auto done = std::move(job->done_);
+                job->done_ = nullptr;
+                done();
+            });
+        }
+    }
+
+    EventDispatcher dispatcher_;
+    HandlerTable<size_t> reservations_;
+    size_t maxThreads_ = 0;
+    // Only accessed from event loop thread.
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::shared_ptr<WorkerJobState>> queues_[2];
+    std::vector<std::thread::id> retired_;
+    size_t limit_ = 0;
+    size_t running_ = 0;
+    size_t idle_ = 0;
+    bool exit_ = false;
+};
+
+WorkerPool::WorkerPool(EventLoop *loop)
+    : d_ptr(std::make_unique<WorkerPoolPrivate>(loop)) {}
+
+WorkerPool::~WorkerPool() = default;
+
+void WorkerPool::setMaxThreads(size_t threads) {
+    FCITX_D();
+    d->maxThreads_ = threads;
+    std::lock_guard<std::mutex> lock(d->mutex_);
+    d->limit_ = d->computeLimit();
+}
+
+size_t WorkerPool::maxThreads() const {
+    FCITX_D();
+    return d->computeLimit();
+}
+
+std::unique_ptr<HandlerTableEntry<size_t>>
+WorkerPool::reserveThreads(size_t threads) {
+    FCITX_D();
+    return d->reservations_.add(threads);
+}
+
+std::unique_ptr<WorkerJob> WorkerPool::submitJob(WorkerJobPriority priority,
+                                                 JobFunction work,
+                                                 DoneFunction done) {
+    FCITX_D();
+    auto state =
+        std::make_shared<WorkerJobState>(std::move(work), std::move(done));
+    d->submit(priority, state);
+    return std::unique_ptr<WorkerJob>(new WorkerJob(std::move(state)));
+}
+
+} // namespace fcitx
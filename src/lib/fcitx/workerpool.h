@@ -0,0 +1,179 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_WORKERPOOL_H_
+#define _FCITX_WORKERPOOL_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <fcitx-utils/event.h>
+#include <fcitx-utils/handlertable.h>
+#include <fcitx-utils/macros.h>
+#include "fcitxcore_export.h"
+
+/// \addtogroup FcitxCore
+/// \{
+/// \file
+/// \brief Shared worker threads for heavy work of addons.
+
+namespace fcitx {
+
+class WorkerPoolPrivate;
+class WorkerJobState;
+
+/**
+ * Priority of a job. Interactive jobs are always picked before background
+ * jobs.
+ *
+ * @since 5.0.14
+ */
+enum class WorkerJobPriority {
+    /// Result is needed by current user interaction, e.g. candidates.
+    Interactive,
+    /// Work that can be delayed, e.g. preloading data.
+    Background,
+};
+
+/**
+ * Passed to the job function so long running job can stop early.
+ *
+ * @since 5.0.14
+ */
+class FCITXCORE_EXPORT WorkerJobToken {
+public:
+    /// Thread safe check for whether the job is cancelled.
+    bool isCancelled() const;
+
+private:
+    friend class WorkerPoolPrivate;
+    explicit WorkerJobToken(const WorkerJobState *state);
+    const WorkerJobState *state_;
+};
+
+/**
+ * Handle of a submitted job.
+ *
+ * Deleting the handle cancels the job. The completion callback is never
+ * called after the handle is deleted.
+ *
+ * @warning If the job function is running, deleting the handle blocks the
+ * calling thread, usually the event loop, until the function returns. It is
+ * what makes it safe for the job function to use the data of the caller, but
+ * replacing a job on every key press stalls input unless the job function
+ * checks WorkerJobToken::isCancelled often. Call detach() to not wait. The
+ * handle must not be deleted from the job function itself.
+ *
+ * @since 5.0.14
+ */
+class FCITXCORE_EXPORT WorkerJob {
+public:
+    ~WorkerJob();
+
+    /// Whether the job function has returned.
+    bool isFinished() const;
+
+    /**
+     * Don't wait for a running job function when the handle is deleted.
+     *
+     * The job is still cancelled through WorkerJobToken, but the function
+     * may keep running for a while after the handle is gone. It must only
+     * use data it owns then, e.g. a captured std::shared_ptr.
+     */
+    void detach();
+
+private:
+    friend class WorkerPool;
+    explicit WorkerJob(std::shared_ptr<WorkerJobState> state);
+    std::shared_ptr<WorkerJobState> state_;
+    bool detached_ = false;
+};
+
+/**
+ * A pool of worker threads owned by Instance.
+ *
+ * Threads are created on demand and exit after being idle for a while. The
+ * completion callback of a job is called from the thread of the event loop.
+ *
+ * @see Instance::workerPool
+ * @since 5.0.14
+ */
+class FCITXCORE_EXPORT WorkerPool {
+public:
+    using JobFunction = std::function<void(const WorkerJobToken &)>;
+    using DoneFunction = std::function<void()>;
+
+    WorkerPool(EventLoop *loop);
+    virtual ~WorkerPool();
+
+    /**
+     * Set the maximum number of threads.
+     *
+     * @param threads 0 means decided by the number of CPU.
+     */
+    void setMaxThreads(size_t threads);
+
+    /// The effective maximum number of threads.
+    size_t maxThreads() const;
+
+    /**
+     * Allow at least given number of threads as long as the handle is alive.
+     *
+     * This is for addons that do more work in parallel, e.g. from its own
+     * configuration.
+     */
+    FCITX_NODISCARD std::unique_ptr<HandlerTableEntry<size_t>>
+    reserveThreads(size_t threads);
+
+    /**
+     * Run work in worker thread, and call done with its result from the event
+     * loop.
+     *
+     * Work and done need to be copy constructible. Work receives a
+     * WorkerJobToken, and may either return nothing or a value that is passed
+     * to done. done is not called if work throws or the job is cancelled.
+     */
+    template <typename Work, typename Done>
+    FCITX_NODISCARD std::unique_ptr<WorkerJob>
+    submit(WorkerJobPriority priority, Work work, Done done) {
+        using Result = std::invoke_result_t<Work, const WorkerJobToken &>;
+        if constexpr (std::is_void_v<Result>) {
+            return submitJob(priority, std::move(work), std::move(done));
+        } else {
+            auto result = std::make_shared<std::optional<Result>>();
+            return submitJob(
+                priority,
+                [work = std::move(work),
+                 result](const WorkerJobToken &token) mutable {
+                    result->emplace(work(token));
+                },
+                [done = std::move(done), result]() mutable {
+                    done(std::move(**result));
+                });
+        }
+    }
+
+    /// Run work in worker thread without completion callback.
+    template <typename Work>
+    FCITX_NODISCARD std::unique_ptr<WorkerJob>
+    submit(WorkerJobPriority priority, Work work) {
+        return submitJob(priority, std::move(work), {});
+    }
+
+private:
+    std::unique_ptr<WorkerJob> submitJob(WorkerJobPriority priority,
+                                         JobFunction work, DoneFunction done);
+
+    std::unique_ptr<WorkerPoolPrivate> d_ptr;
+    FCITX_DECLARE_PRIVATE(WorkerPool);
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_WORKERPOOL_H_
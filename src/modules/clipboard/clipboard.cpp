@@ -7,6 +7,7 @@
 #include <fcntl.h>
 
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/diskcache.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/inputbuffer.h"
 #include "fcitx-utils/log.h"
@@ -105,6 +106,10 @@ Clipboard::Clipboard(Instance *instance)
       factory_([this](InputContext &) { return new ClipboardState(this); }) {
     instance_->inputContextManager().registerProperty("clipboardState",
                                                       &factory_);
+    restoreState(instance_->restartState("clipboard"));
+    restartStateCallback_ = instance_->addRestartStateCallback(
+        "clipboard", [this]() { return saveState(); });
+    setMemoryUsageCallback([this]() { return memoryUsageImpl(); });
 #ifdef ENABLE_X11
     if (auto xcb = this->xcb()) {
         xcbCreatedCallback_ =
@@ -415,6 +420,42 @@ std::string Clipboard::clipboard(const InputContext *) {
     return history_.front();
 }
 
+AddonMemoryUsage Clipboard::memoryUsageImpl() const {
+    size_t history = 0;
+    for (const auto &str : history_) {
+        // Each entry is stored in both the list and the index of OrderedSet.
+        history += 2 * (sizeof(std::string) + str.capacity());
+    }
+    return {{"history", history}, {"primary", primary_.capacity()}};
+}
+
+std::string Clipboard::saveState() const {
+    DiskCacheWriter writer;
+    writer.writeString(primary_);
+    writer.writeUInt32(history_.size());
+    for (const auto &str : history_) {
+        writer.writeString(str);
+    }
+    return writer.data();
+}
+
+void Clipboard::restoreState(std::string_view state) {
+    DiskCacheReader reader(state);
+    std::string primary;
+    uint32_t size;
+    if (!reader.readString(primary) || !reader.readUInt32(size)) {
+        return;
+    }
+    primary_ = std::move(primary);
+    for (uint32_t i = 0; i < size; i++) {
+        std::string str;
+        if (!reader.readString(str)) {
+            break;
+        }
+        history_.pushBack(str);
+    }
+}
+
 class ClipboardModuleFactory : public AddonFactory {
     AddonInstance *create(AddonManager *manager) override {
         return new Clipboard(manager->instance());
@@ -422,4 +463,4 @@ class ClipboardModuleFactory : public AddonFactory {
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::ClipboardModuleFactory);
+FCITX_ADDON_FACTORY_V2(clipboard, fcitx::ClipboardModuleFactory);
@@ -79,6 +79,10 @@ public:
 private:
     void primaryChanged(const std::string &name);
     void clipboardChanged(const std::string &name);
+    // Keep the history across restart.
+    std::string saveState() const;
+    void restoreState(std::string_view state);
+    AddonMemoryUsage memoryUsageImpl() const;
     FCITX_ADDON_EXPORT_FUNCTION(Clipboard, primary);
     FCITX_ADDON_EXPORT_FUNCTION(Clipboard, clipboard);
 #ifdef ENABLE_X11
@@ -94,6 +98,8 @@ private:
     KeyList selectionKeys_;
     ClipboardConfig config_;
     FactoryFor<ClipboardState> factory_;
+    std::unique_ptr<HandlerTableEntry<RestartStateCallback>>
+        restartStateCallback_;
 
 #ifdef ENABLE_X11
     std::unique_ptr<HandlerTableEntry<XCBConnectionCreated>>
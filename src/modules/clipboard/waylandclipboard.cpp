@@ -5,6 +5,8 @@
  *
  */
 #include "waylandclipboard.h"
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <unordered_set>
 #include "clipboard.h"
@@ -14,6 +16,15 @@
 
 namespace fcitx {
 
+namespace {
+
+// Text mime types that we accept, in the order of preference.
+const std::array<std::string, 4> acceptedMimeTypes = {
+    "text/plain;charset=utf-8", "text/plain;charset=UTF-8", "UTF8_STRING",
+    "text/plain"};
+
+} // namespace
+
 uint64_t DataReaderThread::addTask(std::shared_ptr<UnixFD> fd,
                                    DataOfferCallback callback) {
     auto id = nextId_++;
@@ -36,8 +47,25 @@ uint64_t DataReaderThread::addTask(std::shared_ptr<UnixFD> fd,
                         tasks_->erase(id);
                         return true;
                     }
-                    char buf[4096];
-                    auto n = fs::safeRead(fd, buf, sizeof(buf));
+                    // Read directly into the buffer, but never more than one
+                    // byte beyond the limit. Oversized data is dropped as
+                    // soon as it is detected, the rest is never buffered.
+                    auto size = task->data_.size();
+                    auto chunk =
+                        std::min<size_t>(4096, MAX_CLIPBOARD_SIZE + 1 - size);
+                    task->data_.resize(size + chunk);
+                    auto n = fs::safeRead(fd, task->data_.data() + size, chunk);
+                    if (n < 0) {
+                        tasks_->erase(id);
+                        return true;
+                    }
+                    task->data_.resize(size + n);
+                    if (task->data_.size() > MAX_CLIPBOARD_SIZE) {
+                        FCITX_CLIPBOARD_DEBUG()
+                            << "Clipboard data is too large, ignored.";
+                        tasks_->erase(id);
+                        return true;
+                    }
                     if (n == 0) {
                         dispatcherToMain_.schedule(
                             [data = std::move(task->data_),
@@ -45,14 +73,6 @@ uint64_t DataReaderThread::addTask(std::shared_ptr<UnixFD> fd,
                                 callback(data);
                             });
                         tasks_->erase(id);
-                    } else if (n < 0) {
-                        tasks_->erase(id);
-                    } else {
-                        if (task->data_.size() + n > MAX_CLIPBOARD_SIZE) {
-                            tasks_->erase(id);
-                            return true;
-                        }
-                        task->data_.insert(task->data_.end(), buf, buf + n);
                     }
                     return true;
                 });
@@ -91,8 +111,13 @@ void DataReaderThread::realRun() {
 
 DataOffer::DataOffer(wayland::ZwlrDataControlOfferV1 *offer) : offer_(offer) {
     offer_->setUserData(this);
-    conns_.emplace_back(offer_->offer().connect(
-        [this](const char *offer) { mimeTypes_.insert(offer); }));
+    conns_.emplace_back(offer_->offer().connect([this](const char *offer) {
+        // Only text is ever read, no need to remember anything else.
+        if (std::find(acceptedMimeTypes.begin(), acceptedMimeTypes.end(),
+                      offer) != acceptedMimeTypes.end()) {
+            mimeTypes_.insert(offer);
+        }
+    }));
 }
 
 DataOffer::~DataOffer() {
@@ -106,16 +131,13 @@ void DataOffer::receiveData(DataReaderThread &thread,
     if (thread_) {
         return;
     }
-    std::string mime;
-    static const std::string utf8Mime = "text/plain;charset=utf-8";
-    static const std::string textMime = "text/plain";
-    if (mimeTypes_.count(utf8Mime)) {
-        mime = utf8Mime;
-    } else if (mimeTypes_.count(textMime)) {
-        mime = textMime;
-    } else {
+    auto iter = std::find_if(
+        acceptedMimeTypes.begin(), acceptedMimeTypes.end(),
+        [this](const std::string &mime) { return mimeTypes_.count(mime); });
+    if (iter == acceptedMimeTypes.end()) {
         return;
     }
+    const auto &mime = *iter;
 
     // Create a pipe for sending data.
     int pipeFds[2];
@@ -123,7 +145,7 @@ void DataOffer::receiveData(DataReaderThread &thread,
         return;
     }
 
-    offer_->receive(mime.data(), pipeFds[1]);
+    offer_->receive(mime.c_str(), pipeFds[1]);
     close(pipeFds[1]);
 
     thread_ = &thread;
@@ -34,6 +34,7 @@ class DataOffer;
 struct DataOfferTask {
     DataOfferCallback callback_;
     std::shared_ptr<UnixFD> fd_;
+    // Never grows much beyond MAX_CLIPBOARD_SIZE, larger data is dropped.
     std::vector<char> data_;
     std::unique_ptr<EventSourceIO> ioEvent_;
     std::unique_ptr<EventSource> timeEvent_;
@@ -12,12 +12,14 @@
 #include <fstream>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 #include <fmt/format.h>
 #include "fcitx-config/dbushelper.h"
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/dbus/variant.h"
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/stringutils.h"
+#include "fcitx-utils/task.h"
 #include "fcitx/addonmanager.h"
 #include "fcitx/focusgroup.h"
 #include "fcitx/inputcontextmanager.h"
@@ -50,9 +52,78 @@ constexpr char globalConfigPath[] = "fcitx://config/global";
 constexpr char addonConfigPrefix[] = "fcitx://config/addon/";
 constexpr char imConfigPrefix[] = "fcitx://config/inputmethod/";
 
+struct ConfigURI {
+    enum { Global, Addon, InputMethod } type = Global;
+    // Name of addon or input method.
+    std::string name;
+    // Sub config path of addon.
+    std::string subPath;
+};
+
+ConfigURI parseConfigURI(const std::string &uri) {
+    ConfigURI result;
+    if (uri == globalConfigPath) {
+        result.type = ConfigURI::Global;
+        return result;
+    }
+    if (stringutils::startsWith(uri, addonConfigPrefix)) {
+        result.type = ConfigURI::Addon;
+        result.name = uri.substr(sizeof(addonConfigPrefix) - 1);
+        auto pos = result.name.find('/');
+        if (pos != std::string::npos) {
+            result.subPath = result.name.substr(pos + 1);
+            result.name = result.name.substr(0, pos);
+        }
+        return result;
+    }
+    if (stringutils::startsWith(uri, imConfigPrefix)) {
+        result.type = ConfigURI::InputMethod;
+        result.name = uri.substr(sizeof(imConfigPrefix) - 1);
+        return result;
+    }
+    throw dbus::MethodCallError("org.freedesktop.DBus.Error.InvalidArgs",
+                                "Configuration does not exist.");
+}
+
 #ifdef ENABLE_X11
-std::string X11GetAddress(AddonInstance *xcb, const std::string &display,
-                          xcb_connection_t *conn) {
+template <typename T>
+Task<T> waitForXCBReply(AddonInstance *xcb, const std::string &display,
+                        unsigned int sequence,
+                        std::function<T(void *reply)> extract) {
+    Task<T> task;
+    xcb->call<IXCBModule::waitForReply>(
+        display, sequence,
+        [promise = task.promise(),
+         extract = std::move(extract)](void *reply, xcb_generic_error_t *) {
+            promise.resolve(extract(reply));
+        });
+    return task;
+}
+
+Task<xcb_atom_t> internAtom(AddonInstance *xcb, const std::string &display,
+                            xcb_connection_t *conn, const std::string &name) {
+    auto cookie = xcb_intern_atom(conn, false, name.size(), name.data());
+    return waitForXCBReply<xcb_atom_t>(
+        xcb, display, cookie.sequence, [](void *reply) -> xcb_atom_t {
+            if (!reply) {
+                return XCB_ATOM_NONE;
+            }
+            return static_cast<xcb_intern_atom_reply_t *>(reply)->atom;
+        });
+}
+
+struct X11AddressQuery {
+    AddonInstance *xcb;
+    std::string display;
+    xcb_connection_t *conn;
+    xcb_atom_t selectionAtom = XCB_ATOM_NONE;
+    xcb_atom_t addressAtom = XCB_ATOM_NONE;
+    xcb_atom_t pidAtom = XCB_ATOM_NONE;
+};
+
+// Resolve with empty string if there is no dbus address on X11.
+Task<std::string> X11GetAddress(AddonInstance *xcb, const std::string &display,
+                                xcb_connection_t *conn) {
     static const char selection_prefix[] = "_DBUS_SESSION_BUS_SELECTION_";
     static const char address_prefix[] = "_DBUS_SESSION_BUS_ADDRESS";
     static const char pid_prefix[] = "_DBUS_SESSION_BUS_PID";
@@ -60,68 +131,97 @@ std::string X11GetAddress(AddonInstance *xcb, const std::string &display,
 
     auto machine = getLocalMachineId();
     if (machine.empty()) {
-        return {};
+        return Task<std::string>::ready();
     }
 
     user = getpwuid(getuid());
     if (!user) {
-        return {};
+        return Task<std::string>::ready();
     }
     std::string user_name = user->pw_name;
 
+    auto query = std::make_shared<X11AddressQuery>();
+    query->xcb = xcb;
+    query->display = display;
+    query->conn = conn;
+
+    // Send all of them before waiting, so they only take one round trip.
     auto atom_name =
         stringutils::concat(selection_prefix, user_name, "_", machine);
-    auto selectionAtom =
-        xcb->call<fcitx::IXCBModule::atom>(display, atom_name, false);
-    auto addressAtom =
-        xcb->call<fcitx::IXCBModule::atom>(display, address_prefix, false);
-    auto pidAtom =
-        xcb->call<fcitx::IXCBModule::atom>(display, pid_prefix, false);
-
-    xcb_window_t wid = XCB_WINDOW_NONE;
-    {
-        auto cookie = xcb_get_selection_owner(conn, selectionAtom);
-        auto reply = makeUniqueCPtr(
-            xcb_get_selection_owner_reply(conn, cookie, nullptr));
-        if (!reply || !reply->owner) {
-            return {};
-        }
-        wid = reply->owner;
-    }
-
-    std::string address;
-    {
-        xcb_get_property_cookie_t get_prop_cookie = xcb_get_property(
-            conn, false, wid, addressAtom, XCB_ATOM_STRING, 0, 1024);
-        auto reply = makeUniqueCPtr(
-            xcb_get_property_reply(conn, get_prop_cookie, nullptr));
-
-        if (!reply || reply->type != XCB_ATOM_STRING ||
-            reply->bytes_after > 0 || reply->format != 8) {
-            return {};
-        }
-        auto *data = static_cast<char *>(xcb_get_property_value(reply.get()));
-        int length = xcb_get_property_value_length(reply.get());
-        auto len = strnlen(&(*data), length);
-        address = std::string(&(*data), len);
-    }
-
-    if (address.empty()) {
-        return {};
-    }
-    {
-        xcb_get_property_cookie_t get_prop_cookie = xcb_get_property(
-            conn, false, wid, pidAtom, XCB_ATOM_CARDINAL, 0, sizeof(pid_t));
-        auto reply = makeUniqueCPtr(
-            xcb_get_property_reply(conn, get_prop_cookie, nullptr));
-
-        if (!reply || reply->type != XCB_ATOM_CARDINAL ||
-            reply->bytes_after > 0 || reply->format != 32) {
-            return {};
-        }
-    }
+    auto selectionTask = internAtom(xcb, display, conn, atom_name);
+    auto addressTask = internAtom(xcb, display, conn, address_prefix);
+    auto pidTask = internAtom(xcb, display, conn, pid_prefix);
 
-    return address;
+    return std::move(selectionTask)
+        .then([query,
+               addressTask = std::move(addressTask)](xcb_atom_t atom) mutable {
+            query->selectionAtom = atom;
+            return std::move(addressTask);
+        })
+        .then([query, pidTask = std::move(pidTask)](xcb_atom_t atom) mutable {
+            query->addressAtom = atom;
+            return std::move(pidTask);
+        })
+        .then([query](xcb_atom_t atom) {
+            query->pidAtom = atom;
+            auto cookie =
+                xcb_get_selection_owner(query->conn, query->selectionAtom);
+            return waitForXCBReply<xcb_window_t>(
+                query->xcb, query->display, cookie.sequence,
+                [](void *reply) -> xcb_window_t {
+                    if (!reply) {
+                        return XCB_WINDOW_NONE;
+                    }
+                    return static_cast<xcb_get_selection_owner_reply_t *>(
+                               reply)
+                        ->owner;
+                });
+        })
+        .then([query](xcb_window_t wid) -> Task<std::string> {
+            if (wid == XCB_WINDOW_NONE) {
+                return Task<std::string>::ready();
+            }
+            // Both properties only depend on the owner, send them together.
+            auto addressCookie =
+                xcb_get_property(query->conn, false, wid, query->addressAtom,
+                                 XCB_ATOM_STRING, 0, 1024);
+            auto pidCookie =
+                xcb_get_property(query->conn, false, wid, query->pidAtom,
+                                 XCB_ATOM_CARDINAL, 0, sizeof(pid_t));
+            auto pidTask = waitForXCBReply<bool>(
+                query->xcb, query->display, pidCookie.sequence,
+                [](void *reply) {
+                    auto *pidReply =
+                        static_cast<xcb_get_property_reply_t *>(reply);
+                    return pidReply && pidReply->type == XCB_ATOM_CARDINAL &&
+                           pidReply->bytes_after == 0 &&
+                           pidReply->format == 32;
+                });
+            return waitForXCBReply<std::string>(
+                       query->xcb, query->display, addressCookie.sequence,
+                       [](void *reply) -> std::string {
+                           auto *addressReply =
+                               static_cast<xcb_get_property_reply_t *>(reply);
+                           if (!addressReply ||
+                               addressReply->type != XCB_ATOM_STRING ||
+                               addressReply->bytes_after > 0 ||
+                               addressReply->format != 8) {
+                               return {};
+                           }
+                           auto *data = static_cast<char *>(
+                               xcb_get_property_value(addressReply));
+                           int length =
+                               xcb_get_property_value_length(addressReply);
+                           return std::string(data, strnlen(data, length));
+                       })
+                .then([pidTask = std::move(pidTask)](
+                          std::string address) mutable {
+                    return std::move(pidTask).then(
+                        [address = std::move(address)](bool valid) {
+                            return valid ? address : std::string();
+                        });
+                });
+        });
 }
 #endif
 
@@ -273,7 +373,9 @@ public:
 
     std::tuple<dbus::Variant, DBusConfig> getConfig(const std::string &uri) {
         std::tuple<dbus::Variant, DBusConfig> result;
-        if (uri == globalConfigPath) {
+        const auto target = parseConfigURI(uri);
+        switch (target.type) {
+        case ConfigURI::Global: {
             RawConfig config;
             instance_->globalConfig().save(config);
             std::get<0>(result) = rawConfigToVariant(config);
@@ -281,14 +383,9 @@ public:
                 dumpDBusConfigDescription(instance_->globalConfig().config());
             return result;
         }
-        if (stringutils::startsWith(uri, addonConfigPrefix)) {
-            auto addon = uri.substr(sizeof(addonConfigPrefix) - 1);
-            auto pos = addon.find('/');
-            std::string subPath;
-            if (pos != std::string::npos) {
-                subPath = addon.substr(pos + 1);
-                addon = addon.substr(0, pos);
-            }
+        case ConfigURI::Addon: {
+            const auto &addon = target.name;
+            const auto &subPath = target.subPath;
             if (const auto *addonInfo =
                     instance_->addonManager().addonInfo(addon)) {
                 if (!addonInfo->isConfigurable()) {
@@ -320,8 +417,8 @@ public:
             throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
                                         "Failed to get addon config.");
         }
-        if (stringutils::startsWith(uri, imConfigPrefix)) {
-            auto im = uri.substr(sizeof(imConfigPrefix) - 1);
+        case ConfigURI::InputMethod: {
+            const auto &im = target.name;
             const auto *entry = instance_->inputMethodManager().entry(im);
             if (entry) {
                 if (!entry->isConfigurable()) {
@@ -351,53 +448,101 @@ public:
             throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
                                         "Failed to get input method.");
         }
+        }
         throw dbus::MethodCallError("org.freedesktop.DBus.Error.InvalidArgs",
                                     "Configuration does not exist.");
     }
 
     void setConfig(const std::string &uri, const dbus::Variant &v) {
-        std::tuple<dbus::Variant, DBusConfig> result;
-        RawConfig config = variantToRawConfig(v);
-        if (uri == globalConfigPath) {
-            instance_->globalConfig().load(config, true);
-            if (instance_->globalConfig().safeSave()) {
-                instance_->reloadConfig();
-            }
-        } else if (stringutils::startsWith(uri, addonConfigPrefix)) {
-            auto addon = uri.substr(sizeof(addonConfigPrefix) - 1);
-            auto pos = addon.find('/');
-            std::string subPath;
-            if (pos != std::string::npos) {
-                subPath = addon.substr(pos + 1);
-                addon = addon.substr(0, pos);
+        auto target = resolveConfigTarget(uri);
+        target.config = variantToRawConfig(v);
+        applyConfigTarget(target);
+        if (target.type == ConfigURI::Global &&
+            instance_->globalConfig().safeSave()) {
+            instance_->reloadConfig();
+        }
+    }
+
+    void applyConfigBatch(
+        const std::vector<DBusStruct<std::string, dbus::Variant>> &configs,
+        const std::vector<DBusStruct<
+            std::string, std::string,
+            std::vector<DBusStruct<std::string, std::string>>>> &groups) {
+        // Validate everything before touching anything, so a bad entry does
+        // not leave a half applied batch behind. Changes to the same uri are
+        // merged, so each target is only saved once.
+        std::vector<ConfigTarget> targets;
+        std::unordered_map<std::string, size_t> targetIndex;
+        for (const auto &item : configs) {
+            const auto &uri = std::get<0>(item);
+            auto config = variantToRawConfig(std::get<1>(item));
+            if (auto *index = findValue(targetIndex, uri)) {
+                mergeRawConfig(targets[*index].config, config);
+                continue;
             }
-            auto *addonInstance = instance_->addonManager().addon(addon, true);
-            if (addonInstance) {
-                FCITX_DEBUG() << "Saving addon config to: " << uri;
-                if (subPath.empty()) {
-                    addonInstance->setConfig(config);
-                } else {
-                    addonInstance->setSubConfig(subPath, config);
+            targets.push_back(parseConfigTarget(uri));
+            targets.back().config = std::move(config);
+            targetIndex[uri] = targets.size() - 1;
+        }
+
+        std::vector<InputMethodGroup> newGroups;
+        std::unordered_map<std::string, size_t> groupIndex;
+        for (const auto &item : groups) {
+            const auto &groupName = std::get<0>(item);
+            if (groupName.empty()) {
+                throw dbus::MethodCallError(
+                    "org.freedesktop.DBus.Error.InvalidArgs",
+                    "Input method group name can not be empty.");
+            }
+            InputMethodGroup group(groupName);
+            group.setDefaultLayout(std::get<1>(item));
+            for (const auto &entry : std::get<2>(item)) {
+                // setGroup silently drops unknown input methods.
+                if (!instance_->inputMethodManager().entry(
+                        std::get<0>(entry))) {
+                    throw dbus::MethodCallError(
+                        "org.freedesktop.DBus.Error.InvalidArgs",
+                        stringutils::concat("Input method ",
+                                            std::get<0>(entry),
+                                            " does not exist.")
+                            .data());
                 }
-            } else {
-                throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
-                                            "Failed to get addon.");
+                group.inputMethodList().push_back(
+                    InputMethodGroupItem(std::get<0>(entry))
+                        .setLayout(std::get<1>(entry)));
             }
-        } else if (stringutils::startsWith(uri, imConfigPrefix)) {
-            auto im = uri.substr(sizeof(imConfigPrefix) - 1);
-            const auto *entry = instance_->inputMethodManager().entry(im);
-            auto *engine = instance_->inputMethodEngine(im);
-            if (entry && engine) {
-                FCITX_DEBUG() << "Saving input method config to: " << uri;
-                engine->setConfigForInputMethod(*entry, config);
+            group.setDefaultInputMethod("");
+            if (auto *index = findValue(groupIndex, groupName)) {
+                newGroups[*index] = std::move(group);
             } else {
-                throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
-                                            "Failed to get input method.");
+                newGroups.push_back(std::move(group));
+                groupIndex[groupName] = newGroups.size() - 1;
             }
-        } else {
-            throw dbus::MethodCallError(
-                "org.freedesktop.DBus.Error.InvalidArgs",
-                "Configuration does not exist.");
+        }
+
+        // Only load addons once the whole batch is valid.
+        for (auto &target : targets) {
+            loadConfigTarget(target);
+        }
+
+        bool globalChanged = false;
+        for (auto &target : targets) {
+            applyConfigTarget(target);
+            globalChanged = globalChanged || target.type == ConfigURI::Global;
+        }
+
+        if (!newGroups.empty()) {
+            auto &imManager = instance_->inputMethodManager();
+            for (auto &group : newGroups) {
+                imManager.addEmptyGroup(group.name());
+                imManager.setGroup(std::move(group));
+            }
+            imManager.save();
+            inputMethodGroupChanged();
+        }
+
+        if (globalChanged && instance_->globalConfig().safeSave()) {
+            instance_->reloadConfig();
         }
     }
 
@@ -605,7 +750,198 @@ public:
 
     bool checkUpdate() { return instance_->checkUpdate(); }
 
+    std::vector<DBusStruct<std::string,
+                           std::vector<DBusStruct<std::string, uint64_t>>>>
+    memoryUsage() {
+        auto result = collectAddonCounters(
+            [](AddonInstance *addon) { return addon->memoryUsage(); });
+        // Caches owned by fcitx itself, e.g. keymaps.
+        std::vector<DBusStruct<std::string, uint64_t>> items;
+        for (const auto &[item, value] : instance_->memoryUsage()) {
+            items.emplace_back(item, value);
+        }
+        if (!items.empty()) {
+            result.emplace(result.begin(), "core", std::move(items));
+        }
+        return result;
+    }
+
+    std::vector<DBusStruct<std::string,
+                           std::vector<DBusStruct<std::string, uint64_t>>>>
+    cacheStatistics() {
+        return collectAddonCounters(
+            [](AddonInstance *addon) { return addon->cacheStatistics(); });
+    }
+
+    std::vector<
+        DBusStruct<std::string, uint64_t, uint64_t, uint64_t,
+                   std::vector<uint64_t>>>
+    eventLoopStatistics() {
+        std::vector<DBusStruct<std::string, uint64_t, uint64_t, uint64_t,
+                               std::vector<uint64_t>>>
+            result;
+        for (const auto &stats : instance_->eventLoop().statistics()) {
+            result.emplace_back(std::forward_as_tuple(
+                stats.label, stats.count, stats.totalTime, stats.maxTime,
+                std::vector<uint64_t>(stats.histogram.begin(),
+                                      stats.histogram.end())));
+        }
+        return result;
+    }
+
+    void setEventLoopStatistics(bool enabled, uint64_t stallThreshold) {
+        auto &eventLoop = instance_->eventLoop();
+        if (enabled && !eventLoop.statisticsEnabled()) {
+            eventLoop.resetStatistics();
+        }
+        eventLoop.setStatisticsEnabled(enabled);
+        eventLoop.setStallThreshold(stallThreshold);
+    }
+
+    void trimMemory() {
+        instance_->trimMemory();
+        foreachLoadedAddon([](const std::string &, AddonInstance *addon) {
+            addon->trimMemory();
+        });
+    }
+
 private:
+    template <typename Callback>
+    void foreachLoadedAddon(Callback callback) {
+        auto &addonManager = instance_->addonManager();
+        for (auto category : {AddonCategory::InputMethod,
+                              AddonCategory::Frontend, AddonCategory::Loader,
+                              AddonCategory::Module, AddonCategory::UI}) {
+            auto names = addonManager.addonNames(category);
+            for (const auto &name : names) {
+                if (auto *addon = addonManager.addon(name)) {
+                    callback(name, addon);
+                }
+            }
+        }
+    }
+
+    template <typename Getter>
+    std::vector<DBusStruct<std::string,
+                           std::vector<DBusStruct<std::string, uint64_t>>>>
+    collectAddonCounters(Getter getter) {
+        std::vector<DBusStruct<std::string,
+                               std::vector<DBusStruct<std::string, uint64_t>>>>
+            result;
+        // Only loaded addons, querying must not load anything.
+        foreachLoadedAddon([&result, &getter](const std::string &name,
+                                              AddonInstance *addon) {
+            auto counters = getter(addon);
+            if (counters.empty()) {
+                return;
+            }
+            std::vector<DBusStruct<std::string, uint64_t>> items;
+            for (const auto &[item, value] : counters) {
+                items.emplace_back(item, value);
+            }
+            result.emplace_back(name, std::move(items));
+        });
+        return result;
+    }
+
+    struct ConfigTarget : public ConfigURI {
+        std::string uri;
+        AddonInstance *addon = nullptr;
+        const InputMethodEntry *entry = nullptr;
+        InputMethodEngine *engine = nullptr;
+        RawConfig config;
+    };
+
+    static void mergeRawConfig(RawConfig &config, const RawConfig &other) {
+        if (!other.hasSubItems()) {
+            config.setValue(other.value());
+            return;
+        }
+        other.visitSubItems(
+            [&config](const RawConfig &subConfig, const std::string &path) {
+                mergeRawConfig(config[path], subConfig);
+                return true;
+            });
+    }
+
+    // Find the object to be configured, throws if it does not exist.
+    // Check the target exists without loading any addon.
+    ConfigTarget parseConfigTarget(const std::string &uri) {
+        ConfigTarget target;
+        static_cast<ConfigURI &>(target) = parseConfigURI(uri);
+        target.uri = uri;
+        switch (target.type) {
+        case ConfigURI::Global:
+            break;
+        case ConfigURI::Addon:
+            if (!instance_->addonManager().addonInfo(target.name)) {
+                throw dbus::MethodCallError(
+                    "org.freedesktop.DBus.Error.InvalidArgs",
+                    "Addon does not exist.");
+            }
+            break;
+        case ConfigURI::InputMethod:
+            target.entry = instance_->inputMethodManager().entry(target.name);
+            if (!target.entry) {
+                throw dbus::MethodCallError(
+                    "org.freedesktop.DBus.Error.InvalidArgs",
+                    "Input Method does not exist.");
+            }
+            break;
+        }
+        return target;
+    }
+
+    // Load the addon that owns the config of target.
+    void loadConfigTarget(ConfigTarget &target) {
+        switch (target.type) {
+        case ConfigURI::Global:
+            break;
+        case ConfigURI::Addon:
+            target.addon = instance_->addonManager().addon(target.name, true);
+            if (!target.addon) {
+                throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
+                                            "Failed to get addon.");
+            }
+            break;
+        case ConfigURI::InputMethod:
+            target.engine = instance_->inputMethodEngine(target.name);
+            if (!target.engine) {
+                throw dbus::MethodCallError("org.freedesktop.DBus.Error.Failed",
+                                            "Failed to get input method.");
+            }
+            break;
+        }
+    }
+
+    ConfigTarget resolveConfigTarget(const std::string &uri) {
+        auto target = parseConfigTarget(uri);
+        loadConfigTarget(target);
+        return target;
+    }
+
+    // Global config is only loaded, caller need to save and reload it.
+    void applyConfigTarget(const ConfigTarget &target) {
+        switch (target.type) {
+        case ConfigURI::Global:
+            instance_->globalConfig().load(target.config, true);
+            break;
+        case ConfigURI::Addon:
+            FCITX_DEBUG() << "Saving addon config to: " << target.uri;
+            if (target.subPath.empty()) {
+                target.addon->setConfig(target.config);
+            } else {
+                target.addon->setSubConfig(target.subPath, target.config);
+            }
+            break;
+        case ConfigURI::InputMethod:
+            FCITX_DEBUG() << "Saving input method config to: " << target.uri;
+            target.engine->setConfigForInputMethod(*target.entry,
+                                                   target.config);
+            break;
+        }
+    }
+
     DBusModule *module_;
     Instance *instance_;
     std::unique_ptr<EventSource> deferEvent_;
@@ -658,6 +994,8 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(getAddonsV2, "GetAddonsV2", "",
                                "a(sssibbbasas)");
     FCITX_OBJECT_VTABLE_METHOD(setAddonsState, "SetAddonsState", "a(sb)", "");
+    FCITX_OBJECT_VTABLE_METHOD(applyConfigBatch, "ApplyConfigBatch",
+                               "a(sv)a(ssa(ss))", "");
     FCITX_OBJECT_VTABLE_METHOD(openX11Connection, "OpenX11Connection", "s", "");
     FCITX_OBJECT_VTABLE_METHOD(openWaylandConnection, "OpenWaylandConnection",
                                "s", "");
@@ -666,11 +1004,38 @@ private:
     FCITX_OBJECT_VTABLE_METHOD(debugInfo, "DebugInfo", "", "s");
     FCITX_OBJECT_VTABLE_METHOD(refresh, "Refresh", "", "");
     FCITX_OBJECT_VTABLE_METHOD(checkUpdate, "CheckUpdate", "", "b");
+    FCITX_OBJECT_VTABLE_METHOD(memoryUsage, "MemoryUsage", "", "a(sa(st))");
+    FCITX_OBJECT_VTABLE_METHOD(trimMemory, "TrimMemory", "", "");
+    FCITX_OBJECT_VTABLE_METHOD(cacheStatistics, "CacheStatistics", "",
+                               "a(sa(st))");
+    FCITX_OBJECT_VTABLE_METHOD(eventLoopStatistics, "EventLoopStatistics", "",
+                               "a(stttat)");
+    FCITX_OBJECT_VTABLE_METHOD(setEventLoopStatistics,
+                               "SetEventLoopStatistics", "bt", "");
 };
 
-DBusModule::DBusModule(Instance *instance)
-    : instance_(instance), bus_(connectToSessionBus()),
-      serviceWatcher_(std::make_unique<dbus::ServiceWatcher>(*bus_)) {
+DBusModule::DBusModule(Instance *instance) : instance_(instance) {
+    try {
+        bus_ = std::make_unique<dbus::Bus>(dbus::BusType::Session);
+    } catch (...) {
+    }
+    if (bus_) {
+        setupBus();
+        return;
+    }
+#ifdef ENABLE_X11
+    if (connectToX11SessionBus()) {
+        return;
+    }
+#endif
+    throw std::runtime_error("Failed to connect to session dbus");
+}
+
+DBusModule::~DBusModule() {}
+
+void DBusModule::setupBus() {
+    auto *instance = instance_;
+    serviceWatcher_ = std::make_unique<dbus::ServiceWatcher>(*bus_);
     bus_->attachEventLoop(&instance->eventLoop());
     auto uniqueName = bus_->uniqueName();
     Flags<RequestNameFlag> requestFlag = RequestNameFlag::AllowReplacement;
@@ -712,37 +1077,49 @@ DBusModule::DBusModule(Instance *instance)
                const std::string &newName) { xkbHelperName_ = newName; });
 }
 
-DBusModule::~DBusModule() {}
+#ifdef ENABLE_X11
+bool DBusModule::connectToX11SessionBus() {
+    auto *xcbAddon = xcb();
+    if (!xcbAddon) {
+        return false;
+    }
+    // This callback should be called immediately for all existing X11
+    // connection, the first one is used.
+    auto callback = xcbAddon->call<IXCBModule::addConnectionCreatedCallback>(
+        [this, xcbAddon](const std::string &name, xcb_connection_t *conn, int,
+                         FocusGroup *) {
+            if (x11AddressTask_) {
+                return;
+            }
+            x11AddressTask_ = X11GetAddress(xcbAddon, name, conn)
+                                  .then([this](const std::string &address) {
+                                      onX11Address(address);
+                                  });
+        });
+    if (!x11AddressTask_ || x11AddressTask_->isResolved()) {
+        return bus_ != nullptr;
+    }
+    // Addons using the bus are loaded once it is connected.
+    instance_->addonManager().deferAddonReady("dbus");
+    return true;
+}
 
-std::unique_ptr<dbus::Bus> DBusModule::connectToSessionBus() {
-    try {
-        auto bus = std::make_unique<dbus::Bus>(dbus::BusType::Session);
-        return bus;
-    } catch (...) {
+void DBusModule::onX11Address(const std::string &address) {
+    FCITX_DEBUG() << "DBus address from X11: " << address;
+    if (address.empty()) {
+        FCITX_ERROR() << "Failed to find session dbus address on X11.";
+        return;
     }
-#ifdef ENABLE_X11
-    if (auto *xcbAddon = xcb()) {
-        std::string address;
-        // This callback should be called immediately for all existing X11
-        // connection.
-        auto callback =
-            xcbAddon->call<IXCBModule::addConnectionCreatedCallback>(
-                [xcbAddon, &address](const std::string &name,
-                                     xcb_connection_t *conn, int,
-                                     FocusGroup *) {
-                    if (!address.empty()) {
-                        return;
-                    }
-                    address = X11GetAddress(xcbAddon, name, conn);
-                });
-        FCITX_DEBUG() << "DBus address from X11: " << address;
-        if (!address.empty()) {
-            return std::make_unique<dbus::Bus>(address);
-        }
+    try {
+        bus_ = std::make_unique<dbus::Bus>(address);
+        setupBus();
+    } catch (const std::exception &e) {
+        FCITX_ERROR() << "Failed to connect to session dbus: " << e.what();
+        return;
     }
-#endif
-    throw std::runtime_error("Failed to connect to session dbus");
+    instance_->addonManager().setAddonReady("dbus");
 }
+#endif
 
 dbus::Bus *DBusModule::bus() { return bus_.get(); }
 
@@ -766,4 +1143,4 @@ class DBusModuleFactory : public AddonFactory {
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::DBusModuleFactory)
+FCITX_ADDON_FACTORY_V2(dbus, fcitx::DBusModuleFactory)
@@ -7,8 +7,10 @@
 #ifndef _FCITX_MODULES_DBUS_DBUSMODULE_H_
 #define _FCITX_MODULES_DBUS_DBUSMODULE_H_
 
+#include <optional>
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/dbus/servicewatcher.h"
+#include "fcitx-utils/task.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
@@ -34,7 +36,10 @@ private:
     FCITX_ADDON_EXPORT_FUNCTION(DBusModule, lockGroup);
     FCITX_ADDON_EXPORT_FUNCTION(DBusModule, hasXkbHelper);
 
-    std::unique_ptr<dbus::Bus> connectToSessionBus();
+    void setupBus();
+    // Look up the address on X11 when there is no session bus.
+    bool connectToX11SessionBus();
+    void onX11Address(const std::string &address);
 
     Instance *instance_;
     std::unique_ptr<dbus::Bus> bus_;
@@ -46,6 +51,7 @@ private:
         xkbWatcher_;
     std::string xkbHelperName_;
     std::unique_ptr<Controller1> controller_;
+    std::optional<Task<void>> x11AddressTask_;
 };
 } // namespace fcitx
 
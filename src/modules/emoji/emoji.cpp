@@ -6,10 +6,12 @@
  */
 #include "emoji.h"
 #include "fcitx-utils/charutils.h"
+#include "fcitx-utils/diskcache.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/stringutils.h"
 #include "fcitx-utils/utf8.h"
 #include "fcitx/addonfactory.h"
+#include "fcitx/addonmanager.h"
 #include "../../im/keyboard/xmlparser.h"
 #include "config.h"
 
@@ -72,11 +74,21 @@ private:
 
 static const std::vector<std::string> emptyEmoji;
 
-Emoji::Emoji() {}
+Emoji::Emoji(Instance *instance)
+    : idleReleaser_(instance, "emoji", [this]() {
+          langToEmojiMap_.clear();
+          return true;
+      }) {
+    setMemoryUsageCallback([this]() { return memoryUsageImpl(); });
+    setTrimMemoryCallback([this]() { trimMemoryImpl(); });
+    setCacheStatisticsCallback(
+        [this]() { return idleReleaser_.statistics(); });
+}
 
 Emoji::~Emoji() {}
 
 bool Emoji::check(const std::string &language, bool fallbackToEn) {
+    idleReleaser_.touch();
     const EmojiMap *emojiMap = loadEmoji(language, fallbackToEn);
     return emojiMap;
 }
@@ -84,6 +96,7 @@ bool Emoji::check(const std::string &language, bool fallbackToEn) {
 const std::vector<std::string> &Emoji::query(const std::string &language,
                                              const std::string &key,
                                              bool fallbackToEn) {
+    idleReleaser_.touch();
     const EmojiMap *emojiMap = loadEmoji(language, fallbackToEn);
 
     if (!emojiMap) {
@@ -101,6 +114,7 @@ void Emoji::prefix(
     const std::string &language, const std::string &key, bool fallbackToEn,
     const std::function<bool(const std::string &,
                              const std::vector<std::string> &)> &collector) {
+    idleReleaser_.touch();
     const EmojiMap *emojiMap = loadEmoji(language, fallbackToEn);
 
     if (!emojiMap) {
@@ -122,6 +136,47 @@ namespace {
 bool noSpace(const std::string &str) {
     return std::any_of(str.begin(), str.end(), charutils::isspace);
 }
+
+bool loadEmojiCache(const DiskCache &cache, EmojiMap &emojiMap) {
+    auto data = cache.load();
+    if (!data) {
+        return false;
+    }
+    DiskCacheReader reader(data->view());
+    uint32_t size;
+    if (!reader.readUInt32(size)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        std::string key;
+        uint32_t count;
+        if (!reader.readString(key) || !reader.readUInt32(count)) {
+            return false;
+        }
+        std::vector<std::string> emojis(count);
+        for (auto &emoji : emojis) {
+            if (!reader.readString(emoji)) {
+                return false;
+            }
+        }
+        emojiMap.emplace_hint(emojiMap.end(), std::move(key),
+                              std::move(emojis));
+    }
+    return reader.atEnd();
+}
+
+void saveEmojiCache(const DiskCache &cache, const EmojiMap &emojiMap) {
+    DiskCacheWriter writer;
+    writer.writeUInt32(emojiMap.size());
+    for (const auto &[key, emojis] : emojiMap) {
+        writer.writeString(key);
+        writer.writeUInt32(emojis.size());
+        for (const auto &emoji : emojis) {
+            writer.writeString(emoji);
+        }
+    }
+    cache.save(writer.data());
+}
 } // namespace
 
 const EmojiMap *Emoji::loadEmoji(const std::string &language,
@@ -174,8 +229,15 @@ const EmojiMap *Emoji::loadEmoji(const std::string &language,
         const auto *filter = findValue(filterMap, lang);
         const auto file = stringutils::joinPath(
             CLDR_DIR, "/common/annotations", stringutils::concat(lang, ".xml"));
+        // The filter only depends on the language, which is in the name.
+        DiskCache cache(stringutils::concat("emoji-", lang), 1);
+        cache.addSourceFile(file);
+        EmojiMap cached;
         EmojiParser parser(filter ? *filter : nullptr);
-        if (parser.parse(file)) {
+        if (loadEmojiCache(cache, cached)) {
+            emojiMap = &(langToEmojiMap_[lang] = std::move(cached));
+        } else if (parser.parse(file)) {
+            saveEmojiCache(cache, parser.emojiMap_);
             emojiMap = &(langToEmojiMap_[lang] = std::move(parser.emojiMap_));
             FCITX_INFO() << "Trying to load emoji for " << lang << " from "
                          << file << ": " << emojiMap->size()
@@ -194,10 +256,35 @@ const EmojiMap *Emoji::loadEmoji(const std::string &language,
     return emojiMap;
 }
 
+AddonMemoryUsage Emoji::memoryUsageImpl() const {
+    AddonMemoryUsage usage;
+    for (const auto &[lang, emojiMap] : langToEmojiMap_) {
+        size_t size = 0;
+        for (const auto &[key, emojis] : emojiMap) {
+            // Rough estimation of a tree node.
+            size += sizeof(EmojiMap::value_type) + 4 * sizeof(void *) +
+                    key.capacity();
+            for (const auto &emoji : emojis) {
+                size += sizeof(std::string) + emoji.capacity();
+            }
+        }
+        usage.emplace_back(stringutils::concat("emoji:", lang), size);
+    }
+    return usage;
+}
+
+void Emoji::trimMemoryImpl() {
+    // Loaded again upon next query.
+    langToEmojiMap_.clear();
+    idleReleaser_.markReleased();
+}
+
 class EmojiModuleFactory : public AddonFactory {
-    AddonInstance *create(AddonManager *) override { return new Emoji; }
+    AddonInstance *create(AddonManager *manager) override {
+        return new Emoji(manager->instance());
+    }
 };
 
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::EmojiModuleFactory);
+FCITX_ADDON_FACTORY_V2(emoji, fcitx::EmojiModuleFactory);
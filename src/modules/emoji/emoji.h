@@ -11,6 +11,7 @@
 #include <set>
 #include <vector>
 #include "fcitx/addoninstance.h"
+#include "fcitx/idlecache_p.h"
 #include "emoji_public.h"
 
 namespace fcitx {
@@ -19,7 +20,7 @@ using EmojiMap = std::map<std::string, std::vector<std::string>>;
 class Emoji final : public AddonInstance {
 
 public:
-    Emoji();
+    Emoji(Instance *instance);
     ~Emoji();
 
     bool check(const std::string &language, bool fallbackToEn);
@@ -31,13 +32,18 @@ public:
                 const std::function<bool(const std::string &,
                                          const std::vector<std::string> &)> &);
 
+
 private:
     FCITX_ADDON_EXPORT_FUNCTION(Emoji, query);
     FCITX_ADDON_EXPORT_FUNCTION(Emoji, check);
     FCITX_ADDON_EXPORT_FUNCTION(Emoji, prefix);
 
+    AddonMemoryUsage memoryUsageImpl() const;
+    void trimMemoryImpl();
+
     const EmojiMap *loadEmoji(const std::string &language, bool fallbackToEn);
     std::unordered_map<std::string, EmojiMap> langToEmojiMap_;
+    IdleCacheReleaser idleReleaser_;
 };
 } // namespace fcitx
 
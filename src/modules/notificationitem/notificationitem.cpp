@@ -362,4 +362,4 @@ class NotificationItemFactory : public AddonFactory {
 
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::NotificationItemFactory)
+FCITX_ADDON_FACTORY_V2(notificationitem, fcitx::NotificationItemFactory)
@@ -54,9 +54,22 @@ public:
 
 QuickPhrase::QuickPhrase(Instance *instance)
     : instance_(instance), spellProvider_(this),
-      factory_([this](InputContext &) { return new QuickPhraseState(this); }) {
+      factory_([this](InputContext &) { return new QuickPhraseState(this); }),
+      idleReleaser_(instance, "builtin", [this]() {
+          builtinProvider_.reloadConfig();
+          return true;
+      }) {
     instance_->inputContextManager().registerProperty("quickphraseState",
                                                       &factory_);
+    setMemoryUsageCallback([this]() -> AddonMemoryUsage {
+        return {{"builtin", builtinProvider_.memoryUsage()}};
+    });
+    setTrimMemoryCallback([this]() {
+        builtinProvider_.reloadConfig();
+        idleReleaser_.markReleased();
+    });
+    setCacheStatisticsCallback(
+        [this]() { return idleReleaser_.statistics(); });
     eventHandlers_.emplace_back(instance_->watchEvent(
         EventType::InputContextKeyEvent, EventWatcherPhase::Default,
         [this](Event &event) {
@@ -334,6 +347,7 @@ void QuickPhrase::updateUI(InputContext *inputContext) {
     if (!state->buffer_.empty()) {
         auto candidateList = std::make_unique<CommonCandidateList>();
         candidateList->setPageSize(instance_->globalConfig().defaultPageSize());
+        idleReleaser_.touch();
         QuickPhraseProvider *providers[] = {&callbackProvider_,
                                             &builtinProvider_, &spellProvider_};
         QuickPhraseAction selectionKeyAction =
@@ -456,4 +470,4 @@ class QuickPhraseModuleFactory : public AddonFactory {
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::QuickPhraseModuleFactory)
+FCITX_ADDON_FACTORY_V2(quickphrase, fcitx::QuickPhraseModuleFactory)
@@ -17,6 +17,7 @@
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/idlecache_p.h"
 #include "fcitx/inputcontextproperty.h"
 #include "fcitx/instance.h"
 #include "quickphrase_public.h"
@@ -96,6 +97,7 @@ private:
     BuiltInQuickPhraseProvider builtinProvider_;
     SpellQuickPhraseProvider spellProvider_;
     FactoryFor<QuickPhraseState> factory_;
+    IdleCacheReleaser idleReleaser_;
 };
 } // namespace fcitx
 
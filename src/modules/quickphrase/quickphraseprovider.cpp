@@ -18,6 +18,7 @@ namespace fcitx {
 bool BuiltInQuickPhraseProvider::populate(
     InputContext *, const std::string &userInput,
     const QuickPhraseAddCandidateCallback &addCandidate) {
+    ensureLoaded();
     auto start = map_.lower_bound(userInput);
     auto end = map_.end();
 
@@ -32,9 +33,26 @@ bool BuiltInQuickPhraseProvider::populate(
     }
     return true;
 }
-void BuiltInQuickPhraseProvider::reloadConfig() {
+size_t BuiltInQuickPhraseProvider::memoryUsage() const {
+    size_t size = 0;
+    for (const auto &[key, value] : map_) {
+        // Rough estimation of a tree node.
+        size += sizeof(decltype(map_)::value_type) + 4 * sizeof(void *) +
+                key.capacity() + value.capacity();
+    }
+    return size;
+}
 
+void BuiltInQuickPhraseProvider::reloadConfig() {
     map_.clear();
+    loaded_ = false;
+}
+
+void BuiltInQuickPhraseProvider::ensureLoaded() {
+    if (loaded_) {
+        return;
+    }
+    loaded_ = true;
     auto file = StandardPath::global().open(StandardPath::Type::PkgData,
                                             "data/QuickPhrase.mb", O_RDONLY);
     auto files = StandardPath::global().multiOpen(
@@ -32,10 +32,14 @@ class BuiltInQuickPhraseProvider : public QuickPhraseProvider {
 public:
     bool populate(InputContext *ic, const std::string &userInput,
                   const QuickPhraseAddCandidateCallback &addCandidate) override;
+    // Phrases are loaded upon next populate.
     void reloadConfig();
+    size_t memoryUsage() const;
 
 private:
+    void ensureLoaded();
     void load(StandardPathFile &file);
+    bool loaded_ = false;
     std::multimap<std::string, std::string> map_;
 };
 
@@ -9,7 +9,9 @@
 #include "spell-custom-dict.h"
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <algorithm>
 #include <stdexcept>
+#include <string_view>
 #include "fcitx-utils/cutf8.h"
 #include "fcitx-utils/endian_p.h"
 #include "fcitx-utils/fs.h"
@@ -313,7 +315,7 @@ bool SpellCustomDict::checkDict(const std::string &lang) {
 }
 
 int SpellCustomDict::getDistance(const char *word, int utf8Len,
-                                 const char *dict) {
+                                 const char *dict, size_t *readBytes) {
 #define REPLACE_WEIGHT 3
 #define INSERT_WEIGHT 3
 #define REMOVE_WEIGHT 3
@@ -332,6 +334,13 @@ int SpellCustomDict::getDistance(const char *word, int utf8Len,
      * and the total error number should be no more than "maxdiff"
      * while maxdiff equales to length / 3.
      */
+    const char *wordStart = word;
+    auto reject = [&word, wordStart, readBytes]() {
+        if (readBytes) {
+            *readBytes = word - wordStart;
+        }
+        return -1;
+    };
     int replace = 0;
     int insert = 0;
     int remove = 0;
@@ -365,14 +374,14 @@ int SpellCustomDict::getDistance(const char *word, int utf8Len,
         /* check remove error */
         if (!cur_dict_c) {
             if (next_word_c) {
-                return -1;
+                return reject();
             }
             remove++;
             if (diff <= maxdiff && remove <= maxremove) {
                 return (replace * REPLACE_WEIGHT + insert * INSERT_WEIGHT +
                         remove * REMOVE_WEIGHT);
             }
-            return -1;
+            return reject();
         }
         dict = fcitx_utf8_get_char(dict, &next_dict_c);
         if (cur_word_c == cur_dict_c || (wordCompare(cur_word_c, cur_dict_c))) {
@@ -413,7 +422,7 @@ int SpellCustomDict::getDistance(const char *word, int utf8Len,
         }
         break;
     }
-    return -1;
+    return reject();
 }
 
 std::vector<std::string> SpellCustomDict::hint(const std::string &str,
@@ -437,10 +446,37 @@ std::vector<std::string> SpellCustomDict::hint(const std::string &str,
                       const std::pair<const char *, int> &rhs) {
         return lhs.second < rhs.second;
     };
-    for (const auto &wordOffset : words_) {
+
+    // getDistance is deterministic on the bytes it reads and the limit of
+    // error computed from the length. If a word is rejected before reading
+    // beyond the common prefix of last word, it will be rejected again.
+    size_t commonPrefix = 0;
+    std::string_view realWordView(real_word);
+    if (rejectedAt_.size() == words_.size() &&
+        lastWordLen_ / 3 == word_len / 3 &&
+        (lastWordLen_ - 2) / 3 == (word_len - 2) / 3) {
+        auto limit = std::min(lastWord_.size(), realWordView.size());
+        while (commonPrefix < limit &&
+               lastWord_[commonPrefix] == realWordView[commonPrefix]) {
+            ++commonPrefix;
+        }
+    } else {
+        rejectedAt_.assign(words_.size(), NotRejected);
+    }
+    lastWord_ = realWordView;
+    lastWordLen_ = word_len;
+
+    for (size_t i = 0; i < words_.size(); i++) {
+        if (rejectedAt_[i] <= commonPrefix) {
+            continue;
+        }
         int dist;
-        const char *dictWord = data_.data() + wordOffset;
-        if ((dist = getDistance(real_word, word_len, dictWord)) >= 0) {
+        size_t readBytes;
+        const char *dictWord = data_.data() + words_[i];
+        dist = getDistance(real_word, word_len, dictWord, &readBytes);
+        rejectedAt_[i] =
+            (dist < 0 && readBytes < NotRejected) ? readBytes : NotRejected;
+        if (dist >= 0) {
             tops.emplace_back(dictWord, dist);
             std::push_heap(tops.begin(), tops.end(), compare);
             if (tops.size() > limit) {
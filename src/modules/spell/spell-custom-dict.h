@@ -8,6 +8,7 @@
 #ifndef _FCITX_MODULES_SPELL_SPELL_CUSTOM_DICT_H_
 #define _FCITX_MODULES_SPELL_SPELL_CUSTOM_DICT_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -22,16 +23,32 @@ public:
     static std::string locateDictFile(const std::string &lang);
 
     std::vector<std::string> hint(const std::string &str, size_t limit);
+    size_t memoryUsage() const {
+        return data_.capacity() + words_.capacity() * sizeof(uint32_t) +
+               rejectedAt_.capacity() * sizeof(uint16_t) + lastWord_.capacity();
+    }
 
 protected:
     void loadDict(const std::string &lang);
-    int getDistance(const char *word, int utf8Len, const char *dict);
+    int getDistance(const char *word, int utf8Len, const char *dict,
+                    size_t *readBytes = nullptr);
     virtual bool wordCompare(unsigned int c1, unsigned int c2) = 0;
     virtual int wordCheck(const std::string &word) = 0;
     virtual void hintComplete(std::vector<std::string> &hints, int type) = 0;
     std::vector<char> data_;
     std::vector<uint32_t> words_;
     std::string delim_;
+
+private:
+    // State of last hint, used to skip the words that are already known to
+    // be rejected when the word is extended or shortened.
+    std::string lastWord_;
+    int lastWordLen_ = 0;
+    // Per dict word, number of bytes of lastWord_ that getDistance had read
+    // before it rejects the word. NotRejected if it is not rejected, or the
+    // result depends on the end of lastWord_.
+    std::vector<uint16_t> rejectedAt_;
+    static constexpr uint16_t NotRejected = UINT16_MAX;
 };
 } // namespace fcitx
 
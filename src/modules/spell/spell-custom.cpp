@@ -38,6 +38,16 @@ bool fcitx::SpellCustom::loadDict(const std::string &language) {
     return false;
 }
 
+size_t fcitx::SpellCustom::memoryUsage() const {
+    return dict_ ? dict_->memoryUsage() : 0;
+}
+
+void fcitx::SpellCustom::trimMemory() {
+    // Dictionary will be loaded again upon next hint.
+    dict_.reset();
+    language_.clear();
+}
+
 std::vector<std::string> fcitx::SpellCustom::hint(const std::string &language,
                                                   const std::string &str,
                                                   size_t limit) {
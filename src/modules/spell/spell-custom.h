@@ -24,6 +24,8 @@ public:
     std::vector<std::string> hint(const std::string &language,
                                   const std::string &str,
                                   size_t limit) override;
+    size_t memoryUsage() const override;
+    void trimMemory() override;
 
 private:
     bool loadDict(const std::string &language);
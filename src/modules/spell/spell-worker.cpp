@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "spell-worker.h"
+#include <algorithm>
+#include "spell.h"
+
+namespace fcitx {
+
+namespace {
+
+class SpellHintHandle : public HandlerTableEntry<SpellHintCallback> {
+public:
+    SpellHintHandle(std::shared_ptr<SpellHintTask> task,
+                    SpellHintCallback callback)
+        : HandlerTableEntry<SpellHintCallback>(std::move(callback)),
+          task_(std::move(task)) {
+        task_->callback_ = handler_;
+    }
+
+    ~SpellHintHandle() { task_->cancelled_ = true; }
+
+private:
+    std::shared_ptr<SpellHintTask> task_;
+};
+
+} // namespace
+
+SpellWorker::SpellWorker(Spell *spell, EventLoop *main) : parent_(spell) {
+    dispatcherToMain_.attach(main);
+}
+
+SpellWorker::~SpellWorker() {
+    if (thread_ && thread_->joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exit_ = true;
+        }
+        condition_.notify_one();
+        thread_->join();
+    }
+}
+
+std::unique_ptr<HandlerTableEntry<SpellHintCallback>>
+SpellWorker::addTask(const std::string &language, const std::string &word,
+                     size_t limit, SpellHintCallback callback) {
+    auto task = std::make_shared<SpellHintTask>();
+    task->language_ = language;
+    task->word_ = word;
+    task->limit_ = limit;
+    auto handle = std::make_unique<SpellHintHandle>(task, std::move(callback));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Drop anything that is already cancelled, so the queue does not grow
+        // when user types faster than the hint.
+        tasks_.erase(std::remove_if(tasks_.begin(), tasks_.end(),
+                                    [](const auto &task) {
+                                        return task->cancelled_.load();
+                                    }),
+                     tasks_.end());
+        tasks_.push_back(std::move(task));
+    }
+    if (!thread_) {
+        thread_ = std::make_unique<std::thread>(&SpellWorker::run, this);
+    }
+    condition_.notify_one();
+    return handle;
+}
+
+void SpellWorker::realRun() {
+    while (true) {
+        std::shared_ptr<SpellHintTask> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock,
+                            [this]() { return exit_ || !tasks_.empty(); });
+            if (exit_) {
+                break;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        if (task->cancelled_) {
+            continue;
+        }
+
+        auto result =
+            parent_->computeHint(task->language_, task->word_, task->limit_);
+        if (task->cancelled_) {
+            continue;
+        }
+        dispatcherToMain_.schedule(
+            [callback = task->callback_, result = std::move(result)]() {
+                // Handle may be destroyed after hint is computed.
+                auto handler = callback.lock();
+                if (handler && *handler) {
+                    // Callback may destroy the handle.
+                    auto func = **handler;
+                    func(result);
+                }
+            });
+    }
+}
+
+} // namespace fcitx
@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_MODULES_SPELL_SPELL_WORKER_H_
+#define _FCITX_MODULES_SPELL_SPELL_WORKER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/eventdispatcher.h"
+#include "spell_public.h"
+
+namespace fcitx {
+
+class Spell;
+
+struct SpellHintTask {
+    std::string language_;
+    std::string word_;
+    size_t limit_;
+    std::weak_ptr<std::unique_ptr<SpellHintCallback>> callback_;
+    // Set from main thread when the handle is destroyed, checked by worker
+    // before doing any real work.
+    std::atomic<bool> cancelled_{false};
+};
+
+// SpellWorker computes spell hint in a dedicated thread. Each request returns
+// a handle, destroying the handle cancels the request. If a request is
+// cancelled before it is picked up by worker, the hint is never computed. If
+// it is cancelled afterwards, the callback will not be invoked.
+class SpellWorker {
+public:
+    SpellWorker(Spell *spell, EventLoop *main);
+    ~SpellWorker();
+
+    std::unique_ptr<HandlerTableEntry<SpellHintCallback>>
+    addTask(const std::string &language, const std::string &word, size_t limit,
+            SpellHintCallback callback);
+
+private:
+    static void run(SpellWorker *self) { self->realRun(); }
+    void realRun();
+
+    Spell *parent_;
+    EventDispatcher dispatcherToMain_;
+    std::unique_ptr<std::thread> thread_;
+    // Protects tasks_ and exit_.
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::shared_ptr<SpellHintTask>> tasks_;
+    bool exit_ = false;
+};
+
+} // namespace fcitx
+
+#endif // _FCITX_MODULES_SPELL_SPELL_WORKER_H_
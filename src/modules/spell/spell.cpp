@@ -9,16 +9,20 @@
 #include <fcntl.h>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/standardpath.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx/addonmanager.h"
 #include "config.h"
 #include "spell-custom.h"
+#include "spell-worker.h"
 #ifdef ENABLE_ENCHANT
 #include "spell-enchant.h"
 #endif
 
 namespace fcitx {
 
-Spell::Spell(Instance *instance) : instance_(instance) {
+Spell::Spell(Instance *instance)
+    : instance_(instance),
+      idleReleaser_(instance, "spell", [this]() { return releaseData(); }) {
 #ifdef ENABLE_ENCHANT
     backends_.emplace(SpellProvider::Enchant,
                       std::make_unique<SpellEnchant>(this));
@@ -26,12 +30,26 @@ Spell::Spell(Instance *instance) : instance_(instance) {
     backends_.emplace(SpellProvider::Custom,
                       std::make_unique<SpellCustom>(this));
 
+    setMemoryUsageCallback([this]() { return memoryUsageImpl(); });
+    setTrimMemoryCallback([this]() { trimMemoryImpl(); });
+    setCacheStatisticsCallback(
+        [this]() { return idleReleaser_.statistics(); });
     reloadConfig();
 }
 
-Spell::~Spell() {}
+Spell::~Spell() {
+    // Stop the worker before backends go away.
+    worker_.reset();
+}
 
-void Spell::reloadConfig() { readAsIni(config_, "conf/spell.conf"); }
+void Spell::reloadConfig() {
+    // Provider order is read by worker.
+    std::lock_guard<std::mutex> lock(backendMutex_);
+    readAsIni(config_, "conf/spell.conf");
+    checkDictCache_.clear();
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    hintCache_.clear();
+}
 
 Spell::BackendMap::iterator Spell::findBackend(const std::string &language) {
     for (auto backend : config_.providerOrder.value()) {
@@ -53,39 +71,130 @@ Spell::BackendMap::iterator Spell::findBackend(const std::string &language,
 }
 
 bool Spell::checkDict(const std::string &language) {
+    if (auto *result = findValue(checkDictCache_, language)) {
+        return *result;
+    }
+    std::unique_lock<std::mutex> lock(backendMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        // Worker is computing a hint, don't cache so it is checked again.
+        return false;
+    }
     auto iter = findBackend(language);
-    return iter != backends_.end();
+    auto result = iter != backends_.end();
+    checkDictCache_[language] = result;
+    return result;
 }
 
 void Spell::addWord(const std::string &language, const std::string &word) {
+    std::lock_guard<std::mutex> lock(backendMutex_);
     auto iter = findBackend(language);
     if (iter == backends_.end()) {
         return;
     }
 
     iter->second->addWord(language, word);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    hintCache_.erase(language);
 }
 
-std::vector<std::string> Spell::hint(const std::string &language,
-                                     const std::string &word, size_t limit) {
-    auto iter = findBackend(language);
+std::vector<std::string>
+Spell::lookupHint(const std::string &language,
+                  std::optional<SpellProvider> provider,
+                  const std::string &word, size_t limit, bool wait) {
+    auto key = stringutils::concat(
+        provider ? static_cast<int>(*provider) : -1, ":", limit, ":", word);
+    {
+        std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+        if (auto *cache = findValue(hintCache_, language)) {
+            if (const auto *result = cache->find(key)) {
+                return *result;
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(backendMutex_, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return {};
+    }
+    auto iter = provider ? findBackend(language, *provider)
+                         : findBackend(language);
     if (iter == backends_.end()) {
         return {};
     }
 
-    return iter->second->hint(language, word, limit);
+    auto result = iter->second->hint(language, word, limit);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    hintCache_[language].insert(key, result);
+    return result;
+}
+
+std::vector<std::string> Spell::hint(const std::string &language,
+                                     const std::string &word, size_t limit) {
+    idleReleaser_.touch();
+    return lookupHint(language, std::nullopt, word, limit, false);
+}
+
+std::vector<std::string> Spell::computeHint(const std::string &language,
+                                            const std::string &word,
+                                            size_t limit) {
+    return lookupHint(language, std::nullopt, word, limit, true);
 }
 
 std::vector<std::string> Spell::hintWithProvider(const std::string &language,
                                                  SpellProvider provider,
                                                  const std::string &word,
                                                  size_t limit) {
-    auto iter = findBackend(language, provider);
-    if (iter == backends_.end()) {
-        return {};
+    idleReleaser_.touch();
+    return lookupHint(language, provider, word, limit, false);
+}
+
+AddonMemoryUsage Spell::memoryUsageImpl() const {
+    std::lock_guard<std::mutex> lock(backendMutex_);
+    std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+    size_t hintCache = 0;
+    for (const auto &[language, cache] : hintCache_) {
+        hintCache += language.capacity() + cache.memoryUsage();
+    }
+    AddonMemoryUsage usage{{"hintCache", hintCache}};
+    for (const auto &[provider, backend] : backends_) {
+        usage.emplace_back(SpellProviderToString(provider),
+                           backend->memoryUsage());
+    }
+    return usage;
+}
+
+void Spell::trimMemoryImpl() {
+    if (releaseData()) {
+        idleReleaser_.markReleased();
+    }
+}
+
+bool Spell::releaseData() {
+    {
+        std::lock_guard<std::mutex> cacheLock(cacheMutex_);
+        hintCache_.clear();
     }
+    // Try again later if worker is using the backends.
+    std::unique_lock<std::mutex> lock(backendMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+    for (auto &[provider, backend] : backends_) {
+        backend->trimMemory();
+    }
+    return true;
+}
 
-    return iter->second->hint(language, word, limit);
+std::unique_ptr<HandlerTableEntry<SpellHintCallback>>
+Spell::hintAsync(const std::string &language, const std::string &word,
+                 size_t limit, SpellHintCallback callback) {
+    idleReleaser_.touch();
+    if (!worker_) {
+        worker_ = std::make_unique<SpellWorker>(this, &instance_->eventLoop());
+    }
+    return worker_->addTask(language, word, limit, std::move(callback));
 }
 
 class SpellModuleFactory : public AddonFactory {
@@ -95,4 +204,4 @@ class SpellModuleFactory : public AddonFactory {
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::SpellModuleFactory)
+FCITX_ADDON_FACTORY_V2(spell, fcitx::SpellModuleFactory)
@@ -7,12 +7,17 @@
 #ifndef _FCITX_MODULES_SPELL_SPELL_H_
 #define _FCITX_MODULES_SPELL_SPELL_H_
 
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include "fcitx-config/configuration.h"
 #include "fcitx-config/enum.h"
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/i18n.h"
+#include "fcitx-utils/misc_p.h"
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
+#include "fcitx/idlecache_p.h"
 #include "fcitx/instance.h"
 #include "spell_public.h"
 
@@ -42,6 +47,50 @@ FCITX_CONFIGURATION(SpellConfig,
 
 class Spell;
 class SpellBackend;
+class SpellWorker;
+
+// Recently computed hints of one language. Typing a word usually queries the
+// same prefixes again after backspace, so keep a small LRU of results.
+class SpellHintCache {
+public:
+    const std::vector<std::string> *find(const std::string &key) {
+        auto iter = results_.find(key);
+        if (iter == results_.end()) {
+            return nullptr;
+        }
+        order_.moveToTop(key);
+        return &iter->second;
+    }
+
+    size_t memoryUsage() const {
+        size_t size = 0;
+        for (const auto &[key, result] : results_) {
+            // Key is stored in both order_ and results_.
+            size += key.capacity() * 2;
+            for (const auto &str : result) {
+                size += sizeof(std::string) + str.capacity();
+            }
+        }
+        return size;
+    }
+
+    void insert(const std::string &key, std::vector<std::string> result) {
+        if (!order_.pushFront(key)) {
+            order_.moveToTop(key);
+        }
+        results_[key] = std::move(result);
+        while (order_.size() > maxSize) {
+            results_.erase(*order_.order().rbegin());
+            order_.pop();
+        }
+    }
+
+    static constexpr size_t maxSize = 128;
+
+private:
+    OrderedSet<std::string> order_;
+    std::unordered_map<std::string, std::vector<std::string>> results_;
+};
 
 class Spell final : public AddonInstance {
 public:
@@ -66,12 +115,18 @@ public:
                                               SpellProvider provider,
                                               const std::string &word,
                                               size_t limit);
+    std::unique_ptr<HandlerTableEntry<SpellHintCallback>>
+    hintAsync(const std::string &language, const std::string &word,
+              size_t limit, SpellHintCallback callback);
 
 private:
+    friend class SpellWorker;
+
     FCITX_ADDON_EXPORT_FUNCTION(Spell, checkDict);
     FCITX_ADDON_EXPORT_FUNCTION(Spell, addWord);
     FCITX_ADDON_EXPORT_FUNCTION(Spell, hint);
     FCITX_ADDON_EXPORT_FUNCTION(Spell, hintWithProvider);
+    FCITX_ADDON_EXPORT_FUNCTION(Spell, hintAsync);
     SpellConfig config_;
     typedef std::unordered_map<SpellProvider, std::unique_ptr<SpellBackend>,
                                EnumHash>
@@ -81,7 +136,35 @@ private:
     BackendMap::iterator findBackend(const std::string &language);
     BackendMap::iterator findBackend(const std::string &language,
                                      SpellProvider provider);
+    // Same as hint, but waits for the backend lock. Called from worker
+    // thread.
+    std::vector<std::string> computeHint(const std::string &language,
+                                         const std::string &word,
+                                         size_t limit);
+    bool releaseData();
+    AddonMemoryUsage memoryUsageImpl() const;
+    void trimMemoryImpl();
+    // Look up the cache first, then the backend. If wait is false, return
+    // empty result instead of waiting for the backend lock. No provider means
+    // the first provider that supports the language.
+    std::vector<std::string> lookupHint(const std::string &language,
+                                        std::optional<SpellProvider> provider,
+                                        const std::string &word, size_t limit,
+                                        bool wait);
     Instance *instance_;
+    // Backends are shared with the worker thread, every access to them need
+    // to hold this lock. Worker holds it for the whole lookup, so main thread
+    // only uses try_lock on key event paths.
+    mutable std::mutex backendMutex_;
+    // Result of checkDict, only accessed by main thread.
+    std::unordered_map<std::string, bool> checkDictCache_;
+    // Protects hintCache_, only held for a single cache lookup or insert.
+    // May be locked while holding backendMutex_, never the other way around.
+    mutable std::mutex cacheMutex_;
+    // Per language hint cache.
+    std::unordered_map<std::string, SpellHintCache> hintCache_;
+    std::unique_ptr<SpellWorker> worker_;
+    IdleCacheReleaser idleReleaser_;
 };
 
 class SpellBackend {
@@ -95,6 +178,8 @@ public:
     virtual std::vector<std::string> hint(const std::string &language,
                                           const std::string &word,
                                           size_t limit) = 0;
+    virtual size_t memoryUsage() const { return 0; }
+    virtual void trimMemory() {}
 
     const SpellConfig &config() { return parent_->config(); }
 
@@ -7,18 +7,29 @@
 #ifndef _FCITX_MODULES_SPELL_SPELL_PUBLIC_H_
 #define _FCITX_MODULES_SPELL_SPELL_PUBLIC_H_
 
+#include <functional>
+#include <memory>
 #include <vector>
+#include <fcitx-utils/handlertable.h>
 #include <fcitx/addoninstance.h>
 
 namespace fcitx {
 enum class SpellProvider { Presage, Custom, Enchant };
-}
 
+using SpellHintCallback =
+    std::function<void(const std::vector<std::string> &)>;
+} // namespace fcitx
+
+/// Never waits for the worker thread of hintAsync. If the worker is busy when
+/// the language is checked for the first time, it returns false and checks
+/// again on next call.
 FCITX_ADDON_DECLARE_FUNCTION(Spell, checkDict,
                              bool(const std::string &language));
 FCITX_ADDON_DECLARE_FUNCTION(Spell, addWord,
                              void(const std::string &language,
                                   const std::string &word));
+/// Never waits for the worker thread of hintAsync. If the result is not cached
+/// and the worker is busy, the result is empty.
 FCITX_ADDON_DECLARE_FUNCTION(
     Spell, hint,
     std::vector<std::string>(const std::string &language,
@@ -29,4 +40,12 @@ FCITX_ADDON_DECLARE_FUNCTION(
                              fcitx::SpellProvider provider,
                              const std::string &word, size_t limit));
 
+/// Compute the hint in a worker thread, the callback is invoked in the main
+/// thread with the result. Destroy the returned handle to cancel the request.
+FCITX_ADDON_DECLARE_FUNCTION(
+    Spell, hintAsync,
+    std::unique_ptr<HandlerTableEntry<SpellHintCallback>>(
+        const std::string &language, const std::string &word, size_t limit,
+        SpellHintCallback callback));
+
 #endif // _FCITX_MODULES_SPELL_SPELL_PUBLIC_H_
@@ -20,10 +20,12 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <fmt/format.h>
 #include "fcitx-utils/charutils.h"
+#include "fcitx-utils/diskcache.h"
 #include "fcitx-utils/endian_p.h"
 #include "fcitx-utils/fs.h"
 #include "fcitx-utils/i18n.h"
@@ -95,12 +97,91 @@ bool CharSelectData::load() {
         return false;
     };
 
-    createIndex();
+    DiskCache cache("unicode-charselectdata", 1);
+    cache.addSourceFile(file.path());
+    if (!loadIndex(cache)) {
+        createIndex();
+        saveIndex(cache);
+    }
 
     loadResult_ = true;
     return true;
 }
 
+bool CharSelectData::loadIndex(const DiskCache &cache) {
+    auto data = cache.load();
+    if (!data) {
+        return false;
+    }
+    DiskCacheReader reader(data->view());
+    uint32_t size;
+    if (!reader.readUInt32(size)) {
+        return false;
+    }
+    index_.reserve(size);
+    indexList_.reserve(size);
+    for (uint32_t i = 0; i < size; i++) {
+        std::string key;
+        uint32_t count;
+        if (!reader.readString(key) || !reader.readUInt32(count)) {
+            break;
+        }
+        std::vector<uint32_t> chars;
+        chars.reserve(count);
+        for (uint32_t j = 0; j < count; j++) {
+            uint32_t c;
+            if (!reader.readUInt32(c)) {
+                break;
+            }
+            chars.push_back(c);
+        }
+        if (chars.size() != count) {
+            break;
+        }
+        auto result = index_.emplace(std::move(key), std::move(chars));
+        // The entries are saved in the order of indexList_.
+        indexList_.push_back(&*result.first);
+    }
+    if (indexList_.size() != size || !reader.atEnd()) {
+        indexList_ = {};
+        index_ = {};
+        return false;
+    }
+    return true;
+}
+
+void CharSelectData::saveIndex(const DiskCache &cache) const {
+    DiskCacheWriter writer;
+    writer.writeUInt32(indexList_.size());
+    for (const auto *item : indexList_) {
+        writer.writeString(item->first);
+        writer.writeUInt32(item->second.size());
+        for (auto c : item->second) {
+            writer.writeUInt32(c);
+        }
+    }
+    cache.save(writer.data());
+}
+
+void CharSelectData::unload() {
+    loaded_ = false;
+    loadResult_ = false;
+    indexList_ = {};
+    index_ = {};
+    data_ = {};
+}
+
+size_t CharSelectData::memoryUsage() const {
+    size_t size = data_.capacity() +
+                  indexList_.capacity() * sizeof(indexList_[0]) +
+                  index_.bucket_count() * sizeof(void *);
+    for (const auto &[key, value] : index_) {
+        size += sizeof(decltype(index_)::value_type) + key.capacity() +
+                value.capacity() * sizeof(uint32_t);
+    }
+    return size;
+}
+
 std::vector<std::string> CharSelectData::unihanInfo(uint32_t unicode) const {
     if (!loadResult_) {
         return {};
@@ -299,7 +380,34 @@ bool IsHexString(const std::string &s) {
     return 1;
 }
 
-std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
+namespace {
+
+// Return the index of the first word that need to be matched, if the chars of
+// previous words can be narrowed down for words.
+std::optional<size_t> refineFrom(const std::vector<std::string> &previous,
+                                 const std::vector<std::string> &words) {
+    if (previous.empty() || previous.size() > words.size()) {
+        return std::nullopt;
+    }
+    const auto last = previous.size() - 1;
+    if (!std::equal(previous.begin(), previous.begin() + last,
+                    words.begin())) {
+        return std::nullopt;
+    }
+    // Matching is by prefix, a longer word matches less.
+    if (!stringutils::startsWith(words[last], previous[last])) {
+        return std::nullopt;
+    }
+    return words[last] == previous[last] ? previous.size() : last;
+}
+
+} // namespace
+
+std::vector<uint32_t>
+CharSelectData::find(const std::string &needle,
+                     const std::function<bool()> &isCancelled,
+                     const CharSelectMatch *previous,
+                     CharSelectMatch *match) const {
     if (!loadResult_) {
         return {};
     }
@@ -340,23 +448,42 @@ std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
         }
     }
 
-    for (auto &s : searchStrings) {
-        auto partResult = matchingChars(s);
-        if (result.empty()) {
+    size_t first = 0;
+    bool matched = false;
+    if (previous) {
+        if (auto from = refineFrom(previous->words, searchStrings)) {
+            first = *from;
+            result = previous->chars;
+            matched = true;
+        }
+    }
+    for (auto iter = searchStrings.begin() + first;
+         iter != searchStrings.end() && !(matched && result.empty());
+         ++iter) {
+        if (isCancelled && isCancelled()) {
+            return {};
+        }
+        auto partResult = matchingChars(*iter, isCancelled);
+        if (!matched) {
             result = std::move(partResult);
+            matched = true;
         } else {
-            auto iter = result.begin();
-            while (iter != result.end()) {
-                if (partResult.count(*iter)) {
-                    iter++;
+            auto resultIter = result.begin();
+            while (resultIter != result.end()) {
+                if (partResult.count(*resultIter)) {
+                    resultIter++;
                 } else {
-                    iter = result.erase(iter);
+                    resultIter = result.erase(resultIter);
                 }
             }
         }
-        if (result.empty()) {
-            break;
-        }
+    }
+    if (isCancelled && isCancelled()) {
+        return {};
+    }
+    if (match) {
+        match->words = searchStrings;
+        match->chars = result;
     }
 
     // remove results found by matching the code point to prevent duplicate
@@ -371,8 +498,11 @@ std::vector<uint32_t> CharSelectData::find(const std::string &needle) const {
     return returnRes;
 }
 
-std::set<uint32_t> CharSelectData::matchingChars(const std::string &s) const {
+std::set<uint32_t>
+CharSelectData::matchingChars(const std::string &s,
+                              const std::function<bool()> &isCancelled) const {
     std::set<uint32_t> result;
+    size_t checked = 0;
     auto iter = std::lower_bound(
         indexList_.begin(), indexList_.end(), s, [](auto lhs, auto rhs) {
             return strcasecmp(lhs->first.c_str(), rhs.c_str()) < 0;
@@ -380,6 +510,9 @@ std::set<uint32_t> CharSelectData::matchingChars(const std::string &s) const {
 
     while (iter != indexList_.end() &&
            strncasecmp(s.c_str(), (*iter)->first.c_str(), s.size()) == 0) {
+        if (isCancelled && ++checked % 256 == 0 && isCancelled()) {
+            return {};
+        }
         for (auto c : (*iter)->second) {
             result.insert(c);
         }
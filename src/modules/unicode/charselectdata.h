@@ -7,24 +7,52 @@
 #ifndef _FCITX_MODULES_UNICODE_CHARSELECTDATA_H_
 #define _FCITX_MODULES_UNICODE_CHARSELECTDATA_H_
 
+#include <functional>
 #include <set>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+namespace fcitx {
+class DiskCache;
+}
+
+// Characters whose names match every word of a query.
+struct CharSelectMatch {
+    std::vector<std::string> words;
+    std::set<uint32_t> chars;
+};
+
 class CharSelectData {
 public:
     CharSelectData();
 
     std::string name(uint32_t unicode) const;
     std::vector<std::string> unihanInfo(uint32_t unicode) const;
-    std::vector<uint32_t> find(const std::string &needle) const;
+    // isCancelled is polled so a search in other thread may stop early, the
+    // result is incomplete in that case.
+    //
+    // If the query extends the one of previous, e.g. "latin s" after
+    // "latin", only the changed words are matched against the chars of
+    // previous. match is set to the result for the next query if search is
+    // not cancelled.
+    std::vector<uint32_t>
+    find(const std::string &needle,
+         const std::function<bool()> &isCancelled = {},
+         const CharSelectMatch *previous = nullptr,
+         CharSelectMatch *match = nullptr) const;
 
     bool load();
+    // Drop the loaded data, load() need to be called again before use.
+    void unload();
+    size_t memoryUsage() const;
 
 private:
     void createIndex();
+    // Index is cached on disk, keyed by the data file.
+    bool loadIndex(const fcitx::DiskCache &cache);
+    void saveIndex(const fcitx::DiskCache &cache) const;
     void appendToIndex(uint32_t unicode, const std::string &str);
     uint32_t findDetailIndex(uint32_t unicode) const;
 
@@ -38,7 +66,9 @@ private:
     std::vector<std::string> equivalents(uint32_t unicode) const;
     std::vector<std::string> approximateEquivalents(uint32_t unicode) const;
 
-    std::set<uint32_t> matchingChars(const std::string &s) const;
+    std::set<uint32_t>
+    matchingChars(const std::string &s,
+                  const std::function<bool()> &isCancelled) const;
 
     bool loaded_ = false;
     bool loadResult_ = false;
@@ -5,6 +5,8 @@
  *
  */
 #include "unicode.h"
+#include <memory>
+#include <optional>
 #include <fmt/format.h>
 #include "fcitx-utils/i18n.h"
 #include "fcitx-utils/inputbuffer.h"
@@ -13,6 +15,7 @@
 #include "fcitx/inputcontext.h"
 #include "fcitx/inputcontextmanager.h"
 #include "fcitx/inputpanel.h"
+#include "fcitx/workerpool.h"
 
 namespace fcitx {
 
@@ -23,8 +26,21 @@ public:
     bool enabled_ = false;
     InputBuffer buffer_;
     Unicode *q_;
+    // Search running in worker thread, candidate list is from previous query
+    // until it finishes.
+    std::unique_ptr<WorkerJob> searchJob_;
+    // Match of the last finished query, a longer query narrows it down.
+    std::shared_ptr<const CharSelectMatch> match_;
+    // Selection made before the search finishes, applied to its result. -1
+    // selects the candidate at cursor.
+    std::optional<int> pendingSelection_;
+
+    bool searching() const { return searchJob_ != nullptr; }
 
     void reset(InputContext *ic) {
+        searchJob_.reset();
+        match_.reset();
+        pendingSelection_.reset();
         enabled_ = false;
         buffer_.clear();
         buffer_.shrinkToFit();
@@ -54,11 +70,56 @@ public:
     Unicode *q_;
 };
 
+// Query like "a" may match tens of thousands of characters, only create the
+// candidate words when the page is about to be shown.
+class UnicodeCandidateList : public CommonCandidateList {
+public:
+    UnicodeCandidateList(Unicode *q, std::vector<uint32_t> chars)
+        : q_(q), chars_(std::move(chars)) {}
+
+    // Make sure the page and the one after it are filled.
+    void fillPage(int page) {
+        const auto needed = static_cast<size_t>(page + 2) * pageSize();
+        while (static_cast<size_t>(totalSize()) < needed &&
+               next_ < chars_.size()) {
+            auto c = chars_[next_++];
+            if (utf8::UCS4IsValid(c)) {
+                append<UnicodeCandidateWord>(q_, c);
+            }
+        }
+    }
+
+    bool hasNext() const override {
+        return CommonCandidateList::hasNext() || next_ < chars_.size();
+    }
+
+    void setPage(int page) override {
+        fillPage(page);
+        CommonCandidateList::setPage(page);
+    }
+
+    void nextCandidate() override {
+        CommonCandidateList::nextCandidate();
+        fillPage(currentPage());
+    }
+
+private:
+    Unicode *q_;
+    std::vector<uint32_t> chars_;
+    size_t next_ = 0;
+};
+
 Unicode::Unicode(Instance *instance)
     : instance_(instance),
-      factory_([this](InputContext &) { return new UnicodeState(this); }) {
+      factory_([this](InputContext &) { return new UnicodeState(this); }),
+      idleReleaser_(instance, "charSelectData",
+                    [this]() { return releaseData(); }) {
     instance_->inputContextManager().registerProperty("unicodeState",
                                                       &factory_);
+    setMemoryUsageCallback([this]() { return memoryUsageImpl(); });
+    setTrimMemoryCallback([this]() { trimMemoryImpl(); });
+    setCacheStatisticsCallback(
+        [this]() { return idleReleaser_.statistics(); });
 
     KeySym syms[] = {
         FcitxKey_1, FcitxKey_2, FcitxKey_3, FcitxKey_4, FcitxKey_5,
@@ -115,6 +176,17 @@ Unicode::Unicode(Instance *instance)
             }
 
             auto candidateList = inputContext->inputPanel().candidateList();
+            // Don't select from the result of previous query, select from the
+            // one being searched once it is ready.
+            if (state->searching()) {
+                int idx = keyEvent.key().keyListIndex(selectionKeys_);
+                if (idx >= 0 || keyEvent.key().check(FcitxKey_Return) ||
+                    keyEvent.key().check(FcitxKey_KP_Enter)) {
+                    keyEvent.accept();
+                    state->pendingSelection_ = idx;
+                    return;
+                }
+            }
             if (candidateList) {
                 int idx = keyEvent.key().keyListIndex(selectionKeys_);
                 if (idx >= 0) {
@@ -182,7 +254,7 @@ Unicode::Unicode(Instance *instance)
             if (keyEvent.key().check(FcitxKey_Return) ||
                 keyEvent.key().check(FcitxKey_KP_Enter)) {
                 keyEvent.accept();
-                if (candidateList->size() > 0 &&
+                if (candidateList && candidateList->size() > 0 &&
                     candidateList->cursorIndex() >= 0) {
                     candidateList->candidate(candidateList->cursorIndex())
                         .select(inputContext);
@@ -229,8 +301,94 @@ Unicode::Unicode(Instance *instance)
 
 Unicode::~Unicode() {}
 
+AddonMemoryUsage Unicode::memoryUsageImpl() const {
+    return {{"charSelectData", data_->memoryUsage()}};
+}
+
+void Unicode::trimMemoryImpl() {
+    if (releaseData()) {
+        idleReleaser_.markReleased();
+    }
+}
+
+bool Unicode::releaseData() {
+    // Data is still used by any input context in unicode mode.
+    bool inUse = !instance_->inputContextManager().foreach(
+        [this](InputContext *ic) {
+            return !ic->hasProperty(&factory_) ||
+                   !ic->propertyFor(&factory_)->enabled_;
+        });
+    if (inUse) {
+        return false;
+    }
+    // A cancelled search may still be running with the old data.
+    data_ = std::make_shared<CharSelectData>();
+    return true;
+}
+
+void Unicode::search(InputContext *inputContext, const std::string &query) {
+    auto *state = inputContext->propertyFor(&factory_);
+    // Selection is for the previous query.
+    state->pendingSelection_.reset();
+    auto match = std::make_shared<CharSelectMatch>();
+    // Replacing the job cancels the search of previous query. The job only
+    // uses the data it holds, so don't wait for it on every key press.
+    state->searchJob_ = instance_->workerPool().submit(
+        WorkerJobPriority::Interactive,
+        [data = data_, query, previous = state->match_,
+         match](const WorkerJobToken &token) {
+            return data->find(
+                query, [&token]() { return token.isCancelled(); },
+                previous.get(), match.get());
+        },
+        [this, ref = inputContext->watch(),
+         match](std::vector<uint32_t> result) {
+            if (auto *ic = ref.get()) {
+                ic->propertyFor(&factory_)->match_ = match;
+                setSearchResult(ic, std::move(result));
+            }
+        });
+    state->searchJob_->detach();
+}
+
+void Unicode::setSearchResult(InputContext *inputContext,
+                              std::vector<uint32_t> result) {
+    auto *state = inputContext->propertyFor(&factory_);
+    state->searchJob_.reset();
+    auto pendingSelection = state->pendingSelection_;
+    state->pendingSelection_.reset();
+    auto candidateList =
+        std::make_unique<UnicodeCandidateList>(this, std::move(result));
+    candidateList->setPageSize(instance_->globalConfig().defaultPageSize());
+    candidateList->fillPage(0);
+    if (candidateList->size()) {
+        candidateList->setGlobalCursorIndex(0);
+    }
+    candidateList->setSelectionKey(selectionKeys_);
+    candidateList->setLayoutHint(CandidateLayoutHint::Vertical);
+    inputContext->inputPanel().setCandidateList(std::move(candidateList));
+    inputContext->updateUserInterface(UserInterfaceComponent::InputPanel);
+    if (pendingSelection) {
+        auto list = inputContext->inputPanel().candidateList();
+        int idx = *pendingSelection >= 0 ? *pendingSelection
+                                         : list->cursorIndex();
+        if (idx >= 0 && idx < list->size()) {
+            list->candidate(idx).select(inputContext);
+        }
+    }
+    for (const auto &callback : searchFinishedCallbacks_.view()) {
+        callback(inputContext);
+    }
+}
+
+std::unique_ptr<HandlerTableEntry<UnicodeSearchFinishedCallback>>
+Unicode::addSearchFinishedCallback(UnicodeSearchFinishedCallback callback) {
+    return searchFinishedCallbacks_.add(std::move(callback));
+}
+
 bool Unicode::trigger(InputContext *inputContext) {
-    if (!data_.load())
+    idleReleaser_.touch();
+    if (!data_->load())
         return false;
     auto *state = inputContext->propertyFor(&factory_);
     state->enabled_ = true;
@@ -239,23 +397,17 @@ bool Unicode::trigger(InputContext *inputContext) {
 }
 void Unicode::updateUI(InputContext *inputContext, bool trigger) {
     auto *state = inputContext->propertyFor(&factory_);
-    inputContext->inputPanel().reset();
     if (!state->buffer_.empty()) {
-        auto result = data_.find(state->buffer_.userInput());
-        auto candidateList = std::make_unique<CommonCandidateList>();
-        candidateList->setPageSize(instance_->globalConfig().defaultPageSize());
-        for (auto c : result) {
-            if (utf8::UCS4IsValid(c)) {
-                candidateList->append<UnicodeCandidateWord>(this, c);
-            }
-        }
-        if (candidateList->size()) {
-            candidateList->setGlobalCursorIndex(0);
-        }
-        candidateList->setSelectionKey(selectionKeys_);
-        candidateList->setLayoutHint(CandidateLayoutHint::Vertical);
-        inputContext->inputPanel().setCandidateList(std::move(candidateList));
-    } else if (trigger) {
+        // Keep showing the previous result until the search finishes, the new
+        // one usually refines it.
+        search(inputContext, state->buffer_.userInput());
+    } else {
+        inputContext->inputPanel().reset();
+        state->searchJob_.reset();
+        state->match_.reset();
+        state->pendingSelection_.reset();
+    }
+    if (trigger && state->buffer_.empty()) {
         auto candidateList = std::make_unique<CommonCandidateList>();
 
         std::vector<std::string> selectedTexts;
@@ -293,7 +445,7 @@ void Unicode::updateUI(InputContext *inputContext, bool trigger) {
                 if (!seenChar.insert(c).second) {
                     continue;
                 }
-                auto name = data_.name(c);
+                auto name = data_->name(c);
                 std::string display;
                 if (!name.empty()) {
                     display = fmt::format("{0} U+{1:04X} {2}",
@@ -342,4 +494,4 @@ class UnicodeModuleFactory : public AddonFactory {
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::UnicodeModuleFactory);
+FCITX_ADDON_FACTORY_V2(unicode, fcitx::UnicodeModuleFactory);
@@ -8,6 +8,7 @@
 #define _FCITX_MODULES_UNICODE_UNICODE_H_
 
 #include <map>
+#include <memory>
 #include "fcitx-config/configuration.h"
 #include "fcitx-config/enum.h"
 #include "fcitx-config/iniparser.h"
@@ -17,6 +18,7 @@
 #include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/idlecache_p.h"
 #include "fcitx/inputcontextproperty.h"
 #include "fcitx/instance.h"
 #include "charselectdata.h"
@@ -43,10 +45,12 @@ public:
     Instance *instance() { return instance_; }
 
     bool trigger(InputContext *inputContext);
+    std::unique_ptr<HandlerTableEntry<UnicodeSearchFinishedCallback>>
+        addSearchFinishedCallback(UnicodeSearchFinishedCallback callback);
     void updateUI(InputContext *inputContext, bool trigger = false);
     auto &factory() { return factory_; }
 
-    const CharSelectData &data() const { return data_; }
+    const CharSelectData &data() const { return *data_; }
 
     void reloadConfig() override { readAsIni(config_, configFile); }
 
@@ -60,13 +64,24 @@ public:
 
 private:
     FCITX_ADDON_EXPORT_FUNCTION(Unicode, trigger);
+    FCITX_ADDON_EXPORT_FUNCTION(Unicode, addSearchFinishedCallback);
+    bool releaseData();
+    AddonMemoryUsage memoryUsageImpl() const;
+    void trimMemoryImpl();
+    void search(InputContext *inputContext, const std::string &query);
+    void setSearchResult(InputContext *inputContext,
+                         std::vector<uint32_t> result);
+
     Instance *instance_;
     UnicodeConfig config_;
-    CharSelectData data_;
+    // Shared with the running search.
+    std::shared_ptr<CharSelectData> data_ = std::make_shared<CharSelectData>();
     std::vector<std::unique_ptr<fcitx::HandlerTableEntry<fcitx::EventHandler>>>
         eventHandlers_;
     KeyList selectionKeys_;
     FactoryFor<UnicodeState> factory_;
+    HandlerTable<UnicodeSearchFinishedCallback> searchFinishedCallbacks_;
+    IdleCacheReleaser idleReleaser_;
 };
 } // namespace fcitx
 
@@ -8,9 +8,24 @@
 #define _FCITX_MODULES_UNICODE_UNICODE_PUBLIC_H_
 
 #include <functional>
+#include <memory>
+#include <fcitx-utils/handlertable.h>
 #include <fcitx/addoninstance.h>
 #include <fcitx/inputcontext.h>
 
+namespace fcitx {
+
+using UnicodeSearchFinishedCallback = std::function<void(InputContext *ic)>;
+
+} // namespace fcitx
+
 FCITX_ADDON_DECLARE_FUNCTION(Unicode, trigger, bool(InputContext *ic));
 
+/// Callback is called after the result of a search is set as the candidate
+/// list of the input context. Results of cancelled searches are never set.
+FCITX_ADDON_DECLARE_FUNCTION(
+    Unicode, addSearchFinishedCallback,
+    std::unique_ptr<HandlerTableEntry<UnicodeSearchFinishedCallback>>(
+        UnicodeSearchFinishedCallback));
+
 #endif // _FCITX_MODULES_UNICODE_UNICODE_PUBLIC_H_
@@ -13,6 +13,7 @@
 #include <fcitx-utils/metastring.h>
 #include <fcitx/addoninstance.h>
 #include <fcitx/focusgroup.h>
+#include <fcitx/keycodetable.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_ewmh.h>
 
@@ -30,6 +31,9 @@ typedef std::function<void(const std::string &name, xcb_connection_t *conn)>
 typedef std::function<void(xcb_atom_t selection)> XCBSelectionNotifyCallback;
 typedef std::function<void(xcb_atom_t, const char *, size_t)>
     XCBConvertSelectionCallback;
+// Reply and error are only valid within the callback.
+typedef std::function<void(void *reply, xcb_generic_error_t *error)>
+    XCBReplyCallback;
 } // namespace fcitx
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, openConnection,
                              void(const std::string &));
@@ -46,6 +50,8 @@ FCITX_ADDON_DECLARE_FUNCTION(
         XCBConnectionClosed));
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, xkbState,
                              xkb_state *(const std::string &));
+FCITX_ADDON_DECLARE_FUNCTION(XCBModule, keycodeTable,
+                             const KeycodeTable *(const std::string &));
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, ewmh,
                              xcb_ewmh_connection_t *(const std::string &));
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, atom,
@@ -67,4 +73,9 @@ FCITX_ADDON_DECLARE_FUNCTION(XCBModule, setXkbOption,
 
 FCITX_ADDON_DECLARE_FUNCTION(XCBModule, mainDisplay, std::string());
 
+// Callback is invoked from main loop once the reply of the request arrives.
+FCITX_ADDON_DECLARE_FUNCTION(XCBModule, waitForReply,
+                             void(const std::string &, unsigned int,
+                                  XCBReplyCallback));
+
 #endif // _FCITX_MODULES_XCB_XCB_PUBLIC_H_
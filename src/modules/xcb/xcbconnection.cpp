@@ -111,7 +111,12 @@ XCBConnection::XCBConnection(XCBModule *xcb, const std::string &name)
         });
     auto &imManager = parent_->instance()->inputMethodManager();
     setDoGrab(imManager.groupCount() > 1);
-    reader_ = std::make_unique<XCBEventReader>(this);
+    reader_ = std::make_unique<XCBEventReader>(
+        this, &parent_->eventReaderThread());
+    for (auto &[sequence, callback] : earlyReplies_) {
+        reader_->waitForReply(sequence, std::move(callback));
+    }
+    earlyReplies_.clear();
 }
 
 XCBConnection::~XCBConnection() {
@@ -236,6 +241,17 @@ void XCBConnection::processEvent() {
     reader_->wakeUp();
 }
 
+void XCBConnection::waitForReply(unsigned int sequence,
+                                 XCBReplyCallback callback) {
+    xcb_flush(conn_.get());
+    // Request sent during initialization.
+    if (!reader_) {
+        earlyReplies_.emplace_back(sequence, std::move(callback));
+        return;
+    }
+    reader_->waitForReply(sequence, std::move(callback));
+}
+
 bool XCBConnection::filterEvent(xcb_connection_t *,
                                 xcb_generic_event_t *event) {
     uint8_t response_type = event->response_type & ~0x80;
@@ -496,6 +512,10 @@ struct xkb_state *XCBConnection::xkbState() {
     return keyboard_->xkbState();
 }
 
+const KeycodeTable *XCBConnection::keycodeTable() {
+    return keyboard_->keycodeTable();
+}
+
 XkbRulesNames XCBConnection::xkbRulesNames() {
     return keyboard_->xkbRulesNames();
 }
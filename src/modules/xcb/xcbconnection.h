@@ -8,18 +8,20 @@
 #define _FCITX_MODULES_XCB_XCBCONNECTION_H_
 
 #include <string>
+#include <utility>
+#include <vector>
 #include <fcitx/instance.h>
 #include <xcb/xcb_keysyms.h>
 #include "fcitx-utils/event.h"
 #include "fcitx-utils/handlertable.h"
 #include "xcb_public.h"
+#include "xcbeventreader.h"
 
 namespace fcitx {
 
 class XCBModule;
 class XCBConvertSelectionRequest;
 class XCBKeyboard;
-class XCBEventReader;
 
 class XCBConnection {
 public:
@@ -44,6 +46,7 @@ public:
     FocusGroup *focusGroup() const { return group_; }
     xcb_window_t root() const { return root_; }
     struct xkb_state *xkbState();
+    const KeycodeTable *keycodeTable();
     XkbRulesNames xkbRulesNames();
     xcb_window_t serverWindow() const { return serverWindow_; }
 
@@ -54,6 +57,7 @@ public:
     void setXkbOption(const std::string &option);
 
     void processEvent();
+    void waitForReply(unsigned int sequence, XCBReplyCallback callback);
 
 private:
     bool filterEvent(xcb_connection_t *conn, xcb_generic_event_t *event);
@@ -114,6 +118,7 @@ private:
     bool keyboardGrabbed_ = false;
 
     std::unique_ptr<XCBEventReader> reader_;
+    std::vector<std::pair<unsigned int, XCBReplyCallback>> earlyReplies_;
 };
 
 } // namespace fcitx
@@ -29,6 +29,7 @@ XCBConvertSelectionRequest::XCBConvertSelectionRequest(
     } else {
         fallbacks_.push_back(type);
     }
+    incrAtom_ = conn->atom("INCR", true);
     xcb_delete_property(conn->connection(), conn->serverWindow(), property_);
     xcb_convert_selection(conn->connection(), conn->serverWindow(), selection_,
                           fallbacks_.back(), property_, XCB_TIME_CURRENT_TIME);
@@ -67,6 +68,13 @@ void XCBConvertSelectionRequest::handleReply(xcb_atom_t type, const char *data,
         return invokeCallbackAndCleanUp(type, data, length);
     }
 
+    // INCR means the data is too large to fit in a single property, which is
+    // larger than anything we want to keep. Other targets will be equally
+    // large, so don't bother to ask for them.
+    if (incrAtom_ && type == incrAtom_) {
+        return invokeCallbackAndCleanUp(XCB_ATOM_NONE, nullptr, 0);
+    }
+
     fallbacks_.pop_back();
     if (fallbacks_.empty()) {
         return invokeCallbackAndCleanUp(XCB_ATOM_NONE, nullptr, 0);
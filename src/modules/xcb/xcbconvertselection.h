@@ -37,6 +37,7 @@ private:
     XCBConnection *conn_ = nullptr;
     xcb_atom_t selection_ = 0;
     xcb_atom_t property_ = 0;
+    xcb_atom_t incrAtom_ = 0;
     std::vector<xcb_atom_t> fallbacks_;
     XCBConvertSelectionCallback realCallback_;
     std::unique_ptr<EventSourceTime> timer_;
@@ -5,17 +5,21 @@
  *
  */
 #include "xcbeventreader.h"
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <xcb/xcbext.h>
 #include "xcbconnection.h"
 #include "xcbmodule.h"
 
 namespace fcitx {
-XCBEventReader::XCBEventReader(XCBConnection *conn) : conn_(conn) {
-    dispatcherToMain_.attach(&conn->instance()->eventLoop());
-    thread_ = std::make_unique<std::thread>(&XCBEventReader::runThread, this);
+
+XCBEventReaderThread::XCBEventReaderThread(Instance *instance) {
+    dispatcherToMain_.attach(&instance->eventLoop());
 }
 
-XCBEventReader::~XCBEventReader() {
-    if (thread_->joinable()) {
+XCBEventReaderThread::~XCBEventReaderThread() {
+    if (thread_ && thread_->joinable()) {
         dispatcherToWorker_.schedule([dispatcher = &dispatcherToWorker_]() {
             dispatcher->eventLoop()->exit();
         });
@@ -23,6 +27,69 @@ XCBEventReader::~XCBEventReader() {
     }
 }
 
+void XCBEventReaderThread::start() {
+    if (thread_) {
+        return;
+    }
+    thread_ =
+        std::make_unique<std::thread>(&XCBEventReaderThread::runThread, this);
+}
+
+void XCBEventReaderThread::scheduleToMain(std::function<void()> functor) {
+    dispatcherToMain_.schedule(std::move(functor));
+}
+
+void XCBEventReaderThread::scheduleToWorker(std::function<void()> functor) {
+    dispatcherToWorker_.schedule(std::move(functor));
+}
+
+void XCBEventReaderThread::runInWorker(const std::function<void()> &functor) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    dispatcherToWorker_.schedule([&functor, &promise]() {
+        functor();
+        promise.set_value();
+    });
+    future.wait();
+}
+
+void XCBEventReaderThread::run() {
+    EventLoop event;
+    dispatcherToWorker_.attach(&event);
+
+    FCITX_XCB_DEBUG() << "Start XCBEventReader thread";
+
+    event.exec();
+    dispatcherToWorker_.detach();
+
+    FCITX_XCB_DEBUG() << "End XCBEventReader thread";
+}
+
+XCBEventReader::XCBEventReader(XCBConnection *conn,
+                               XCBEventReaderThread *thread)
+    : conn_(conn), thread_(thread) {
+    thread_->start();
+    thread_->scheduleToWorker([this]() {
+        int fd = xcb_get_file_descriptor(conn_->connection());
+        ioEvent_ = thread_->eventLoop()->addIOEvent(
+            fd, IOEventFlag::In,
+            [this](EventSource *source, int, IOEventFlags flags) {
+                if (!onIOEvent(flags)) {
+                    // Only stop reading this connection, others are not
+                    // affected.
+                    source->setEnabled(false);
+                }
+                return true;
+            });
+    });
+}
+
+XCBEventReader::~XCBEventReader() {
+    // Functions scheduled before are executed first, after this the reader
+    // thread no longer uses this object.
+    thread_->runInWorker([this]() { ioEvent_.reset(); });
+}
+
 auto nextXCBEvent(xcb_connection_t *conn, IOEventFlags flags) {
     if (flags.test(IOEventFlag::In)) {
         return makeUniqueCPtr(xcb_poll_for_event(conn));
@@ -38,11 +105,16 @@ bool XCBEventReader::onIOEvent(IOEventFlags flags) {
         hadError_ = true;
         FCITX_WARN() << "XCB connection \"" << conn_->name()
                      << "\" got error: " << err;
-        dispatcherToMain_.schedule([this]() {
-            deferEvent_ =
-                conn_->parent()->instance()->eventLoop().addDeferEvent(
-                    [this](EventSource *) {
-                        conn_->parent()->removeConnection(conn_->name());
+        thread_->scheduleToMain([ref = watch()]() {
+            auto *that = ref.get();
+            if (!that) {
+                return;
+            }
+            that->deferEvent_ =
+                that->conn_->parent()->instance()->eventLoop().addDeferEvent(
+                    [that](EventSource *) {
+                        that->conn_->parent()->removeConnection(
+                            that->conn_->name());
                         return true;
                     });
         });
@@ -60,35 +132,52 @@ bool XCBEventReader::onIOEvent(IOEventFlags flags) {
         hasEvent = !events_.empty();
     }
     if (hasEvent) {
-        dispatcherToMain_.schedule([this]() { conn_->processEvent(); });
+        thread_->scheduleToMain([ref = watch()]() {
+            if (auto *that = ref.get()) {
+                that->conn_->processEvent();
+            }
+        });
     }
+    collectReplies();
     return true;
 }
 
-void XCBEventReader::wakeUp() {
-    dispatcherToWorker_.schedule([this]() { onIOEvent(IOEventFlags{}); });
+void XCBEventReader::collectReplies() {
+    auto iter = pendingReplies_.begin();
+    while (iter != pendingReplies_.end()) {
+        void *reply = nullptr;
+        xcb_generic_error_t *error = nullptr;
+        if (!xcb_poll_for_reply(conn_->connection(), iter->first, &reply,
+                                &error)) {
+            ++iter;
+            continue;
+        }
+        std::shared_ptr<void> replyPtr(reply, std::free);
+        std::shared_ptr<xcb_generic_error_t> errorPtr(error, std::free);
+        thread_->scheduleToMain([ref = watch(),
+                                 callback = std::move(iter->second), replyPtr,
+                                 errorPtr]() {
+            // Drop the reply if connection is already gone.
+            if (ref.isValid()) {
+                callback(replyPtr.get(), errorPtr.get());
+            }
+        });
+        iter = pendingReplies_.erase(iter);
+    }
 }
 
-void XCBEventReader::run() {
-    EventLoop event;
-    dispatcherToWorker_.attach(&event);
-
-    FCITX_XCB_DEBUG() << "Start XCBEventReader thread";
-
-    int fd = xcb_get_file_descriptor(conn_->connection());
-    auto ioEvent = event.addIOEvent(
-        fd, IOEventFlag::In,
-        [this, &event](EventSource *, int, IOEventFlags flags) {
-            if (!onIOEvent(flags)) {
-                event.exit();
-            }
-            return true;
+void XCBEventReader::waitForReply(unsigned int sequence,
+                                  XCBReplyCallback callback) {
+    thread_->scheduleToWorker(
+        [this, sequence, callback = std::move(callback)]() mutable {
+            pendingReplies_.emplace_back(sequence, std::move(callback));
+            // Reply may be already read by other blocking calls.
+            collectReplies();
         });
-    event.exec();
-    ioEvent.reset();
-    dispatcherToWorker_.detach();
+}
 
-    FCITX_XCB_DEBUG() << "End XCBEventReader thread";
+void XCBEventReader::wakeUp() {
+    thread_->scheduleToWorker([this]() { onIOEvent(IOEventFlags{}); });
 }
 
 } // namespace fcitx
@@ -7,20 +7,48 @@
 #ifndef _FCITX5_MODULES_XCB_XCBEVENTREADER_H_
 #define _FCITX5_MODULES_XCB_XCBEVENTREADER_H_
 
+#include <functional>
+#include <list>
 #include <mutex>
 #include <thread>
+#include <utility>
 #include <fcitx-utils/event.h>
 #include <fcitx-utils/eventdispatcher.h>
+#include <fcitx-utils/trackableobject.h>
 #include <xcb/xcb.h>
 #include "xcb_public.h"
 
 namespace fcitx {
 
+class Instance;
 class XCBConnection;
 
-class XCBEventReader {
+// Reads all XCB connections from one thread, owned by XCBModule.
+class XCBEventReaderThread {
 public:
-    XCBEventReader(XCBConnection *conn);
+    XCBEventReaderThread(Instance *instance);
+    ~XCBEventReaderThread();
+
+    // Thread is started when first connection is added.
+    void start();
+    void scheduleToMain(std::function<void()> functor);
+    void scheduleToWorker(std::function<void()> functor);
+    // Run functor in reader thread, and wait for it to finish.
+    void runInWorker(const std::function<void()> &functor);
+    // Only accessed from reader thread.
+    EventLoop *eventLoop() { return dispatcherToWorker_.eventLoop(); }
+
+private:
+    static void runThread(XCBEventReaderThread *self) { self->run(); }
+    void run();
+    EventDispatcher dispatcherToMain_;
+    EventDispatcher dispatcherToWorker_;
+    std::unique_ptr<std::thread> thread_;
+};
+
+class XCBEventReader : public TrackableObject<XCBEventReader> {
+public:
+    XCBEventReader(XCBConnection *conn, XCBEventReaderThread *thread);
     ~XCBEventReader();
 
     auto events() {
@@ -31,20 +59,22 @@ public:
         return events;
     }
     void wakeUp();
+    // Collect the reply of request with sequence in reader thread, callback is
+    // invoked from main thread.
+    void waitForReply(unsigned int sequence, XCBReplyCallback callback);
 
 private:
-    static void runThread(XCBEventReader *self) { self->run(); }
-    void run();
     bool onIOEvent(IOEventFlags flags);
+    void collectReplies();
     XCBConnection *conn_;
-    EventDispatcher dispatcherToMain_;
-    EventDispatcher dispatcherToWorker_;
+    XCBEventReaderThread *thread_;
     bool hadError_ = false;
     std::unique_ptr<EventSource> deferEvent_;
-    std::unique_ptr<EventSource> wakeEvent_;
-    std::unique_ptr<std::thread> thread_;
     std::mutex mutex_;
     std::list<UniqueCPtr<xcb_generic_event_t>> events_;
+    // Only accessed from reader thread.
+    std::unique_ptr<EventSourceIO> ioEvent_;
+    std::list<std::pair<unsigned int, XCBReplyCallback>> pendingReplies_;
 };
 
 } // namespace fcitx
@@ -52,6 +52,13 @@ typedef struct _XDisplay Display;
 
 namespace fcitx {
 
+struct XCBKeymapResult {
+    XkbRulesNames names;
+    UniqueCPtr<struct xkb_keymap, xkb_keymap_unref> keymap;
+    UniqueCPtr<struct xkb_state, xkb_state_unref> state;
+    std::unique_ptr<KeycodeTable> keycodeTable;
+};
+
 namespace {
 
 std::string xmodmapFile() {
@@ -69,6 +76,100 @@ std::string xmodmapFile() {
     return path;
 }
 
+XkbRulesNames readXkbRulesNames(xcb_connection_t *conn, xcb_window_t root,
+                                xcb_atom_t atom) {
+    xcb_get_property_cookie_t get_prop_cookie = xcb_get_property(
+        conn, false, root, atom, XCB_ATOM_STRING, 0, 1024);
+    auto reply =
+        makeUniqueCPtr(xcb_get_property_reply(conn, get_prop_cookie, nullptr));
+
+    if (!reply || reply->type != XCB_ATOM_STRING || reply->bytes_after > 0 ||
+        reply->format != 8) {
+        return {};
+    }
+
+    auto *data = static_cast<char *>(xcb_get_property_value(reply.get()));
+    int length = xcb_get_property_value_length(reply.get());
+
+    XkbRulesNames names;
+    if (length) {
+        auto p = data, end = data + length;
+        int i = 0;
+        // The result from xcb_get_property_value() is not necessarily
+        // \0-terminated,
+        // we need to make sure that too many or missing '\0' symbols are
+        // handled safely.
+        do {
+            auto len = strnlen(&(*p), length);
+            names[i++] = std::string(&(*p), len);
+            p += len + 1;
+            length -= len + 1;
+        } while (p < end || i < 5);
+    }
+    return names;
+}
+
+XCBKeymapResult compileKeymap(xcb_connection_t *conn, xcb_window_t root,
+                              xcb_atom_t atom, int32_t deviceId) {
+    XCBKeymapResult result;
+    if (atom) {
+        result.names = readXkbRulesNames(conn, root, atom);
+    }
+
+    // xkb_context is not thread safe, each compilation uses its own. Keymap
+    // holds the reference to it.
+    UniqueCPtr<struct xkb_context, xkb_context_unref> context(
+        xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+    if (!context) {
+        return result;
+    }
+    xkb_context_set_log_level(context.get(), XKB_LOG_LEVEL_CRITICAL);
+
+    result.keymap.reset(xkb_x11_keymap_new_from_device(
+        context.get(), conn, deviceId, XKB_KEYMAP_COMPILE_NO_FLAGS));
+    if (result.keymap) {
+        result.state.reset(
+            xkb_x11_state_new_from_device(result.keymap.get(), conn, deviceId));
+        result.keycodeTable =
+            std::make_unique<KeycodeTable>(result.keymap.get());
+        return result;
+    }
+
+    std::string rule = DEFAULT_XKB_RULES;
+    std::string model = "pc101";
+    std::string layout = "us";
+    std::string variant;
+    std::string options;
+    if (!result.names[0].empty()) {
+        rule = result.names[0];
+        model = result.names[1];
+        layout = result.names[2];
+        variant = result.names[3];
+        options = result.names[4];
+    }
+    struct xkb_rule_names xkbNames;
+    xkbNames.rules = rule.c_str();
+    xkbNames.model = model.c_str();
+    xkbNames.layout = layout.c_str();
+    xkbNames.variant = variant.c_str();
+    xkbNames.options = options.c_str();
+    result.keymap.reset(xkb_keymap_new_from_names(
+        context.get(), &xkbNames, XKB_KEYMAP_COMPILE_NO_FLAGS));
+
+    if (!result.keymap) {
+        memset(&xkbNames, 0, sizeof(xkbNames));
+        result.keymap.reset(xkb_keymap_new_from_names(
+            context.get(), &xkbNames, XKB_KEYMAP_COMPILE_NO_FLAGS));
+    }
+
+    if (result.keymap) {
+        result.state.reset(xkb_state_new(result.keymap.get()));
+        result.keycodeTable =
+            std::make_unique<KeycodeTable>(result.keymap.get());
+    }
+    return result;
+}
+
 } // namespace
 
 union _xkb_event {
@@ -139,7 +240,8 @@ XCBKeyboard::XCBKeyboard(XCBConnection *conn) : conn_(conn) {
         return;
     }
     hasXKB_ = true;
-    updateKeymap();
+    // Key event need the keymap right away.
+    updateKeymapSync();
     addEventMaskToWindow(connection(), conn_->root(),
                          XCB_EVENT_MASK_PROPERTY_CHANGE);
 
@@ -167,60 +269,55 @@ XCBKeyboard::XCBKeyboard(XCBConnection *conn) : conn_(conn) {
         }));
 }
 
-void XCBKeyboard::updateKeymap() {
-    if (!context_) {
-        context_.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
-        xkb_context_set_log_level(context_.get(), XKB_LOG_LEVEL_CRITICAL);
-    }
+XCBKeyboard::~XCBKeyboard() = default;
 
-    if (!context_) {
+void XCBKeyboard::updateKeymap() {
+    if (compilingKeymap_) {
+        keymapDirty_ = true;
         return;
     }
-    xcb_flush(connection());
-    initDefaultLayout();
-
-    keymap_.reset(nullptr);
-
-    struct xkb_state *new_state = nullptr;
-    if (hasXKB_) {
-        keymap_.reset(xkb_x11_keymap_new_from_device(
-            context_.get(), connection(), coreDeviceId_,
-            XKB_KEYMAP_COMPILE_NO_FLAGS));
-        if (keymap_) {
-            new_state = xkb_x11_state_new_from_device(
-                keymap_.get(), connection(), coreDeviceId_);
-        }
-    }
-
-    if (!keymap_) {
-
-        if (!xkbRule_.empty()) {
-            struct xkb_rule_names xkbNames;
-            auto layout = stringutils::join(defaultLayouts_, ',');
-            auto variant = stringutils::join(defaultVariants_, ',');
-            xkbNames.rules = xkbRule_.c_str();
-            xkbNames.model = xkbModel_.c_str();
-            xkbNames.layout = layout.c_str();
-            xkbNames.variant = variant.c_str();
-            xkbNames.options = xkbOptions_.c_str();
+    startKeymapCompile();
+}
 
-            keymap_.reset(xkb_keymap_new_from_names(
-                context_.get(), &xkbNames, XKB_KEYMAP_COMPILE_NO_FLAGS));
-        }
+void XCBKeyboard::updateKeymapSync() {
+    xcb_flush(connection());
+    auto result = compileKeymap(connection(), conn_->root(),
+                                xkbRulesNamesAtom(), coreDeviceId_);
+    installKeymap(result);
+}
 
-        if (!keymap_) {
-            struct xkb_rule_names xkbNames;
-            memset(&xkbNames, 0, sizeof(xkbNames));
-            keymap_.reset(xkb_keymap_new_from_names(
-                context_.get(), &xkbNames, XKB_KEYMAP_COMPILE_NO_FLAGS));
-        }
+void XCBKeyboard::startKeymapCompile() {
+    compilingKeymap_ = true;
+    keymapDirty_ = false;
+    compileStateSerial_ = stateSerial_;
+    xcb_flush(connection());
+    keymapJob_ = conn_->instance()->workerPool().submit(
+        WorkerJobPriority::Interactive,
+        [conn = connection(), root = conn_->root(), atom = xkbRulesNamesAtom(),
+         deviceId = coreDeviceId_](const WorkerJobToken &) {
+            return compileKeymap(conn, root, atom, deviceId);
+        },
+        [this](XCBKeymapResult result) {
+            compilingKeymap_ = false;
+            installKeymap(result);
+            if (keymapDirty_) {
+                startKeymapCompile();
+            }
+        });
+}
 
-        if (keymap_) {
-            new_state = xkb_state_new(keymap_.get());
-        }
+void XCBKeyboard::installKeymap(XCBKeymapResult &result) {
+    applyRulesNames(result.names);
+    keymap_ = std::move(result.keymap);
+    state_ = std::move(result.state);
+    keycodeTable_ = std::move(result.keycodeTable);
+    // The state fetched by worker may miss the notify that arrived after.
+    if (state_ && stateSerial_ != compileStateSerial_) {
+        xkb_state_update_mask(state_.get(), lastState_.baseMods,
+                              lastState_.latchedMods, lastState_.lockedMods,
+                              lastState_.baseGroup, lastState_.latchedGroup,
+                              lastState_.lockedGroup);
     }
-
-    state_.reset(new_state);
 }
 
 xcb_atom_t XCBKeyboard::xkbRulesNamesAtom() {
@@ -234,41 +331,12 @@ XkbRulesNames XCBKeyboard::xkbRulesNames() {
     if (!xkbRulesNamesAtom()) {
         return {};
     }
-
-    xcb_get_property_cookie_t get_prop_cookie =
-        xcb_get_property(connection(), false, conn_->root(),
-                         xkbRulesNamesAtom(), XCB_ATOM_STRING, 0, 1024);
-    auto reply = makeUniqueCPtr(
-        xcb_get_property_reply(connection(), get_prop_cookie, nullptr));
-
-    if (!reply || reply->type != XCB_ATOM_STRING || reply->bytes_after > 0 ||
-        reply->format != 8) {
-        return {};
-    }
-
-    auto *data = static_cast<char *>(xcb_get_property_value(reply.get()));
-    int length = xcb_get_property_value_length(reply.get());
-
-    XkbRulesNames names;
-    if (length) {
-        auto p = data, end = data + length;
-        int i = 0;
-        // The result from xcb_get_property_value() is not necessarily
-        // \0-terminated,
-        // we need to make sure that too many or missing '\0' symbols are
-        // handled safely.
-        do {
-            auto len = strnlen(&(*p), length);
-            names[i++] = std::string(&(*p), len);
-            p += len + 1;
-            length -= len + 1;
-        } while (p < end || i < 5);
-    }
-    return names;
+    return readXkbRulesNames(connection(), conn_->root(), xkbRulesNamesAtom());
 }
 
-void XCBKeyboard::initDefaultLayout() {
-    auto names = xkbRulesNames();
+void XCBKeyboard::initDefaultLayout() { applyRulesNames(xkbRulesNames()); }
+
+void XCBKeyboard::applyRulesNames(const XkbRulesNames &names) {
     conn_->instance()->setXkbParameters(conn_->focusGroup()->display(),
                                         names[0], names[1], names[4]);
 
@@ -310,8 +378,14 @@ int XCBKeyboard::findLayoutIndex(const std::string &layout,
 
 int XCBKeyboard::findOrAddLayout(const std::string &layout,
                                  const std::string &variant) {
+    auto index = findLayoutIndex(layout, variant);
+    // Layouts already loaded by server work as a cache, switching among them
+    // only need to lock the group.
+    if (index >= 0 && (!*conn_->parent()->config().alwaysSetToGroupLayout ||
+                       defaultLayouts_.size() == 1)) {
+        return index;
+    }
     addNewLayout(layout, variant);
-    initDefaultLayout();
     return findLayoutIndex(layout, variant);
 }
 
@@ -334,6 +408,7 @@ void XCBKeyboard::addNewLayout(const std::string &layout,
         }
         auto index = findLayoutIndex(layout, variant);
         if (index == 0) {
+            lockGroup(0);
             return;
         }
 
@@ -349,16 +424,18 @@ void XCBKeyboard::addNewLayout(const std::string &layout,
         defaultVariants_.insert(defaultVariants_.begin(), variant);
     }
 
+    // Layouts are inserted at front.
     setRMLVOToServer(xkbRule_, xkbModel_,
                      stringutils::join(defaultLayouts_, ","),
-                     stringutils::join(defaultVariants_, ","), xkbOptions_);
+                     stringutils::join(defaultVariants_, ","), xkbOptions_, 0);
 }
 
 void XCBKeyboard::setRMLVOToServer(const std::string &rule,
                                    const std::string &model,
                                    const std::string &layout,
                                    const std::string &variant,
-                                   const std::string &options) {
+                                   const std::string &options,
+                                   int groupToLock) {
     FCITX_XCB_DEBUG() << "RMLVO tuple: " << rule << " " << model << " "
                       << layout << " " << variant;
     // xcb_xkb_get_kbd_by_name() doesn't fill the buffer for us, need to it
@@ -381,6 +458,8 @@ void XCBKeyboard::setRMLVOToServer(const std::string &rule,
 
     if (!rules) {
         FCITX_WARN() << "Could not load XKB rules";
+        // Layout list may be already changed, read it back from server.
+        updateKeymap();
         return;
     }
 
@@ -461,8 +540,6 @@ void XCBKeyboard::setRMLVOToServer(const std::string &rule,
 
     xcb_ret.sequence = xcb_send_request(connection(), XCB_REQUEST_CHECKED,
                                         xcb_parts + 2, &xcb_req);
-    auto reply = makeUniqueCPtr(
-        xcb_xkb_get_kbd_by_name_reply(connection(), xcb_ret, nullptr));
 
     XkbRF_Free(rules, true);
     free(rnames.keymap);
@@ -477,45 +554,65 @@ void XCBKeyboard::setRMLVOToServer(const std::string &rule,
     free(rdefs.variant);
     free(rdefs.options);
 
-    if (reply) {
-        std::vector<char> propData;
-        propData.insert(propData.end(), rule.begin(), rule.end());
-        propData.push_back(0);
-        propData.insert(propData.end(), model.begin(), model.end());
-        propData.push_back(0);
-        propData.insert(propData.end(), layout.begin(), layout.end());
-        propData.push_back(0);
-        propData.insert(propData.end(), variant.begin(), variant.end());
-        propData.push_back(0);
-        propData.insert(propData.end(), options.begin(), options.end());
-        propData.push_back(0);
-        xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, conn_->root(),
-                            conn_->atom(_XKB_RF_NAMES_PROP_ATOM, false),
-                            XCB_ATOM_STRING, 8, propData.size(),
-                            propData.data());
-    }
+    std::vector<char> propData;
+    propData.insert(propData.end(), rule.begin(), rule.end());
+    propData.push_back(0);
+    propData.insert(propData.end(), model.begin(), model.end());
+    propData.push_back(0);
+    propData.insert(propData.end(), layout.begin(), layout.end());
+    propData.push_back(0);
+    propData.insert(propData.end(), variant.begin(), variant.end());
+    propData.push_back(0);
+    propData.insert(propData.end(), options.begin(), options.end());
+    propData.push_back(0);
+
+    // Loading keymap may take server a while, don't block on it. The reply is
+    // collected by event reader.
+    conn_->waitForReply(
+        xcb_ret.sequence, [this, propData = std::move(propData),
+                           groupToLock](void *reply, xcb_generic_error_t *) {
+            if (!reply) {
+                FCITX_XCB_DEBUG() << "Failed to load keymap to server.";
+                updateKeymap();
+                return;
+            }
+            xcb_change_property(connection(), XCB_PROP_MODE_REPLACE,
+                                conn_->root(),
+                                conn_->atom(_XKB_RF_NAMES_PROP_ATOM, false),
+                                XCB_ATOM_STRING, 8, propData.size(),
+                                propData.data());
+            if (groupToLock >= 0) {
+                lockGroup(groupToLock);
+            }
+            xcb_flush(connection());
+        });
     waitingForRefresh_ = true;
 }
 
 bool XCBKeyboard::setLayoutByName(const std::string &layout,
                                   const std::string &variant) {
-    int index;
-    index = findOrAddLayout(layout, variant);
-    if (index < 0) {
-        return false;
+    auto index = findLayoutIndex(layout, variant);
+    if (index < 0 || (*conn_->parent()->config().alwaysSetToGroupLayout &&
+                      defaultLayouts_.size() != 1)) {
+        // Group is locked once server loads the new keymap.
+        index = findOrAddLayout(layout, variant);
+        return index >= 0;
     }
+    lockGroup(index);
+    return true;
+}
 
+void XCBKeyboard::lockGroup(int index) {
     FCITX_XCB_DEBUG() << "Lock group " << index;
 #ifdef ENABLE_DBUS
     auto *addon = conn_->instance()->addonManager().addon("dbus", true);
     if (addon && addon->call<IDBusModule::lockGroup>(index)) {
-        return true;
+        return;
     }
 #endif
     xcb_xkb_latch_lock_state(connection(), XCB_XKB_ID_USE_CORE_KBD, 0, 0, true,
                              index, 0, false, 0);
     xcb_flush(connection());
-    return true;
 }
 
 bool XCBKeyboard::handleEvent(xcb_generic_event_t *event) {
@@ -541,6 +638,13 @@ bool XCBKeyboard::handleEvent(xcb_generic_event_t *event) {
         switch (xkbEvent->any.xkbType) {
         case XCB_XKB_STATE_NOTIFY: {
             xcb_xkb_state_notify_event_t *state = &xkbEvent->state_notify;
+            lastState_.baseMods = state->baseMods;
+            lastState_.latchedMods = state->latchedMods;
+            lastState_.lockedMods = state->lockedMods;
+            lastState_.baseGroup = state->baseGroup;
+            lastState_.latchedGroup = state->latchedGroup;
+            lastState_.lockedGroup = state->lockedGroup;
+            ++stateSerial_;
             xkb_state_update_mask(state_.get(), state->baseMods,
                                   state->latchedMods, state->lockedMods,
                                   state->baseGroup, state->latchedGroup,
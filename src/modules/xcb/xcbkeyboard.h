@@ -7,9 +7,11 @@
 #ifndef _FCITX_MODULES_XCB_XCBKEYBOARD_H_
 #define _FCITX_MODULES_XCB_XCBKEYBOARD_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
+#include <fcitx/workerpool.h>
 #include <xcb/xcb.h>
 #include <xkbcommon/xkbcommon.h>
 #include "xcb_public.h"
@@ -17,12 +19,16 @@
 namespace fcitx {
 
 class XCBConnection;
+struct XCBKeymapResult;
 
 class XCBKeyboard {
 public:
     XCBKeyboard(XCBConnection *connection);
+    ~XCBKeyboard();
 
     xcb_connection_t *connection();
+    // Fetch and compile the keymap in a worker thread, the current keymap is
+    // kept until the new one is ready.
     void updateKeymap();
 
     // Layout handling
@@ -31,9 +37,11 @@ public:
                         const std::string &variant) const;
     int findOrAddLayout(const std::string &layout, const std::string &variant);
     void addNewLayout(const std::string &layout, const std::string &variant);
+    // Upload the keymap without waiting for server, groupToLock is applied
+    // after the server replies if it is not negative.
     void setRMLVOToServer(const std::string &rule, const std::string &model,
                           const std::string &layout, const std::string &variant,
-                          const std::string &options);
+                          const std::string &options, int groupToLock = -1);
     bool setLayoutByName(const std::string &layout, const std::string &variant);
 
     bool handleEvent(xcb_generic_event_t *event);
@@ -41,11 +49,18 @@ public:
     struct xkb_state *xkbState() {
         return state_.get();
     }
+    const KeycodeTable *keycodeTable() const { return keycodeTable_.get(); }
 
     void setXkbOption(const std::string &option);
 
 private:
     xcb_atom_t xkbRulesNamesAtom();
+    void applyRulesNames(const XkbRulesNames &names);
+    void updateKeymapSync();
+    void startKeymapCompile();
+    void installKeymap(XCBKeymapResult &result);
+    void lockGroup(int index);
+
     XCBConnection *conn_;
     uint8_t xkbFirstEvent_ = 0;
     uint8_t xkbMajorOpCode_ = 0;
@@ -53,9 +68,9 @@ private:
     bool hasXKB_ = false;
     xcb_atom_t xkbRulesNamesAtom_ = XCB_ATOM_NONE;
 
-    UniqueCPtr<struct xkb_context, xkb_context_unref> context_;
     UniqueCPtr<struct xkb_keymap, xkb_keymap_unref> keymap_;
     UniqueCPtr<struct xkb_state, xkb_state_unref> state_;
+    std::unique_ptr<KeycodeTable> keycodeTable_;
 
     std::vector<std::string> defaultLayouts_;
     std::vector<std::string> defaultVariants_;
@@ -69,6 +84,21 @@ private:
     std::unique_ptr<EventSourceTime> xmodmapTimer_;
     int lastSequence_ = 0;
     bool waitingForRefresh_ = false;
+
+    std::unique_ptr<WorkerJob> keymapJob_;
+    bool compilingKeymap_ = false;
+    bool keymapDirty_ = false;
+    // Track state notify received while keymap is being compiled.
+    uint64_t stateSerial_ = 0;
+    uint64_t compileStateSerial_ = 0;
+    struct {
+        uint8_t baseMods = 0;
+        uint8_t latchedMods = 0;
+        uint8_t lockedMods = 0;
+        int16_t baseGroup = 0;
+        int16_t latchedGroup = 0;
+        uint8_t lockedGroup = 0;
+    } lastState_;
 };
 
 } // namespace fcitx
@@ -15,7 +15,8 @@ namespace fcitx {
 
 FCITX_DEFINE_LOG_CATEGORY(xcb_log, "xcb");
 
-XCBModule::XCBModule(Instance *instance) : instance_(instance) {
+XCBModule::XCBModule(Instance *instance)
+    : instance_(instance), readerThread_(instance) {
     reloadConfig();
     openConnection("");
 }
@@ -101,6 +102,14 @@ xkb_state *XCBModule::xkbState(const std::string &name) {
     return iter->second.xkbState();
 }
 
+const KeycodeTable *XCBModule::keycodeTable(const std::string &name) {
+    auto iter = conns_.find(name);
+    if (iter == conns_.end()) {
+        return nullptr;
+    }
+    return iter->second.keycodeTable();
+}
+
 XkbRulesNames XCBModule::xkbRulesNames(const std::string &name) {
     auto iter = conns_.find(name);
     if (iter == conns_.end()) {
@@ -170,6 +179,15 @@ void XCBModule::setXkbOption(const std::string &name,
     iter->second.setXkbOption(option);
 }
 
+void XCBModule::waitForReply(const std::string &name, unsigned int sequence,
+                             XCBReplyCallback callback) {
+    auto iter = conns_.find(name);
+    if (iter == conns_.end()) {
+        return;
+    }
+    iter->second.waitForReply(sequence, std::move(callback));
+}
+
 class XCBModuleFactory : public AddonFactory {
 public:
     AddonInstance *create(AddonManager *manager) override {
@@ -178,4 +196,4 @@ public:
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::XCBModuleFactory);
+FCITX_ADDON_FACTORY_V2(xcb, fcitx::XCBModuleFactory);
@@ -41,6 +41,7 @@ public:
     void openConnection(const std::string &name);
     void removeConnection(const std::string &name);
     std::string mainDisplay() { return mainDisplay_; }
+    XCBEventReaderThread &eventReaderThread() { return readerThread_; }
     const XCBConfig &config() const { return config_; }
     Instance *instance() { return instance_; }
 
@@ -58,6 +59,7 @@ public:
     std::unique_ptr<HandlerTableEntry<XCBConnectionClosed>>
     addConnectionClosedCallback(XCBConnectionClosed callback);
     struct xkb_state *xkbState(const std::string &name);
+    const KeycodeTable *keycodeTable(const std::string &name);
     XkbRulesNames xkbRulesNames(const std::string &name);
     std::unique_ptr<HandlerTableEntry<XCBSelectionNotifyCallback>>
     addSelection(const std::string &name, const std::string &atom,
@@ -72,6 +74,8 @@ public:
     xcb_ewmh_connection_t *ewmh(const std::string &name);
 
     void setXkbOption(const std::string &name, const std::string &option);
+    void waitForReply(const std::string &name, unsigned int sequence,
+                      XCBReplyCallback callback);
 
     FCITX_ADDON_DEPENDENCY_LOADER(notifications, instance_->addonManager());
 
@@ -81,6 +85,8 @@ private:
 
     Instance *instance_;
     XCBConfig config_;
+    // Need to outlive all connections.
+    XCBEventReaderThread readerThread_;
     std::unordered_map<std::string, XCBConnection> conns_;
     HandlerTable<XCBConnectionCreated> createdCallbacks_;
     HandlerTable<XCBConnectionClosed> closedCallbacks_;
@@ -90,6 +96,7 @@ private:
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, addConnectionCreatedCallback);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, addConnectionClosedCallback);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, xkbState);
+    FCITX_ADDON_EXPORT_FUNCTION(XCBModule, keycodeTable);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, xkbRulesNames);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, addSelection);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, convertSelection);
@@ -97,6 +104,7 @@ private:
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, ewmh);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, mainDisplay);
     FCITX_ADDON_EXPORT_FUNCTION(XCBModule, setXkbOption);
+    FCITX_ADDON_EXPORT_FUNCTION(XCBModule, waitForReply);
 };
 
 FCITX_DECLARE_LOG_CATEGORY(xcb_log);
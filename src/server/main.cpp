@@ -11,7 +11,9 @@
 #include <exception>
 #include <iostream>
 #include <libintl.h>
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/fs.h"
+#include "fcitx-utils/log.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/standardpath.h"
 #include "fcitx/addonfactory.h"
@@ -37,7 +39,13 @@ StaticAddonRegistry staticAddon = {
 #endif
 };
 
+#ifdef ENABLE_MONOLITHIC
+// Generated, register all in-tree addons to staticAddon.
+#include "staticaddons.h"
+#endif
+
 int main(int argc, char *argv[]) {
+    const auto startTime = now(CLOCK_MONOTONIC);
     if (safePipe(selfpipe) < 0) {
         fprintf(stderr, "Could not create self-pipe.\n");
         return 1;
@@ -65,6 +73,15 @@ int main(int argc, char *argv[]) {
         Instance instance(argc, argv);
         instance.setSignalPipe(selfpipe[0]);
         instance.addonManager().registerDefaultLoader(&staticAddon);
+        // Called after addons are loaded by Instance::initialize.
+        auto startupEvent = instance.eventLoop().addDeferEvent(
+            [startTime](EventSource *) {
+                FCITX_DEBUG() << "Startup took "
+                              << (now(CLOCK_MONOTONIC) - startTime) / 1000.0
+                              << "ms, " << staticAddon.size()
+                              << " addons are linked statically.";
+                return true;
+            });
 
         return instance.exec();
     } catch (const InstanceQuietQuit &) {
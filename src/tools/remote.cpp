@@ -6,6 +6,8 @@
  */
 
 #include <iostream>
+#include <tuple>
+#include <vector>
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/utf8.h"
 
@@ -23,6 +25,9 @@ void usage(std::ostream &stream) {
               "\t-m <imname>\tprint corresponding addon name for im\n"
               "\t-g <group>\tset current input method group\n"
               "\t-q\t\tGet current input method group name\n"
+              "\t-u\t\tprint estimated memory usage of addons\n"
+              "\t-x\t\tdrop caches that can be rebuilt\n"
+              "\t-i\t\tprint cache statistics of addons\n"
               "\t-s <imname>\tswitch to the input method uniquely identified "
               "by <imname>\n"
               "\t[no option]\tdisplay fcitx state, 0 for close, 1 for "
@@ -41,6 +46,9 @@ enum {
     FCITX_DBUS_SET_CURRENT_IM,
     FCITX_DBUS_SET_CURRENT_GROUP,
     FCITX_DBUS_GET_CURRENT_GROUP,
+    FCITX_DBUS_MEMORY_USAGE,
+    FCITX_DBUS_TRIM_MEMORY,
+    FCITX_DBUS_CACHE_STATISTICS,
 };
 
 int main(int argc, char *argv[]) {
@@ -54,7 +62,7 @@ int main(int argc, char *argv[]) {
     int ret = 1;
     int messageType = FCITX_DBUS_GET_CURRENT_STATE;
     std::string imname;
-    while ((c = getopt(argc, argv, "chortTeam:s:g:q")) != -1) {
+    while ((c = getopt(argc, argv, "chortTeam:s:g:quxi")) != -1) {
         switch (c) {
         case 'o':
             messageType = FCITX_DBUS_ACTIVATE;
@@ -96,6 +104,18 @@ int main(int argc, char *argv[]) {
             messageType = FCITX_DBUS_GET_CURRENT_GROUP;
             break;
 
+        case 'u':
+            messageType = FCITX_DBUS_MEMORY_USAGE;
+            break;
+
+        case 'x':
+            messageType = FCITX_DBUS_TRIM_MEMORY;
+            break;
+
+        case 'i':
+            messageType = FCITX_DBUS_CACHE_STATISTICS;
+            break;
+
         case 'a':
             std::cout << bus.address() << std::endl;
             return 0;
@@ -135,6 +155,9 @@ int main(int argc, char *argv[]) {
         CASE(SET_CURRENT_IM, SetCurrentIM);
         CASE(GET_CURRENT_GROUP, CurrentInputMethodGroup);
         CASE(SET_CURRENT_GROUP, SwitchInputMethodGroup);
+        CASE(MEMORY_USAGE, MemoryUsage);
+        CASE(TRIM_MEMORY, TrimMemory);
+        CASE(CACHE_STATISTICS, CacheStatistics);
 
     default:
         return ret;
@@ -197,6 +220,36 @@ int main(int argc, char *argv[]) {
         std::cerr << "Failed to get reply." << std::endl;
         return 1;
     }
+    if (messageType == FCITX_DBUS_MEMORY_USAGE ||
+        messageType == FCITX_DBUS_CACHE_STATISTICS) {
+        auto reply = message.call(defaultTimeout);
+        if (!reply.isError()) {
+            std::vector<DBusStruct<
+                std::string, std::vector<DBusStruct<std::string, uint64_t>>>>
+                result;
+            reply >> result;
+            for (const auto &addon : result) {
+                const auto &items = std::get<1>(addon);
+                if (messageType == FCITX_DBUS_MEMORY_USAGE) {
+                    uint64_t total = 0;
+                    for (const auto &item : items) {
+                        total += std::get<1>(item);
+                    }
+                    std::cout << std::get<0>(addon) << ": " << total
+                              << std::endl;
+                } else {
+                    std::cout << std::get<0>(addon) << ":" << std::endl;
+                }
+                for (const auto &item : items) {
+                    std::cout << "  " << std::get<0>(item) << ": "
+                              << std::get<1>(item) << std::endl;
+                }
+            }
+            return 0;
+        }
+        std::cerr << "Failed to get reply." << std::endl;
+        return 1;
+    }
 
     auto reply = message.call(defaultTimeout);
     return reply.isError() ? 1 : 0;
@@ -7,12 +7,15 @@
 
 #include "classicui.h"
 #include <fcntl.h>
+#include <algorithm>
 #include "fcitx-config/iniparser.h"
 #include "fcitx-utils/misc_p.h"
 #include "fcitx-utils/standardpath.h"
 #include "fcitx-utils/utf8.h"
 #include "fcitx/inputcontext.h"
 #include "fcitx/inputcontextmanager.h"
+#include "fcitx/inputmethodentry.h"
+#include "fcitx/inputmethodmanager.h"
 #include "fcitx/instance.h"
 #include "fcitx/userinterfacemanager.h"
 #include "common.h"
@@ -30,6 +33,15 @@ FCITX_DEFINE_LOG_CATEGORY(classicui_logcategory, "classicui");
 
 ClassicUI::ClassicUI(Instance *instance) : instance_(instance) {
     reloadConfig();
+    setMemoryUsageCallback([this]() -> AddonMemoryUsage {
+        return {{"themeImages", theme_.imageMemoryUsage()},
+                {"sharedImages", Theme::sharedImageMemoryUsage()}};
+    });
+    setTrimMemoryCallback([this]() { theme_.trimMemory(); });
+
+    eventHandlers_.emplace_back(instance_->watchEvent(
+        EventType::InputMethodGroupChanged, EventWatcherPhase::Default,
+        [this](Event &) { scheduleFontWarmUp(); }));
 
 #ifdef ENABLE_X11
     if (auto *xcbAddon = xcb()) {
@@ -74,6 +86,52 @@ ClassicUI::~ClassicUI() {}
 void ClassicUI::reloadConfig() {
     readAsIni(config_, "conf/classicui.conf");
     reloadTheme();
+    scheduleFontWarmUp();
+}
+
+void ClassicUI::scheduleFontWarmUp() {
+    // Wait a little, so it does not compete with startup and multiple
+    // changes in a row only start it once.
+    constexpr uint64_t delay = 1000000;
+    if (fontWarmUpEvent_) {
+        fontWarmUpEvent_->setNextInterval(delay);
+        fontWarmUpEvent_->setOneShot();
+        return;
+    }
+    fontWarmUpEvent_ = instance_->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + delay, 0,
+        [this](EventSourceTime *, uint64_t) {
+            startFontWarmUp();
+            return true;
+        });
+}
+
+void ClassicUI::startFontWarmUp() {
+    // Empty string is the default language.
+    std::vector<std::string> languages{""};
+    auto &imManager = instance_->inputMethodManager();
+    for (const auto &item : imManager.currentGroup().inputMethodList()) {
+        const auto *entry = imManager.entry(item.name());
+        if (!entry || entry->languageCode().empty() ||
+            std::find(languages.begin(), languages.end(),
+                      entry->languageCode()) != languages.end()) {
+            continue;
+        }
+        languages.push_back(entry->languageCode());
+    }
+    std::vector<int> dpis;
+    for (const auto &ui : uis_) {
+        for (auto dpi : ui.second->dpis()) {
+            if (std::find(dpis.begin(), dpis.end(), dpi) == dpis.end()) {
+                dpis.push_back(dpi);
+            }
+        }
+    }
+    if (dpis.empty()) {
+        dpis.push_back(-1);
+    }
+    fontWarmUp_.start({*config_.font, *config_.menuFont}, std::move(languages),
+                      std::move(dpis));
 }
 
 void ClassicUI::reloadTheme() { theme_.load(*config_.theme); }
@@ -329,4 +387,4 @@ bool ClassicUI::showLayoutNameInIcon() const {
 
 } // namespace fcitx::classicui
 
-FCITX_ADDON_FACTORY(fcitx::classicui::ClassicUIFactory);
+FCITX_ADDON_FACTORY_V2(classicui, fcitx::classicui::ClassicUIFactory);
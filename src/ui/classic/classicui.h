@@ -21,6 +21,7 @@
 #include "fcitx/instance.h"
 #include "fcitx/userinterface.h"
 #include "classicui_public.h"
+#include "fontwarmup.h"
 #include "theme.h"
 #ifdef ENABLE_X11
 #include "xcb_public.h"
@@ -42,6 +43,8 @@ public:
     virtual void suspend() = 0;
     virtual void resume() {}
     virtual void setEnableTray(bool) = 0;
+    // Resolutions that fonts are rendered with, negative stands for default.
+    virtual std::vector<int> dpis() { return {}; }
 };
 
 struct NotEmpty {
@@ -131,7 +134,28 @@ FCITX_CONFIGURATION(
                "configuration needs to support this to use this feature.")}};
     Option<std::string, NotEmpty, DefaultMarshaller<std::string>,
            ThemeAnnotation>
-        theme{this, "Theme", _("Theme"), "default"};);
+        theme{this, "Theme", _("Theme"), "default"};
+    OptionWithAnnotation<bool, ToolTipAnnotation> useMITSHM{
+        this,
+        "UseMITSHM",
+        _("Use shared memory to draw window on X11"),
+        false,
+        {},
+        {},
+        {_("Render window content locally and pass it to X server with "
+           "MIT-SHM extension. It falls back to normal drawing if X server "
+           "is not local.")}};
+    OptionWithAnnotation<bool, ToolTipAnnotation> useWaylandSubsurface{
+        this,
+        "UseWaylandSubsurface",
+        _("Draw input window in separate surfaces on Wayland"),
+        false,
+        {},
+        {},
+        {_("Draw the background, text and candidates of input window in "
+           "separate subsurfaces, so only the changed part is redrawn. This "
+           "is experimental and requires compositor support of "
+           "subsurfaces.")}};);
 
 class ClassicUI final : public UserInterface {
 public:
@@ -147,6 +171,7 @@ public:
         config_.load(config, true);
         safeSaveAsIni(config_, "conf/classicui.conf");
         reloadTheme();
+        scheduleFontWarmUp();
     }
     const Configuration *getSubConfig(const std::string &path) const override;
     void setSubConfig(const std::string &path,
@@ -165,6 +190,8 @@ public:
                                          unsigned int size);
     bool preferTextIcon() const;
     bool showLayoutNameInIcon() const;
+    // Warm up fonts after a short delay, e.g. when screen DPI changes.
+    void scheduleFontWarmUp();
 
 private:
     FCITX_ADDON_DEPENDENCY_LOADER(notificationitem, instance_->addonManager());
@@ -176,6 +203,7 @@ private:
     UIInterface *uiForInputContext(InputContext *inputContext);
     UIInterface *uiForDisplay(const std::string &display);
     void reloadTheme();
+    void startFontWarmUp();
 
 #ifdef ENABLE_X11
     std::unique_ptr<HandlerTableEntry<XCBConnectionCreated>>
@@ -201,6 +229,8 @@ private:
     Theme theme_;
     mutable Theme subconfigTheme_;
     bool suspended_ = true;
+    std::unique_ptr<EventSourceTime> fontWarmUpEvent_;
+    FontWarmUp fontWarmUp_;
 };
 } // namespace classicui
 } // namespace fcitx
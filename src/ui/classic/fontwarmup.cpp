@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include "fontwarmup.h"
+#include <algorithm>
+#include <cairo/cairo.h>
+#include <pango/pangocairo.h>
+#include "common.h"
+
+namespace fcitx::classicui {
+
+namespace {
+
+// Glyphs that show up in almost every candidate window, e.g. the labels.
+constexpr char commonGlyphs[] =
+    "0123456789 abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ.,;:!?'\"()[]<>-_=+/\\|@#$%^&*~`";
+
+void renderLayout(PangoLayout *layout) {
+    int width, height;
+    pango_layout_get_pixel_size(layout, &width, &height);
+    UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface(
+        cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                   std::clamp(width, 1, 4096),
+                                   std::clamp(height, 1, 512)));
+    UniqueCPtr<cairo_t, cairo_destroy> cr(cairo_create(surface.get()));
+    pango_cairo_show_layout(cr.get(), layout);
+}
+
+} // namespace
+
+FontWarmUp::~FontWarmUp() {
+    cancel();
+    // Worker runs the code of this module, so it can't outlive it. It checks
+    // the cancellation before each layout, so this is short.
+    for (auto &worker : retired_) {
+        worker->thread.join();
+    }
+}
+
+void FontWarmUp::start(std::vector<std::string> fonts,
+                       std::vector<std::string> languages,
+                       std::vector<int> dpis) {
+    cancel();
+    current_ = std::make_unique<Worker>();
+    current_->thread = std::thread(
+        [worker = current_.get(), fonts = std::move(fonts),
+         languages = std::move(languages), dpis = std::move(dpis)]() {
+            run(worker, fonts, languages, dpis);
+            worker->finished = true;
+        });
+}
+
+void FontWarmUp::cancel() {
+    if (current_) {
+        current_->cancelled = true;
+        retired_.push_back(std::move(current_));
+    }
+    reap();
+}
+
+void FontWarmUp::reap() {
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                  [](const std::unique_ptr<Worker> &worker) {
+                                      if (!worker->finished) {
+                                          return false;
+                                      }
+                                      worker->thread.join();
+                                      return true;
+                                  }),
+                   retired_.end());
+}
+
+void FontWarmUp::run(Worker *worker, const std::vector<std::string> &fonts,
+                     const std::vector<std::string> &languages,
+                     const std::vector<int> &dpis) {
+    // Never share pango object with main thread, only the caches below pango
+    // are shared.
+    GObjectUniquePtr<PangoFontMap> fontMap(pango_cairo_font_map_new());
+    GObjectUniquePtr<PangoContext> context(
+        pango_font_map_create_context(fontMap.get()));
+    auto *cairoFontMap = PANGO_CAIRO_FONT_MAP(fontMap.get());
+    const auto defaultDPI = pango_cairo_font_map_get_resolution(cairoFontMap);
+
+    for (const auto &font : fonts) {
+        if (worker->cancelled) {
+            return;
+        }
+        auto *fontDesc = pango_font_description_from_string(font.c_str());
+        pango_context_set_font_description(context.get(), fontDesc);
+        pango_font_description_free(fontDesc);
+
+        for (auto dpi : dpis) {
+            // Same as what input window does, glyphs are cached by their
+            // pixel size.
+            pango_cairo_font_map_set_resolution(cairoFontMap,
+                                                dpi < 0 ? defaultDPI : dpi);
+            pango_cairo_context_set_resolution(context.get(), dpi);
+
+            for (const auto &languageCode : languages) {
+                if (worker->cancelled) {
+                    return;
+                }
+                auto *language =
+                    languageCode.empty()
+                        ? pango_language_get_default()
+                        : pango_language_from_string(languageCode.c_str());
+                pango_context_set_language(context.get(), language);
+                // Sample string covers the script of the language, which
+                // also triggers fallback font resolution, e.g. for CJK.
+                std::string text = commonGlyphs;
+                text += pango_language_get_sample_string(language);
+                GObjectUniquePtr<PangoLayout> layout(
+                    pango_layout_new(context.get()));
+                pango_layout_set_text(layout.get(), text.c_str(), text.size());
+                renderLayout(layout.get());
+            }
+        }
+        CLASSICUI_DEBUG() << "Font warm up done: " << font;
+    }
+}
+
+} // namespace fcitx::classicui
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#ifndef _FCITX_UI_CLASSIC_FONTWARMUP_H_
+#define _FCITX_UI_CLASSIC_FONTWARMUP_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fcitx {
+namespace classicui {
+
+// Resolve fonts and rasterize common glyphs in a background thread.
+//
+// Fontconfig matching, font file loading and cairo's glyph cache are shared
+// within the process, so doing the same work with a private font map ahead of
+// time makes the first paint of the input window as fast as later ones.
+class FontWarmUp {
+public:
+    FontWarmUp() = default;
+    ~FontWarmUp();
+
+    FontWarmUp(const FontWarmUp &) = delete;
+    FontWarmUp &operator=(const FontWarmUp &) = delete;
+
+    // Start to warm up given pango font descriptions for languages and
+    // resolutions, the running one is cancelled. Negative DPI stands for the
+    // default resolution of the font map.
+    void start(std::vector<std::string> fonts,
+               std::vector<std::string> languages, std::vector<int> dpis);
+    // Ask the running warm up to stop, it does not wait for the thread.
+    void cancel();
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> finished{false};
+    };
+
+    static void run(Worker *worker, const std::vector<std::string> &fonts,
+                    const std::vector<std::string> &languages,
+                    const std::vector<int> &dpis);
+    void reap();
+
+    std::unique_ptr<Worker> current_;
+    // Cancelled workers that may be still running, they are joined after they
+    // finish.
+    std::vector<std::unique_ptr<Worker>> retired_;
+};
+
+} // namespace classicui
+} // namespace fcitx
+
+#endif // _FCITX_UI_CLASSIC_FONTWARMUP_H_
@@ -8,6 +8,7 @@
 #include <functional>
 #include <initializer_list>
 #include <limits>
+#include <string_view>
 #include <pango/pangocairo.h>
 #include "fcitx-utils/color.h"
 #include "fcitx-utils/log.h"
@@ -25,6 +26,22 @@ auto newPangoLayout(PangoContext *context) {
     return ptr;
 }
 
+static void appendKey(std::string &key,
+                      std::initializer_list<std::string_view> values) {
+    for (auto value : values) {
+        key.append(value.data(), value.size());
+        key.push_back('\x1f');
+    }
+}
+
+static void appendTextKey(std::string &key, const Text &text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        appendKey(key, {std::to_string(text.formatAt(i).toInteger()),
+                        text.stringAt(i)});
+    }
+    key.push_back('\x1e');
+}
+
 static void prepareLayout(cairo_t *cr, PangoLayout *layout) {
     const PangoMatrix *matrix;
 
@@ -284,6 +301,21 @@ void InputWindow::update(InputContext *inputContext) {
     setTextToLayout(inputContext, lowerLayout_.get(), nullptr, nullptr,
                     {auxDown});
 
+    // Language of input method decides the font used for the text.
+    std::string language;
+    if (const auto *entry = instance->inputMethodEntry(inputContext)) {
+        language = entry->languageCode();
+    }
+    textKey_.clear();
+    if (pango_layout_get_character_count(upperLayout_.get()) ||
+        pango_layout_get_character_count(lowerLayout_.get())) {
+        appendKey(textKey_, {language, std::to_string(cursor_)});
+        appendTextKey(textKey_, auxUp);
+        appendTextKey(textKey_, preedit);
+        appendTextKey(textKey_, auxDown);
+    }
+    candidatesKey_.clear();
+
     if (auto candidateList = inputPanel.candidateList()) {
         // Count non-placeholder candidates.
         int count = 0;
@@ -321,6 +353,8 @@ void InputWindow::update(InputContext *inputContext) {
                 instance->outputFilter(inputContext, candidate.text());
             setTextToMultilineLayout(
                 inputContext, candidateLayouts_[localIndex], candidateText);
+            appendTextKey(candidatesKey_, labelText);
+            appendTextKey(candidatesKey_, candidateText);
             localIndex++;
         }
 
@@ -332,6 +366,14 @@ void InputWindow::update(InputContext *inputContext) {
             hasPrev_ = false;
             hasNext_ = false;
         }
+        if (nCandidates_) {
+            appendKey(candidatesKey_,
+                      {language, std::to_string(candidateIndex_),
+                       std::to_string(static_cast<int>(layoutHint_)),
+                       std::to_string(hasPrev_), std::to_string(hasNext_)});
+        } else {
+            candidatesKey_.clear();
+        }
     } else {
         nCandidates_ = 0;
         candidateIndex_ = -1;
@@ -356,13 +398,7 @@ std::pair<unsigned int, unsigned int> InputWindow::sizeHint() {
         labelLayouts_[i].contextChanged();
         candidateLayouts_[i].contextChanged();
     }
-    auto *metrics = pango_context_get_metrics(
-        context_.get(), pango_context_get_font_description(context_.get()),
-        pango_context_get_language(context_.get()));
-    auto fontHeight = pango_font_metrics_get_ascent(metrics) +
-                      pango_font_metrics_get_descent(metrics);
-    pango_font_metrics_unref(metrics);
-    fontHeight = PANGO_PIXELS(fontHeight);
+    auto fontHeight = this->fontHeight();
 
     size_t width = 0;
     size_t height = 0;
@@ -437,15 +473,155 @@ std::pair<unsigned int, unsigned int> InputWindow::sizeHint() {
     return {width, height};
 }
 
+int InputWindow::fontHeight() const {
+    auto *metrics = pango_context_get_metrics(
+        context_.get(), pango_context_get_font_description(context_.get()),
+        pango_context_get_language(context_.get()));
+    auto fontHeight = pango_font_metrics_get_ascent(metrics) +
+                      pango_font_metrics_get_descent(metrics);
+    pango_font_metrics_unref(metrics);
+    return PANGO_PIXELS(fontHeight);
+}
+
+int InputWindow::textHeight(int fontHeight) const {
+    const auto &textMargin = *parent_->theme().inputPanel->textMargin;
+    auto extraH = *textMargin.marginTop + *textMargin.marginBottom;
+    int height = 0;
+    if (pango_layout_get_character_count(upperLayout_.get())) {
+        height += fontHeight + extraH;
+    }
+    if (pango_layout_get_character_count(lowerLayout_.get())) {
+        height += fontHeight + extraH;
+    }
+    return height;
+}
+
 void InputWindow::paint(cairo_t *cr, unsigned int width, unsigned int height) {
+    paintPart(InputWindowPart::Background, cr, width, height);
+    paintPart(InputWindowPart::Text, cr, width, height);
+    paintPart(InputWindowPart::Candidates, cr, width, height);
+}
+
+void InputWindow::paintPart(InputWindowPart part, cairo_t *cr,
+                            unsigned int width, unsigned int height) {
+    switch (part) {
+    case InputWindowPart::Background:
+        paintBackground(cr, width, height);
+        break;
+    case InputWindowPart::Text:
+        paintText(cr);
+        break;
+    case InputWindowPart::Candidates:
+        paintCandidates(cr, width, height);
+        break;
+    }
+}
+
+Rect InputWindow::partRegion(InputWindowPart part, unsigned int width,
+                             unsigned int height) const {
+    const auto &theme = parent_->theme();
+    const auto &margin = *theme.inputPanel->contentMargin;
+    const auto &highlightMargin = *theme.inputPanel->highlight->margin;
+    // Text takes the upper part of the window, and candidates take the rest.
+    const int textBottom = std::min<int>(
+        height, *margin.marginTop + textHeight(fontHeight()));
+    // Highlight is painted with its margin around the candidate, which may
+    // go above the text bottom. Left, right and bottom are already covered
+    // since candidates take the whole width and the rest of the height.
+    const int candidatesTop =
+        std::max(0, textBottom - std::max(0, *highlightMargin.marginTop));
+    Rect region;
+    switch (part) {
+    case InputWindowPart::Background:
+        region.setPosition(0, 0).setSize(width, height);
+        break;
+    case InputWindowPart::Text:
+        region.setPosition(0, 0).setSize(width, textBottom);
+        break;
+    case InputWindowPart::Candidates:
+        region.setPosition(0, candidatesTop)
+            .setSize(width, height - candidatesTop);
+        break;
+    }
+    return region;
+}
+
+std::string InputWindow::partKey(InputWindowPart part) const {
+    switch (part) {
+    case InputWindowPart::Background:
+        return "background";
+    case InputWindowPart::Text:
+        return textKey_;
+    case InputWindowPart::Candidates:
+        if (candidatesKey_.empty()) {
+            return {};
+        }
+        std::string key = candidatesKey_;
+        appendKey(key, {std::to_string(hoverIndex_),
+                        std::to_string(prevHovered_),
+                        std::to_string(nextHovered_)});
+        return key;
+    }
+    return {};
+}
+
+void InputWindow::paintBackground(cairo_t *cr, unsigned int width,
+                                  unsigned int height) {
     auto &theme = parent_->theme();
+    cairo_save(cr);
     cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
     theme.paint(cr, *theme.inputPanel->background, width, height);
+    cairo_restore(cr);
+}
+
+void InputWindow::paintText(cairo_t *cr) {
+    auto &theme = parent_->theme();
     const auto &margin = *theme.inputPanel->contentMargin;
     const auto &textMargin = *theme.inputPanel->textMargin;
-    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
     cairo_save(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+    // Move position to the right place.
+    cairo_translate(cr, *margin.marginLeft, *margin.marginTop);
+    cairoSetSourceColor(cr, *theme.inputPanel->normalColor);
+    auto fontHeight = this->fontHeight();
 
+    size_t currentHeight = 0;
+    auto extraH = *textMargin.marginTop + *textMargin.marginBottom;
+    if (pango_layout_get_character_count(upperLayout_.get())) {
+        renderLayout(cr, upperLayout_.get(), *textMargin.marginLeft,
+                     *textMargin.marginTop);
+        PangoRectangle pos;
+        if (cursor_ >= 0) {
+            pango_layout_get_cursor_pos(upperLayout_.get(), cursor_, &pos,
+                                        nullptr);
+
+            cairo_save(cr);
+            cairo_set_line_width(cr, 2);
+            auto offsetX = pango_units_to_double(pos.x);
+            cairo_move_to(cr, *textMargin.marginLeft + offsetX + 1,
+                          *textMargin.marginTop);
+            cairo_line_to(cr, *textMargin.marginLeft + offsetX + 1,
+                          *textMargin.marginTop + fontHeight);
+            cairo_stroke(cr);
+            cairo_restore(cr);
+        }
+        currentHeight += fontHeight + extraH;
+    }
+    if (pango_layout_get_character_count(lowerLayout_.get())) {
+        renderLayout(cr, lowerLayout_.get(), *textMargin.marginLeft,
+                     *textMargin.marginTop + currentHeight);
+    }
+    cairo_restore(cr);
+}
+
+void InputWindow::paintCandidates(cairo_t *cr, unsigned int width,
+                                  unsigned int height) {
+    auto &theme = parent_->theme();
+    const auto &margin = *theme.inputPanel->contentMargin;
+    const auto &textMargin = *theme.inputPanel->textMargin;
+    cairo_save(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
     prevRegion_ = Rect();
     nextRegion_ = Rect();
     if (nCandidates_ && (hasPrev_ || hasNext_)) {
@@ -487,49 +663,12 @@ void InputWindow::paint(cairo_t *cr, unsigned int width, unsigned int height) {
 
     // Move position to the right place.
     cairo_translate(cr, *margin.marginLeft, *margin.marginTop);
-
-    cairo_save(cr);
     cairoSetSourceColor(cr, *theme.inputPanel->normalColor);
-    // CLASSICUI_DEBUG() << theme.inputPanel->normalColor->toString();
-    auto *metrics = pango_context_get_metrics(
-        context_.get(), pango_context_get_font_description(context_.get()),
-        pango_context_get_language(context_.get()));
-    auto fontHeight = pango_font_metrics_get_ascent(metrics) +
-                      pango_font_metrics_get_descent(metrics);
-    pango_font_metrics_unref(metrics);
-    fontHeight = PANGO_PIXELS(fontHeight);
+    auto fontHeight = this->fontHeight();
 
-    size_t currentHeight = 0;
-    int w, h;
+    size_t currentHeight = textHeight(fontHeight);
     auto extraW = *textMargin.marginLeft + *textMargin.marginRight;
     auto extraH = *textMargin.marginTop + *textMargin.marginBottom;
-    if (pango_layout_get_character_count(upperLayout_.get())) {
-        renderLayout(cr, upperLayout_.get(), *textMargin.marginLeft,
-                     *textMargin.marginTop);
-        pango_layout_get_pixel_size(upperLayout_.get(), &w, &h);
-        PangoRectangle pos;
-        if (cursor_ >= 0) {
-            pango_layout_get_cursor_pos(upperLayout_.get(), cursor_, &pos,
-                                        nullptr);
-
-            cairo_save(cr);
-            cairo_set_line_width(cr, 2);
-            auto offsetX = pango_units_to_double(pos.x);
-            cairo_move_to(cr, *textMargin.marginLeft + offsetX + 1,
-                          *textMargin.marginTop);
-            cairo_line_to(cr, *textMargin.marginLeft + offsetX + 1,
-                          *textMargin.marginTop + fontHeight);
-            cairo_stroke(cr);
-            cairo_restore(cr);
-        }
-        currentHeight += fontHeight + extraH;
-    }
-    if (pango_layout_get_character_count(lowerLayout_.get())) {
-        renderLayout(cr, lowerLayout_.get(), *textMargin.marginLeft,
-                     *textMargin.marginTop + currentHeight);
-        pango_layout_get_pixel_size(lowerLayout_.get(), &w, nullptr);
-        currentHeight += fontHeight + extraH;
-    }
 
     bool vertical = parent_->config().verticalCandidateList.value();
     if (layoutHint_ == CandidateLayoutHint::Vertical) {
@@ -49,12 +49,27 @@ public:
     std::vector<PangoAttrListUniquePtr> highlightAttrLists_;
 };
 
+// Parts of input window that can be painted separately, so a window may
+// keep each part in its own buffer and only repaint the changed ones. Parts
+// are painted in this order, and later parts may overlap the earlier ones,
+// e.g. the highlight of candidates may extend over the text above it.
+enum class InputWindowPart { Background, Text, Candidates };
+
 class InputWindow {
 public:
     InputWindow(ClassicUI *parent);
     void update(InputContext *inputContext);
     std::pair<unsigned int, unsigned int> sizeHint();
     void paint(cairo_t *cr, unsigned int width, unsigned int height);
+    // Paint a single part, in the coordinate of the whole window.
+    void paintPart(InputWindowPart part, cairo_t *cr, unsigned int width,
+                   unsigned int height);
+    // Region of the window covered by the part.
+    Rect partRegion(InputWindowPart part, unsigned int width,
+                    unsigned int height) const;
+    // Everything that affects the painting of the part except the region and
+    // the theme. Empty if there is nothing to paint.
+    std::string partKey(InputWindowPart part) const;
     void hide();
     bool visible() const { return visible_; }
     bool hover(int x, int y);
@@ -75,6 +90,11 @@ protected:
     void setTextToMultilineLayout(InputContext *inputContext,
                                   MultilineLayout &layout, const Text &text);
     int highlight() const;
+    int fontHeight() const;
+    int textHeight(int fontHeight) const;
+    void paintBackground(cairo_t *cr, unsigned int width, unsigned int height);
+    void paintText(cairo_t *cr);
+    void paintCandidates(cairo_t *cr, unsigned int width, unsigned int height);
 
     ClassicUI *parent_;
     GObjectUniquePtr<PangoFontMap> fontMap_;
@@ -99,6 +119,8 @@ protected:
     CandidateLayoutHint layoutHint_ = CandidateLayoutHint::NotSet;
     size_t candidatesHeight_ = 0;
     int hoverIndex_ = -1;
+    std::string textKey_;
+    std::string candidatesKey_;
 };
 } // namespace classicui
 } // namespace fcitx
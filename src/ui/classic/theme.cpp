@@ -7,14 +7,21 @@
 
 #include "theme.h"
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <cassert>
+#include <cstring>
+#include <list>
+#include <tuple>
+#include <unordered_map>
 #include <fmt/format.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gio/gunixinputstream.h>
 #include <pango/pangocairo.h>
 #include "fcitx-config/iniparser.h"
+#include "fcitx-utils/diskcache.h"
 #include "fcitx-utils/fs.h"
 #include "fcitx-utils/log.h"
+#include "fcitx-utils/mtime_p.h"
 #include "fcitx-utils/rect.h"
 #include "fcitx-utils/standardpath.h"
 #include "fcitx/misc_p.h"
@@ -133,10 +140,7 @@ cairo_surface_t *pixBufToCairoSurface(GdkPixbuf *image) {
     return surface;
 }
 
-cairo_surface_t *loadImage(StandardPathFile &file) {
-    if (file.fd() < 0) {
-        return nullptr;
-    }
+cairo_surface_t *decodeImage(StandardPathFile &file) {
     if (stringutils::endsWith(file.path(), ".png")) {
         int fd = file.fd();
         auto *surface =
@@ -166,7 +170,167 @@ cairo_surface_t *loadImage(StandardPathFile &file) {
     return surface;
 }
 
-ThemeImage::ThemeImage(const IconTheme &iconTheme, const std::string &icon,
+namespace {
+
+// Persisting is only worth it if the decoded image is not huge.
+constexpr size_t maxPersistImageBytes = 4 * 1024 * 1024;
+
+cairo_surface_t *loadPersistedImage(const DiskCache &cache) {
+    auto data = cache.load();
+    if (!data) {
+        return nullptr;
+    }
+    DiskCacheReader reader(data->view());
+    uint32_t width, height;
+    std::string_view pixels;
+    if (!reader.readUInt32(width) || !reader.readUInt32(height) ||
+        !reader.readString(pixels) || !reader.atEnd() || !width || !height ||
+        pixels.size() != static_cast<size_t>(width) * height * 4) {
+        return nullptr;
+    }
+    auto *surface =
+        cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+    cairo_surface_flush(surface);
+    auto *dest = cairo_image_surface_get_data(surface);
+    auto stride = cairo_image_surface_get_stride(surface);
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(dest + y * stride, pixels.data() + y * width * 4, width * 4);
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+void persistImage(const DiskCache &cache, cairo_surface_t *surface) {
+    if (cairo_image_surface_get_format(surface) != CAIRO_FORMAT_ARGB32) {
+        return;
+    }
+    const auto width = cairo_image_surface_get_width(surface);
+    const auto height = cairo_image_surface_get_height(surface);
+    if (width <= 0 || height <= 0 ||
+        static_cast<size_t>(width) * height * 4 > maxPersistImageBytes) {
+        return;
+    }
+    cairo_surface_flush(surface);
+    const auto *data = cairo_image_surface_get_data(surface);
+    const auto stride = cairo_image_surface_get_stride(surface);
+    std::string pixels;
+    pixels.reserve(width * height * 4);
+    for (int y = 0; y < height; y++) {
+        pixels.append(reinterpret_cast<const char *>(data + y * stride),
+                      width * 4);
+    }
+    DiskCacheWriter writer;
+    writer.writeUInt32(width);
+    writer.writeUInt32(height);
+    writer.writeString(pixels);
+    cache.save(writer.data());
+}
+
+// Decoded images shared by all themes in the process, e.g. the ones of xcb
+// and wayland ui, and kept across theme reload.
+class ImageCache {
+public:
+    static ImageCache &instance() {
+        static ImageCache cache;
+        return cache;
+    }
+
+    // Return a new reference to the image, the image must not be modified.
+    cairo_surface_t *load(StandardPathFile &file) {
+        struct stat stats;
+        if (file.path().empty() || fstat(file.fd(), &stats) != 0) {
+            return decodeImage(file);
+        }
+        auto mtime = modifiedTime(stats);
+        Key key{file.path(), mtime.sec, mtime.nsec,
+                static_cast<int64_t>(stats.st_size)};
+        if (auto iter = entries_.find(key); iter != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, iter->second);
+            return cairo_surface_reference(iter->second->second.get());
+        }
+
+        DiskCache cache(fmt::format("classicui-image-{:016x}",
+                                    std::hash<std::string>()(file.path())),
+                        // Pixels are in native byte order.
+                        G_BYTE_ORDER);
+        cache.addSourceFile(file.path());
+        UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface(
+            loadPersistedImage(cache));
+        if (!surface) {
+            surface.reset(decodeImage(file));
+            if (!surface ||
+                cairo_surface_status(surface.get()) != CAIRO_STATUS_SUCCESS) {
+                return nullptr;
+            }
+            persistImage(cache, surface.get());
+        }
+
+        auto *result = cairo_surface_reference(surface.get());
+        bytes_ += imageBytes(surface.get());
+        lru_.emplace_front(key, std::move(surface));
+        entries_[key] = lru_.begin();
+        while (bytes_ > maxBytes && lru_.size() > 1) {
+            bytes_ -= imageBytes(lru_.back().second.get());
+            entries_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        return result;
+    }
+
+    size_t memoryUsage() const { return bytes_; }
+
+    // Drop the images that are not used by any theme.
+    void trim() {
+        for (auto iter = lru_.begin(); iter != lru_.end();) {
+            if (cairo_surface_get_reference_count(iter->second.get()) > 1) {
+                ++iter;
+                continue;
+            }
+            bytes_ -= imageBytes(iter->second.get());
+            entries_.erase(iter->first);
+            iter = lru_.erase(iter);
+        }
+    }
+
+private:
+    static constexpr size_t maxBytes = 16 * 1024 * 1024;
+
+    // Path, modification time and size of the file.
+    using Key = std::tuple<std::string, int64_t, int64_t, int64_t>;
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return std::hash<std::string>()(std::get<0>(key)) ^
+                   std::hash<int64_t>()(std::get<1>(key)) ^
+                   std::hash<int64_t>()(std::get<2>(key) + std::get<3>(key));
+        }
+    };
+
+    static size_t imageBytes(cairo_surface_t *surface) {
+        return static_cast<size_t>(cairo_image_surface_get_stride(surface)) *
+               cairo_image_surface_get_height(surface);
+    }
+
+    using Entry =
+        std::pair<Key, UniqueCPtr<cairo_surface_t, cairo_surface_destroy>>;
+    std::list<Entry> lru_;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entries_;
+    size_t bytes_ = 0;
+};
+
+cairo_surface_t *loadImage(StandardPathFile &file) {
+    if (file.fd() < 0) {
+        return nullptr;
+    }
+    return ImageCache::instance().load(file);
+}
+
+} // namespace
+
+ThemeImage::ThemeImage(const std::string &iconPath, const std::string &icon,
                        const std::string &label, uint32_t size,
                        const ClassicUI *classicui)
     : size_(size) {
@@ -175,10 +339,9 @@ ThemeImage::ThemeImage(const IconTheme &iconTheme, const std::string &icon,
         ((icon == "input-keyboard" &&
           hasTwoKeyboardInCurrentGroup(classicui->instance())) ||
          *classicui->config().preferTextIcon);
-    if (!preferTextIcon && !icon.empty()) {
-        std::string iconPath = iconTheme.findIcon(icon, size, 1);
+    if (!preferTextIcon && !iconPath.empty()) {
         auto fd = open(iconPath.c_str(), O_RDONLY);
-        StandardPathFile file(fd, icon);
+        StandardPathFile file(fd, iconPath);
         image_.reset(loadImage(file));
         if (image_ &&
             cairo_surface_status(image_.get()) != CAIRO_STATUS_SUCCESS) {
@@ -349,13 +512,27 @@ const ThemeImage &Theme::loadImage(const std::string &icon,
         map.erase(name);
     }
 
+    std::string iconPath;
+    if (!icon.empty()) {
+        iconPath = findIcon(icon, size);
+    }
     auto result = map.emplace(
         std::piecewise_construct, std::forward_as_tuple(name),
-        std::forward_as_tuple(iconTheme_, icon, label, size, classicui));
+        std::forward_as_tuple(iconPath, icon, label, size, classicui));
     assert(result.second);
     return result.first->second;
 }
 
+const std::string &Theme::findIcon(const std::string &icon, uint32_t size) {
+    auto key = fmt::format("{0}:{1}", size, icon);
+    if (auto *path = findValue(iconPathTable_, key)) {
+        return *path;
+    }
+    return iconPathTable_
+        .emplace(std::move(key), iconTheme_.findIcon(icon, size, 1))
+        .first->second;
+}
+
 void Theme::paint(cairo_t *c, const BackgroundImageConfig &cfg, int width,
                   int height, double alpha) {
     const ThemeImage &image = loadBackground(cfg);
@@ -593,12 +770,54 @@ void Theme::paint(cairo_t *c, const ActionImageConfig &cfg, double alpha) {
     cairo_restore(c);
 }
 
-void Theme::reset() {
+size_t ThemeImage::memoryUsage() const {
+    size_t size = 0;
+    for (auto *surface : {image_.get(), overlay_.get()}) {
+        if (surface &&
+            cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+            size += static_cast<size_t>(
+                        cairo_image_surface_get_stride(surface)) *
+                    cairo_image_surface_get_height(surface);
+        }
+    }
+    return size;
+}
+
+size_t Theme::imageMemoryUsage() const {
+    size_t size = 0;
+    for (const auto &[cfg, image] : backgroundImageTable_) {
+        size += image.memoryUsage();
+    }
+    for (const auto &[cfg, image] : actionImageTable_) {
+        size += image.memoryUsage();
+    }
+    for (const auto &[name, image] : trayImageTable_) {
+        size += image.memoryUsage();
+    }
+    return size;
+}
+
+void Theme::releaseImages() {
     trayImageTable_.clear();
     backgroundImageTable_.clear();
     actionImageTable_.clear();
 }
 
+size_t Theme::sharedImageMemoryUsage() {
+    return ImageCache::instance().memoryUsage();
+}
+
+void Theme::trimMemory() {
+    releaseImages();
+    iconPathTable_.clear();
+    ImageCache::instance().trim();
+}
+
+void Theme::reset() {
+    releaseImages();
+    serial_++;
+}
+
 void Theme::load(const std::string &name) {
     reset();
     if (auto themeConfigFile = StandardPath::global().openSystem(
@@ -637,6 +856,7 @@ bool Theme::setIconTheme(const std::string &name) {
         FCITX_INFO() << "New Icon theme: " << name;
         iconTheme_ = IconTheme(name);
         trayImageTable_.clear();
+        iconPathTable_.clear();
         return true;
     }
     return false;
@@ -165,7 +165,7 @@ class ThemeImage {
 public:
     ThemeImage(const std::string &name, const BackgroundImageConfig &cfg);
     ThemeImage(const std::string &name, const ActionImageConfig &cfg);
-    ThemeImage(const IconTheme &iconTheme, const std::string &icon,
+    ThemeImage(const std::string &iconPath, const std::string &icon,
                const std::string &label, uint32_t size,
                const ClassicUI *classicui);
 
@@ -208,6 +208,9 @@ public:
     }
     bool isImage() const { return isImage_; }
 
+    // Size of image data in bytes.
+    size_t memoryUsage() const;
+
 private:
     bool valid_ = false;
     std::string currentText_;
@@ -237,15 +240,35 @@ public:
 
     bool setIconTheme(const std::string &name);
 
+    // Increased every time the theme is loaded. Reloading classicui config
+    // also reloads the theme, so it can be used to invalidate anything
+    // painted with the old theme or font.
+    uint64_t serial() const { return serial_; }
+
+    // Size of all loaded images in bytes.
+    size_t imageMemoryUsage() const;
+    // Drop all loaded images, they are loaded again when they are painted.
+    void releaseImages();
+    // Size of decoded images shared by all themes in bytes, they may be
+    // used by the loaded images.
+    static size_t sharedImageMemoryUsage();
+    // Drop loaded images, cached icon lookups and the shared images that are
+    // no longer used.
+    void trimMemory();
+
 private:
     void reset();
+    // Cached result of IconTheme::findIcon.
+    const std::string &findIcon(const std::string &icon, uint32_t size);
 
     std::unordered_map<const BackgroundImageConfig *, ThemeImage>
         backgroundImageTable_;
     std::unordered_map<const ActionImageConfig *, ThemeImage> actionImageTable_;
     std::unordered_map<std::string, ThemeImage> trayImageTable_;
+    std::unordered_map<std::string, std::string> iconPathTable_;
     IconTheme iconTheme_;
     std::string name_;
+    uint64_t serial_ = 0;
 };
 
 inline void cairoSetSourceColor(cairo_t *cr, const Color &color) {
@@ -5,7 +5,9 @@
  *
  */
 #include "waylandinputwindow.h"
+#include "fcitx-utils/stringutils.h"
 #include "waylandim_public.h"
+#include "waylandshmwindow.h"
 #include "waylandui.h"
 #include "waylandwindow.h"
 #include "zwp_input_panel_v1.h"
@@ -74,6 +76,8 @@ WaylandInputWindow::WaylandInputWindow(WaylandUI *ui)
     initPanel();
 }
 
+WaylandInputWindow::~WaylandInputWindow() = default;
+
 void WaylandInputWindow::initPanel() {
     if (!window_->surface()) {
         window_->createWindow();
@@ -95,6 +99,7 @@ void WaylandInputWindow::update(fcitx::InputContext *ic) {
         window_->hide();
         panelSurface_.reset();
         panelSurfaceV2_.reset();
+        resetLayers();
         window_->destroyWindow();
         return;
     }
@@ -131,13 +136,7 @@ void WaylandInputWindow::update(fcitx::InputContext *ic) {
         window_->resize(width, height);
     }
 
-    if (auto *surface = window_->prerender()) {
-        cairo_t *c = cairo_create(surface);
-        cairo_scale(c, window_->scale(), window_->scale());
-        paint(c, width, height);
-        cairo_destroy(c);
-        window_->render();
-    } else {
+    if (!render(width, height)) {
         repaintIC_ = ic->watch();
     }
 }
@@ -147,13 +146,226 @@ void WaylandInputWindow::repaint() {
         return;
     }
 
+    render(window_->width(), window_->height());
+}
+
+bool WaylandInputWindow::render(unsigned int width, unsigned int height) {
+    auto *shmWindow = dynamic_cast<WaylandShmWindow *>(window_.get());
+    if (shmWindow && shmWindow->hasSubsurface() &&
+        *parent_->config().useWaylandSubsurface) {
+        return renderLayers(shmWindow, width, height);
+    }
+    if (textLayer_) {
+        // The option is turned off, layers would cover the window.
+        resetLayers();
+    }
+
     if (auto *surface = window_->prerender()) {
         cairo_t *c = cairo_create(surface);
         cairo_scale(c, window_->scale(), window_->scale());
-        paint(c, window_->width(), window_->height());
+        paint(c, width, height);
         cairo_destroy(c);
         window_->render();
+        return true;
+    }
+    return false;
+}
+
+bool WaylandInputWindow::renderLayers(WaylandShmWindow *window,
+                                      unsigned int width,
+                                      unsigned int height) {
+    if (!textLayer_) {
+        // Created in stacking order, background is at the bottom.
+        if (window->hasViewporter()) {
+            for (int i = 0; i < 9; i++) {
+                backgroundLayers_.push_back(
+                    std::make_unique<WaylandShmSubsurface>(ui_, window));
+            }
+        }
+        textLayer_ = std::make_unique<WaylandShmSubsurface>(ui_, window);
+        candidatesLayer_ = std::make_unique<WaylandShmSubsurface>(ui_, window);
+    }
+
+    const auto themeKey =
+        stringutils::concat(parent_->theme().serial(), ",", window->scale());
+    // Subsurfaces are synchronized, their changes are applied together with
+    // the commit of window below.
+    bool rendered = renderLayer(textLayer_.get(), InputWindowPart::Text, width,
+                                height, themeKey);
+    rendered = renderLayer(candidatesLayer_.get(), InputWindowPart::Candidates,
+                           width, height, themeKey) &&
+               rendered;
+
+    if (renderBackgroundLayers(window, width, height, themeKey)) {
+        auto windowKey =
+            stringutils::concat("transparent,", width, ",", height);
+        if (windowKey_ != windowKey) {
+            window->renderTransparent();
+            windowKey_ = std::move(windowKey);
+        } else {
+            window->commit();
+        }
+        return rendered;
+    }
+
+    hideBackgroundLayers();
+    auto windowKey = stringutils::concat(themeKey, ",", width, ",", height);
+    if (windowKey_ == windowKey) {
+        window->commit();
+        return rendered;
+    }
+    auto *surface = window->prerender();
+    if (!surface) {
+        return false;
+    }
+    cairo_t *c = cairo_create(surface);
+    cairo_scale(c, window->scale(), window->scale());
+    paintPart(InputWindowPart::Background, c, width, height);
+    cairo_destroy(c);
+    window->render();
+    windowKey_ = std::move(windowKey);
+    return rendered;
+}
+
+bool WaylandInputWindow::renderLayer(WaylandShmSubsurface *layer,
+                                     InputWindowPart part, unsigned int width,
+                                     unsigned int height,
+                                     const std::string &themeKey) {
+    const auto region = partRegion(part, width, height);
+    auto partKey = this->partKey(part);
+    if (partKey.empty() || region.isEmpty()) {
+        if (!layer->key().empty()) {
+            layer->hide();
+            layer->setKey({});
+        }
+        return true;
+    }
+
+    auto key = stringutils::concat(themeKey, ",", region.left(), ",",
+                                   region.top(), ",", region.width(), ",",
+                                   region.height(), "\n", partKey);
+    if (layer->key() == key) {
+        return true;
+    }
+    auto *surface = layer->prerender(region.width(), region.height());
+    if (!surface) {
+        // Window will be repainted once a buffer is released.
+        return false;
+    }
+    cairo_t *c = cairo_create(surface);
+    cairo_save(c);
+    cairo_set_operator(c, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(c);
+    cairo_restore(c);
+    cairo_scale(c, window_->scale(), window_->scale());
+    cairo_translate(c, -region.left(), -region.top());
+    paintPart(part, c, width, height);
+    cairo_destroy(c);
+    layer->setPosition(region.left(), region.top());
+    layer->render();
+    layer->setKey(std::move(key));
+    return true;
+}
+
+bool WaylandInputWindow::renderBackgroundLayers(WaylandShmWindow *window,
+                                                unsigned int width,
+                                                unsigned int height,
+                                                const std::string &themeKey) {
+    if (backgroundLayers_.empty()) {
+        return false;
+    }
+    auto &theme = parent_->theme();
+    const auto &cfg = *theme.inputPanel->background;
+    const auto &image = theme.loadBackground(cfg);
+    const int marginLeft = *cfg.margin->marginLeft;
+    const int marginRight = *cfg.margin->marginRight;
+    const int marginTop = *cfg.margin->marginTop;
+    const int marginBottom = *cfg.margin->marginBottom;
+    // Overlay is positioned against the window size, and the patches need to
+    // cover the whole window.
+    if (!static_cast<cairo_surface_t *>(image) || image.overlay() ||
+        image.width() <= marginLeft + marginRight ||
+        image.height() <= marginTop + marginBottom ||
+        static_cast<int>(width) < marginLeft + marginRight ||
+        static_cast<int>(height) < marginTop + marginBottom) {
+        return false;
+    }
+
+    auto key = stringutils::concat(themeKey, ",", width, ",", height);
+    if (backgroundLayersKey_ == key) {
+        return true;
+    }
+
+    if (!background_ || backgroundKey_ != themeKey) {
+        // Only painted once with the image size, resizing window only changes
+        // the viewport of layers.
+        const auto scale = window->scale();
+        auto buffer = std::make_shared<wayland::Buffer>(
+            window->shm(), image.width() * scale, image.height() * scale,
+            WL_SHM_FORMAT_ARGB8888);
+        if (!buffer->cairoSurface() || !buffer->buffer()) {
+            return false;
+        }
+        cairo_t *c = cairo_create(buffer->cairoSurface());
+        cairo_scale(c, scale, scale);
+        cairo_set_operator(c, CAIRO_OPERATOR_SOURCE);
+        cairo_set_source_surface(c, image, 0, 0);
+        cairo_paint(c);
+        cairo_destroy(c);
+        background_ = std::move(buffer);
+        backgroundKey_ = themeKey;
     }
+
+    /*
+     * 0 1 2
+     * 3 4 5
+     * 6 7 8
+     */
+    const int sourceX[] = {0, marginLeft, image.width() - marginRight,
+                           image.width()};
+    const int sourceY[] = {0, marginTop, image.height() - marginBottom,
+                           image.height()};
+    const int targetX[] = {0, marginLeft,
+                           static_cast<int>(width) - marginRight,
+                           static_cast<int>(width)};
+    const int targetY[] = {0, marginTop,
+                           static_cast<int>(height) - marginBottom,
+                           static_cast<int>(height)};
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++) {
+            auto &layer = backgroundLayers_[row * 3 + column];
+            Rect source;
+            source.setPosition(sourceX[column], sourceY[row])
+                .setSize(sourceX[column + 1] - sourceX[column],
+                         sourceY[row + 1] - sourceY[row]);
+            layer->setPosition(targetX[column], targetY[row]);
+            layer->show(background_, source,
+                        targetX[column + 1] - targetX[column],
+                        targetY[row + 1] - targetY[row]);
+        }
+    }
+    backgroundLayersKey_ = std::move(key);
+    return true;
+}
+
+void WaylandInputWindow::hideBackgroundLayers() {
+    if (backgroundLayersKey_.empty()) {
+        return;
+    }
+    for (auto &layer : backgroundLayers_) {
+        layer->hide();
+    }
+    backgroundLayersKey_.clear();
+}
+
+void WaylandInputWindow::resetLayers() {
+    backgroundLayers_.clear();
+    textLayer_.reset();
+    candidatesLayer_.reset();
+    background_.reset();
+    backgroundKey_.clear();
+    backgroundLayersKey_.clear();
+    windowKey_.clear();
 }
 
 } // namespace fcitx::classicui
@@ -7,6 +7,7 @@
 #ifndef _FCITX_UI_CLASSIC_WAYLANDINPUTWINDOW_H_
 #define _FCITX_UI_CLASSIC_WAYLANDINPUTWINDOW_H_
 
+#include "buffer.h"
 #include "inputwindow.h"
 #include "zwp_input_panel_surface_v1.h"
 #include "zwp_input_popup_surface_v2.h"
@@ -16,10 +17,13 @@ namespace classicui {
 
 class WaylandUI;
 class WaylandWindow;
+class WaylandShmWindow;
+class WaylandShmSubsurface;
 
 class WaylandInputWindow : public InputWindow {
 public:
     WaylandInputWindow(WaylandUI *ui);
+    ~WaylandInputWindow();
 
     void initPanel();
     void resetPanel();
@@ -27,6 +31,18 @@ public:
     void repaint();
 
 private:
+    bool render(unsigned int width, unsigned int height);
+    bool renderLayers(WaylandShmWindow *window, unsigned int width,
+                      unsigned int height);
+    bool renderLayer(WaylandShmSubsurface *layer, InputWindowPart part,
+                     unsigned int width, unsigned int height,
+                     const std::string &themeKey);
+    bool renderBackgroundLayers(WaylandShmWindow *window, unsigned int width,
+                                unsigned int height,
+                                const std::string &themeKey);
+    void hideBackgroundLayers();
+    void resetLayers();
+
     WaylandUI *ui_;
     wl_fixed_t scroll_ = 0;
     std::unique_ptr<wayland::ZwpInputPanelSurfaceV1> panelSurface_;
@@ -34,6 +50,17 @@ private:
     std::unique_ptr<wayland::ZwpInputPopupSurfaceV2> panelSurfaceV2_;
     std::unique_ptr<WaylandWindow> window_;
     TrackableObjectReference<InputContext> repaintIC_;
+    // Subsurfaces of shm window, background layers are 9 patches of the theme
+    // background scaled by viewporter, and only exist if it is available.
+    std::vector<std::unique_ptr<WaylandShmSubsurface>> backgroundLayers_;
+    std::unique_ptr<WaylandShmSubsurface> textLayer_;
+    std::unique_ptr<WaylandShmSubsurface> candidatesLayer_;
+    // Theme background image shown by background layers.
+    std::shared_ptr<wayland::Buffer> background_;
+    std::string backgroundKey_;
+    std::string backgroundLayersKey_;
+    // Content of the window surface itself.
+    std::string windowKey_;
 };
 
 } // namespace classicui
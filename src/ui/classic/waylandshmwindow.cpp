@@ -7,6 +7,10 @@
 
 #include "waylandshmwindow.h"
 #include "common.h"
+#include "wl_compositor.h"
+#include "wl_region.h"
+#include "wl_subcompositor.h"
+#include "wp_viewporter.h"
 
 namespace fcitx::classicui {
 
@@ -20,41 +24,18 @@ void surfaceToBufferSize(int32_t buffer_scale, uint32_t *width,
 
 } // namespace
 
-WaylandShmWindow::WaylandShmWindow(WaylandUI *ui)
-    : WaylandWindow(ui), shm_(ui->display()->getGlobal<wayland::WlShm>()) {}
-
-WaylandShmWindow::~WaylandShmWindow() {}
-
-void WaylandShmWindow::destroyWindow() {
-    buffers_.clear();
-    buffer_ = nullptr;
-    WaylandWindow::destroyWindow();
-}
-
-void WaylandShmWindow::newBuffer(uint32_t width, uint32_t height) {
-    if (!shm_) {
+void WaylandShmBufferPool::newBuffer(uint32_t width, uint32_t height) {
+    if (!window_->shm()) {
         return;
     }
     buffers_.emplace_back(std::make_unique<wayland::Buffer>(
-        shm_.get(), width, height, WL_SHM_FORMAT_ARGB8888));
-    buffers_.back()->rendered().connect([this]() {
-        // Use defer event here, otherwise repaint may delete buffer and cause
-        // problem.
-        deferEvent_ = ui_->parent()->instance()->eventLoop().addDeferEvent(
-            [this](EventSource *) {
-                if (pending_) {
-                    pending_ = false;
-
-                    CLASSICUI_DEBUG() << "Trigger repaint";
-                    repaint_();
-                }
-                deferEvent_.reset();
-                return true;
-            });
-    });
+        window_->shm(), width, height, WL_SHM_FORMAT_ARGB8888));
+    buffers_.back()->rendered().connect(
+        [this]() { window_->bufferRendered(); });
 }
 
-cairo_surface_t *WaylandShmWindow::prerender() {
+wayland::Buffer *WaylandShmBufferPool::acquire(uint32_t width,
+                                               uint32_t height) {
     // We use double buffer.
     decltype(buffers_)::iterator iter;
     for (iter = buffers_.begin(); iter != buffers_.end(); iter++) {
@@ -65,17 +46,14 @@ cairo_surface_t *WaylandShmWindow::prerender() {
         }
     }
 
-    uint32_t bufferWidth = width_, bufferHeight = height_;
-    surfaceToBufferSize(scale_, &bufferWidth, &bufferHeight);
-
-    if (iter != buffers_.end() && ((*iter)->width() != bufferWidth ||
-                                   (*iter)->height() != bufferHeight)) {
+    if (iter != buffers_.end() &&
+        ((*iter)->width() != width || (*iter)->height() != height)) {
         buffers_.erase(iter);
         iter = buffers_.end();
     }
 
     if (iter == buffers_.end() && buffers_.size() < 2) {
-        newBuffer(bufferWidth, bufferHeight);
+        newBuffer(width, height);
         if (!buffers_.empty()) {
             iter = std::prev(buffers_.end());
         }
@@ -83,13 +61,139 @@ cairo_surface_t *WaylandShmWindow::prerender() {
 
     if (iter == buffers_.end()) {
         CLASSICUI_DEBUG() << "Couldn't find avail buffer.";
-        pending_ = true;
         // All buffers are busy.
+        window_->setPending();
+        return nullptr;
+    }
+    return iter->get();
+}
+
+WaylandShmSubsurface::WaylandShmSubsurface(WaylandUI *ui,
+                                           WaylandShmWindow *window)
+    : window_(window), buffers_(window) {
+    auto compositor = ui->display()->getGlobal<wayland::WlCompositor>();
+    auto subcompositor = ui->display()->getGlobal<wayland::WlSubcompositor>();
+    if (!compositor || !subcompositor || !window->surface()) {
+        return;
+    }
+    surface_.reset(compositor->createSurface());
+    subsurface_.reset(
+        subcompositor->getSubsurface(surface_.get(), window->surface()));
+    // Empty input region, so pointer events go to the window surface.
+    std::unique_ptr<wayland::WlRegion> region(compositor->createRegion());
+    surface_->setInputRegion(region.get());
+    if (auto viewporter = ui->display()->getGlobal<wayland::WpViewporter>()) {
+        viewport_.reset(viewporter->getViewport(surface_.get()));
+    }
+}
+
+WaylandShmSubsurface::~WaylandShmSubsurface() {}
+
+cairo_surface_t *WaylandShmSubsurface::prerender(uint32_t width,
+                                                 uint32_t height) {
+    if (!surface_) {
+        return nullptr;
+    }
+    surfaceToBufferSize(window_->scale(), &width, &height);
+    buffer_ = buffers_.acquire(width, height);
+    if (!buffer_ || !buffer_->cairoSurface()) {
         buffer_ = nullptr;
         return nullptr;
     }
+    return buffer_->cairoSurface();
+}
+
+void WaylandShmSubsurface::render() {
+    if (!buffer_) {
+        return;
+    }
+    // Take effect when window is committed.
+    buffer_->attachToSurface(surface_.get(), window_->scale());
+    buffer_ = nullptr;
+}
+
+void WaylandShmSubsurface::show(std::shared_ptr<wayland::Buffer> buffer,
+                                const Rect &source, int32_t width,
+                                int32_t height) {
+    if (!surface_ || !viewport_ || !buffer || !buffer->buffer() ||
+        source.isEmpty() || width <= 0 || height <= 0) {
+        if (shownBuffer_) {
+            hide();
+        }
+        return;
+    }
+    // Only attach if it is a new buffer, so compositor doesn't need to upload
+    // it again.
+    if (shownBuffer_ != buffer || shownScale_ != window_->scale()) {
+        surface_->attach(buffer->buffer(), 0, 0);
+        surface_->setBufferScale(window_->scale());
+        surface_->damage(0, 0, width, height);
+        shownBuffer_ = std::move(buffer);
+        shownScale_ = window_->scale();
+    }
+    viewport_->setSource(
+        wl_fixed_from_int(source.left()), wl_fixed_from_int(source.top()),
+        wl_fixed_from_int(source.width()), wl_fixed_from_int(source.height()));
+    viewport_->setDestination(width, height);
+    surface_->commit();
+}
+
+void WaylandShmSubsurface::hide() {
+    if (!surface_) {
+        return;
+    }
+    surface_->attach(nullptr, 0, 0);
+    surface_->commit();
+    shownBuffer_.reset();
+}
+
+void WaylandShmSubsurface::setPosition(int32_t x, int32_t y) {
+    if (!subsurface_ || (x_ == x && y_ == y)) {
+        return;
+    }
+    x_ = x;
+    y_ = y;
+    subsurface_->setPosition(x, y);
+}
+
+WaylandShmWindow::WaylandShmWindow(WaylandUI *ui)
+    : WaylandWindow(ui), shm_(ui->display()->getGlobal<wayland::WlShm>()) {}
+
+WaylandShmWindow::~WaylandShmWindow() {}
+
+void WaylandShmWindow::destroyWindow() {
+    buffers_.clear();
+    buffer_ = nullptr;
+    viewport_.reset();
+    transparentBuffer_.reset();
+    WaylandWindow::destroyWindow();
+}
+
+void WaylandShmWindow::bufferRendered() {
+    // Use defer event here, otherwise repaint may delete buffer and cause
+    // problem.
+    deferEvent_ = ui_->parent()->instance()->eventLoop().addDeferEvent(
+        [this](EventSource *) {
+            if (pending_) {
+                pending_ = false;
+
+                CLASSICUI_DEBUG() << "Trigger repaint";
+                repaint_();
+            }
+            deferEvent_.reset();
+            return true;
+        });
+}
+
+cairo_surface_t *WaylandShmWindow::prerender() {
+    uint32_t bufferWidth = width_, bufferHeight = height_;
+    surfaceToBufferSize(scale_, &bufferWidth, &bufferHeight);
+
+    buffer_ = buffers_.acquire(bufferWidth, bufferHeight);
+    if (!buffer_) {
+        return nullptr;
+    }
     pending_ = false;
-    buffer_ = iter->get();
 
     auto *cairoSurface = buffer_->cairoSurface();
     if (!cairoSurface) {
@@ -104,6 +208,8 @@ void WaylandShmWindow::render() {
         return;
     }
 
+    // Buffer is painted with the window size, remove the scaling.
+    viewport_.reset();
     buffer_->attachToSurface(surface_.get(), scale_);
 }
 
@@ -112,4 +218,43 @@ void WaylandShmWindow::hide() {
     surface_->commit();
 }
 
+bool WaylandShmWindow::hasSubsurface() const {
+    return surface_ && shm_ &&
+           ui_->display()->getGlobal<wayland::WlSubcompositor>();
+}
+
+bool WaylandShmWindow::hasViewporter() const {
+    return hasSubsurface() &&
+           ui_->display()->getGlobal<wayland::WpViewporter>();
+}
+
+void WaylandShmWindow::renderTransparent() {
+    auto viewporter = ui_->display()->getGlobal<wayland::WpViewporter>();
+    if (!surface_ || !shm_ || !viewporter) {
+        return;
+    }
+    if (!transparentBuffer_) {
+        // New buffer is filled with zero, which is transparent.
+        transparentBuffer_ = std::make_unique<wayland::Buffer>(
+            shm_.get(), 1, 1, WL_SHM_FORMAT_ARGB8888);
+    }
+    if (!transparentBuffer_->buffer()) {
+        return;
+    }
+    if (!viewport_) {
+        viewport_.reset(viewporter->getViewport(surface_.get()));
+    }
+    surface_->attach(transparentBuffer_->buffer(), 0, 0);
+    surface_->setBufferScale(1);
+    viewport_->setDestination(width_, height_);
+    surface_->damage(0, 0, width_, height_);
+    surface_->commit();
+}
+
+void WaylandShmWindow::commit() {
+    if (surface_) {
+        surface_->commit();
+    }
+}
+
 } // namespace fcitx::classicui
@@ -8,15 +8,76 @@
 #define _FCITX_UI_CLASSIC_WAYLANDSHMWINDOW_H_
 
 #include <cairo/cairo.h>
+#include "fcitx-utils/rect.h"
 #include "buffer.h"
 #include "waylandui.h"
 #include "waylandwindow.h"
 #include "wl_callback.h"
 #include "wl_shm.h"
+#include "wl_subsurface.h"
+#include "wp_viewport.h"
 
 namespace fcitx {
 namespace classicui {
 
+class WaylandShmWindow;
+
+// Double buffered shm buffers of a surface.
+class WaylandShmBufferPool {
+public:
+    WaylandShmBufferPool(WaylandShmWindow *window) : window_(window) {}
+
+    // Return a buffer that is not used by compositor, or nullptr if all of
+    // them are busy. The window will be repainted once a buffer is released.
+    wayland::Buffer *acquire(uint32_t width, uint32_t height);
+    void clear() { buffers_.clear(); }
+
+private:
+    void newBuffer(uint32_t width, uint32_t height);
+
+    WaylandShmWindow *window_;
+    std::vector<std::unique_ptr<wayland::Buffer>> buffers_;
+};
+
+// A synchronized subsurface of WaylandShmWindow, placed above all the
+// previously created ones. It doesn't take any input. The content is either
+// painted to its own buffers, or shown from a shared buffer, but not both.
+class WaylandShmSubsurface {
+public:
+    WaylandShmSubsurface(WaylandUI *ui, WaylandShmWindow *window);
+    ~WaylandShmSubsurface();
+
+    // Paint to a buffer of the subsurface, size is in surface coordinate.
+    cairo_surface_t *prerender(uint32_t width, uint32_t height);
+    void render();
+
+    // Show the source rectangle of a buffer, scaled to the given size. The
+    // buffer may be shared by multiple subsurfaces, so it must not be painted
+    // again once it is shown. Source is in surface coordinate, so it doesn't
+    // change with the buffer scale. Empty source or size hides it.
+    void show(std::shared_ptr<wayland::Buffer> buffer, const Rect &source,
+              int32_t width, int32_t height);
+    void hide();
+    void setPosition(int32_t x, int32_t y);
+
+    // Caller defined key of the current content, used to skip repaint.
+    const std::string &key() const { return key_; }
+    void setKey(std::string key) { key_ = std::move(key); }
+
+private:
+    WaylandShmWindow *window_;
+    std::unique_ptr<wayland::WlSurface> surface_;
+    std::unique_ptr<wayland::WlSubsurface> subsurface_;
+    std::unique_ptr<wayland::WpViewport> viewport_;
+    WaylandShmBufferPool buffers_;
+    wayland::Buffer *buffer_ = nullptr;
+    std::shared_ptr<wayland::Buffer> shownBuffer_;
+    int32_t shownScale_ = 0;
+    int32_t x_ = 0;
+    int32_t y_ = 0;
+    std::string key_;
+};
+
 class WaylandShmWindow : public WaylandWindow {
 public:
     WaylandShmWindow(WaylandUI *ui);
@@ -27,13 +88,29 @@ public:
     void render() override;
     void hide() override;
 
+    wayland::WlShm *shm() const { return shm_.get(); }
+    // Whether subsurfaces can be created.
+    bool hasSubsurface() const;
+    // Whether subsurfaces can show a part of shared buffer.
+    bool hasViewporter() const;
+    // Show nothing with the window size, content is left to subsurfaces.
+    void renderTransparent();
+    // Commit the window to apply the changes of subsurfaces.
+    void commit();
+
 private:
-    void newBuffer(uint32_t width, uint32_t height);
+    friend class WaylandShmBufferPool;
+    friend class WaylandShmSubsurface;
+    void setPending() { pending_ = true; }
+    void bufferRendered();
 
     std::shared_ptr<wayland::WlShm> shm_;
-    std::vector<std::unique_ptr<wayland::Buffer>> buffers_;
+    WaylandShmBufferPool buffers_{this};
     // Pointer to the current buffer.
     wayland::Buffer *buffer_ = nullptr;
+    // A transparent pixel scaled to the window size.
+    std::unique_ptr<wayland::Buffer> transparentBuffer_;
+    std::unique_ptr<wayland::WpViewport> viewport_;
     bool pending_ = false;
     std::unique_ptr<EventSource> deferEvent_;
 };
@@ -17,6 +17,8 @@
 #include "wl_seat.h"
 #include "wl_shell.h"
 #include "wl_shm.h"
+#include "wl_subcompositor.h"
+#include "wp_viewporter.h"
 #include "zwp_input_panel_v1.h"
 #include "zwp_input_popup_surface_v2.h"
 
@@ -78,6 +80,8 @@ WaylandUI::WaylandUI(ClassicUI *parent, const std::string &name,
     display_->requestGlobals<wayland::WlShm>();
     display_->requestGlobals<wayland::WlSeat>();
     display_->requestGlobals<wayland::ZwpInputPanelV1>();
+    display_->requestGlobals<wayland::WlSubcompositor>();
+    display_->requestGlobals<wayland::WpViewporter>();
     panelConn_ = display_->globalCreated().connect(
         [this](const std::string &name, const std::shared_ptr<void> &) {
             if (name == wayland::ZwpInputPanelV1::interface) {
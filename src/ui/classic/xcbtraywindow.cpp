@@ -395,7 +395,7 @@ void XCBTrayWindow::render() {
         cairo_paint(cr);
     }
     cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
-    cairo_set_source_surface(cr, contentSurface_.get(), 0, 0);
+    cairo_set_source_surface(cr, contentSurface(), 0, 0);
     cairo_paint(cr);
     cairo_destroy(cr);
     cairo_surface_flush(surface_.get());
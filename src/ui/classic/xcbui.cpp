@@ -6,6 +6,7 @@
  */
 
 #include "xcbui.h"
+#include <algorithm>
 #include <xcb/randr.h>
 #include <xcb/xcb_aux.h>
 #include <xcb/xinerama.h>
@@ -13,6 +14,9 @@
 #include "fcitx-utils/stringutils.h"
 #include "xcbinputwindow.h"
 #include "xcbtraywindow.h"
+#ifdef XCB_SHM_FOUND
+#include <xcb/shm.h>
+#endif
 
 namespace fcitx::classicui {
 
@@ -195,6 +199,17 @@ XCBUI::XCBUI(ClassicUI *parent, const std::string &name, xcb_connection_t *conn,
     xsettingsAtom_ = parent_->xcb()->call<IXCBModule::atom>(
         name_, "_XSETTINGS_SETTINGS", false);
 
+#ifdef XCB_SHM_FOUND
+    if (const auto *reply = xcb_get_extension_data(conn_, &xcb_shm_id);
+        reply && reply->present) {
+        auto version = makeUniqueCPtr(xcb_shm_query_version_reply(
+            conn_, xcb_shm_query_version(conn_), nullptr));
+        hasShm_ = version != nullptr;
+        shmCompletionEvent_ = reply->first_event + XCB_SHM_COMPLETION;
+        shmMajorOpcode_ = reply->major_opcode;
+    }
+#endif
+
     initScreenEvent_ = parent_->instance()->eventLoop().addTimeEvent(
         CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 10000, 0,
         [this](EventSourceTime *, uint64_t) {
@@ -431,6 +446,7 @@ void XCBUI::initScreen() {
     CLASSICUI_DEBUG() << "Screen rects are: " << rects_
                       << " Primary DPI: " << primaryDpi_
                       << " XScreen DPI: " << screenDpi_;
+    parent_->scheduleFontWarmUp();
 }
 
 void XCBUI::refreshCompositeManager() {
@@ -678,6 +694,19 @@ void XCBUI::updateCursor(InputContext *inputContext) {
 
 void XCBUI::updateCurrentInputMethod(InputContext *) { trayWindow_->update(); }
 
+bool XCBUI::useShm() const { return hasShm_ && *parent_->config().useMITSHM; }
+
+std::vector<int> XCBUI::dpis() {
+    std::vector<int> result;
+    for (const auto &rect : screenRects()) {
+        auto dpi = scaledDPI(rect.second);
+        if (std::find(result.begin(), result.end(), dpi) == result.end()) {
+            result.push_back(dpi);
+        }
+    }
+    return result;
+}
+
 int XCBUI::dpiByPosition(int x, int y) {
     int shortestDistance = INT_MAX;
     int screenDpi = -1;
@@ -58,6 +58,12 @@ public:
     int dpiByPosition(int x, int y);
     int scaledDPI(int dpi);
     const XCBFontOption &fontOption() const { return fontOption_; }
+    // Whether window content should be uploaded with MIT-SHM.
+    bool useShm() const;
+    std::vector<int> dpis() override;
+    // Event type of MIT-SHM completion event and major opcode of MIT-SHM.
+    uint8_t shmCompletionEvent() const { return shmCompletionEvent_; }
+    uint8_t shmMajorOpcode() const { return shmMajorOpcode_; }
 
 private:
     void refreshCompositeManager();
@@ -97,6 +103,9 @@ private:
     MultiScreenExtension multiScreen_ = MultiScreenExtension::EXTNone;
     int xrandrFirstEvent_ = 0;
     std::unique_ptr<EventSourceTime> initScreenEvent_;
+    bool hasShm_ = false;
+    uint8_t shmCompletionEvent_ = 0;
+    uint8_t shmMajorOpcode_ = 0;
 
     std::vector<std::pair<Rect, int>> rects_;
 
@@ -6,13 +6,34 @@
  */
 
 #include "xcbwindow.h"
+#include <algorithm>
 #include <cairo-xcb.h>
 #include <xcb/xcb.h>
 #include <xcb/xcb_aux.h>
 #include "common.h"
+#ifdef XCB_SHM_FOUND
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
 
 namespace fcitx::classicui {
 
+namespace {
+
+// Round the size of content surface up, so it is not reallocated when the
+// window size changes a little, e.g. on every key stroke.
+unsigned int contentSizeClass(unsigned int size) {
+    constexpr unsigned int step = 64;
+    return (std::max(size, 1U) + step - 1) / step * step;
+}
+
+bool needReallocate(unsigned int current, unsigned int wanted) {
+    // Also shrink if the surface is way too large.
+    return current < wanted || current > contentSizeClass(wanted) * 2;
+}
+
+} // namespace
+
 XCBWindow::XCBWindow(XCBUI *ui, int width, int height) : ui_(ui) {
     Window::resize(width, height);
 }
@@ -48,6 +69,7 @@ void XCBWindow::createWindow(xcb_visualid_t vid, bool overrideRedirect) {
     wid_ = xcb_generate_id(conn);
 
     auto depth = xcb_aux_get_depth_of_visual(screen, vid);
+    depth_ = depth;
 
     uint32_t valueMask = XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL |
                          XCB_CW_BIT_GRAVITY | XCB_CW_BACKING_STORE |
@@ -89,6 +111,11 @@ void XCBWindow::createWindow(xcb_visualid_t vid, bool overrideRedirect) {
 
     eventFilter_ = ui_->parent()->xcb()->call<IXCBModule::addEventFilter>(
         ui_->name(), [this](xcb_connection_t *, xcb_generic_event_t *event) {
+#ifdef XCB_SHM_FOUND
+            if (filterShmEvent(event)) {
+                return true;
+            }
+#endif
             return filterEvent(event);
         });
 
@@ -98,6 +125,7 @@ void XCBWindow::createWindow(xcb_visualid_t vid, bool overrideRedirect) {
             : xcb_aux_find_visual_by_id(screen, screen->root_visual),
         width_, height_));
     contentSurface_.reset();
+    currentSurface_ = nullptr;
 
     postCreateWindow();
     xcb_flush(ui_->connection());
@@ -106,6 +134,13 @@ void XCBWindow::createWindow(xcb_visualid_t vid, bool overrideRedirect) {
 void XCBWindow::destroyWindow() {
     auto *conn = ui_->connection();
     eventFilter_.reset();
+    destroyShm();
+#ifdef XCB_SHM_FOUND
+    if (gc_) {
+        xcb_free_gc(conn, gc_);
+        gc_ = 0;
+    }
+#endif
     if (wid_) {
         xcb_destroy_window(conn, wid_);
         wid_ = 0;
@@ -129,23 +164,213 @@ void XCBWindow::resize(unsigned int width, unsigned int height) {
 }
 
 cairo_surface_t *XCBWindow::prerender() {
-#if 1
-    contentSurface_.reset(cairo_surface_create_similar(
-        surface_.get(), CAIRO_CONTENT_COLOR_ALPHA, width(), height()));
-#else
-    contentSurface_.reset(
-        cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width(), height()));
+    if (!surface_) {
+        return nullptr;
+    }
+    currentSurface_ = nullptr;
+#ifdef XCB_SHM_FOUND
+    currentShmBuffer_ = nullptr;
+    if (ui_->useShm() && !shmFailed_) {
+        currentSurface_ = shmContentSurface();
+    } else {
+        destroyShm();
+    }
 #endif
+    if (!currentSurface_) {
+        currentSurface_ = pixmapContentSurface();
+    }
+    // The surface is reused, clear the area that is going to be painted.
+    auto *cr = cairo_create(currentSurface_);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_rectangle(cr, 0, 0, width(), height());
+    cairo_fill(cr);
+    cairo_destroy(cr);
+    return currentSurface_;
+}
+
+cairo_surface_t *XCBWindow::pixmapContentSurface() {
+    if (contentSurface_ && !needReallocate(contentWidth_, width()) &&
+        !needReallocate(contentHeight_, height())) {
+        return contentSurface_.get();
+    }
+    contentWidth_ = contentSizeClass(width());
+    contentHeight_ = contentSizeClass(height());
+    contentSurface_.reset(cairo_surface_create_similar(
+        surface_.get(), CAIRO_CONTENT_COLOR_ALPHA, contentWidth_,
+        contentHeight_));
+    CLASSICUI_DEBUG() << "Allocate content surface: " << contentWidth_ << " "
+                      << contentHeight_;
     return contentSurface_.get();
 }
 
+#ifdef XCB_SHM_FOUND
+bool XCBWindow::filterShmEvent(xcb_generic_event_t *event) {
+    if (!ui_->shmCompletionEvent()) {
+        return false;
+    }
+    auto responseType = event->response_type & ~0x80;
+    if (responseType == ui_->shmCompletionEvent()) {
+        auto *completion =
+            reinterpret_cast<xcb_shm_completion_event_t *>(event);
+        if (completion->drawable != wid_) {
+            return false;
+        }
+        for (auto &buffer : shmBuffers_) {
+            if (buffer.seg && buffer.seg == completion->shmseg) {
+                buffer.busy = false;
+            }
+        }
+        return true;
+    }
+    if (responseType == 0) {
+        auto *error = reinterpret_cast<xcb_generic_error_t *>(event);
+        if (error->major_code != ui_->shmMajorOpcode() ||
+            error->minor_code != XCB_SHM_PUT_IMAGE ||
+            (error->resource_id != wid_ && error->resource_id != gc_ &&
+             std::none_of(shmBuffers_.begin(), shmBuffers_.end(),
+                          [error](const ShmBuffer &buffer) {
+                              return buffer.seg == error->resource_id;
+                          }))) {
+            return false;
+        }
+        // No completion event is going to be sent for this request.
+        CLASSICUI_DEBUG() << "Failed to put shm image, fallback to pixmap.";
+        shmFailed_ = true;
+        destroyShm();
+        return true;
+    }
+    return false;
+}
+
+cairo_surface_t *XCBWindow::shmContentSurface() {
+    // Image is uploaded as is, which only works for 32 bits per pixel.
+    if (depth_ != 24 && depth_ != 32) {
+        shmFailed_ = true;
+        return nullptr;
+    }
+    // Server may still be reading the buffer of the previous frame, never
+    // wait for it here.
+    auto iter = std::find_if(
+        shmBuffers_.begin(), shmBuffers_.end(),
+        [](const ShmBuffer &buffer) { return !buffer.busy; });
+    if (iter == shmBuffers_.end()) {
+        CLASSICUI_DEBUG() << "All shm buffers are busy, use pixmap.";
+        return nullptr;
+    }
+    auto &buffer = *iter;
+    if (!buffer.surface || needReallocate(buffer.width, width()) ||
+        needReallocate(buffer.height, height())) {
+        destroyShmBuffer(buffer);
+        if (!allocateShmBuffer(buffer)) {
+            shmFailed_ = true;
+            destroyShm();
+            return nullptr;
+        }
+    }
+    currentShmBuffer_ = &buffer;
+    return buffer.surface.get();
+}
+
+bool XCBWindow::allocateShmBuffer(ShmBuffer &buffer) {
+    auto *conn = ui_->connection();
+    auto contentWidth = contentSizeClass(width());
+    auto contentHeight = contentSizeClass(height());
+    auto stride =
+        cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, contentWidth);
+    int shmid = shmget(IPC_PRIVATE, static_cast<size_t>(stride) * contentHeight,
+                       IPC_CREAT | 0600);
+    if (shmid < 0) {
+        return false;
+    }
+    void *data = shmat(shmid, nullptr, 0);
+    if (data == reinterpret_cast<void *>(-1)) {
+        shmctl(shmid, IPC_RMID, nullptr);
+        return false;
+    }
+    auto seg = xcb_generate_id(conn);
+    // Only happens when the buffer is (re)allocated.
+    auto error = makeUniqueCPtr(
+        xcb_request_check(conn, xcb_shm_attach_checked(conn, seg, shmid, 0)));
+    // Segment goes away once both sides detach from it.
+    shmctl(shmid, IPC_RMID, nullptr);
+    if (error) {
+        // E.g. remote X server.
+        CLASSICUI_DEBUG() << "Failed to attach shm segment, fallback to "
+                             "pixmap.";
+        shmdt(data);
+        return false;
+    }
+
+    buffer.seg = seg;
+    buffer.data = data;
+    buffer.width = contentWidth;
+    buffer.height = contentHeight;
+    buffer.busy = false;
+    buffer.surface.reset(cairo_image_surface_create_for_data(
+        static_cast<unsigned char *>(data), CAIRO_FORMAT_ARGB32, contentWidth,
+        contentHeight, stride));
+    if (!gc_) {
+        gc_ = xcb_generate_id(conn);
+        xcb_create_gc(conn, gc_, wid_, 0, nullptr);
+    }
+    CLASSICUI_DEBUG() << "Allocate shm content surface: " << buffer.width
+                      << " " << buffer.height;
+    return true;
+}
+
+void XCBWindow::destroyShmBuffer(ShmBuffer &buffer) {
+    if (!buffer.seg) {
+        return;
+    }
+    // Surface points to the segment.
+    buffer.surface.reset();
+    // Server keeps its own mapping until the detach request, which is
+    // processed after any pending put image.
+    xcb_shm_detach(ui_->connection(), buffer.seg);
+    shmdt(buffer.data);
+    buffer = ShmBuffer();
+}
+#endif
+
+void XCBWindow::destroyShm() {
+#ifdef XCB_SHM_FOUND
+    if (currentShmBuffer_) {
+        currentSurface_ = nullptr;
+        currentShmBuffer_ = nullptr;
+    }
+    for (auto &buffer : shmBuffers_) {
+        destroyShmBuffer(buffer);
+    }
+#endif
+}
+
 void XCBWindow::render() {
+    auto *conn = ui_->connection();
+#ifdef XCB_SHM_FOUND
+    if (currentShmBuffer_) {
+        auto &buffer = *currentShmBuffer_;
+        currentShmBuffer_ = nullptr;
+        cairo_surface_flush(buffer.surface.get());
+        // Server sends a completion event once it is done with the buffer.
+        xcb_shm_put_image(conn, wid_, gc_, buffer.width, buffer.height, 0, 0,
+                          width(), height(), 0, 0, depth_,
+                          XCB_IMAGE_FORMAT_Z_PIXMAP, 1, buffer.seg, 0);
+        buffer.busy = true;
+        xcb_flush(conn);
+        CLASSICUI_DEBUG() << "Render with shm";
+        return;
+    }
+#endif
+    if (!currentSurface_) {
+        return;
+    }
     auto *cr = cairo_create(surface_.get());
     cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-    cairo_set_source_surface(cr, contentSurface_.get(), 0, 0);
-    cairo_paint(cr);
+    cairo_set_source_surface(cr, currentSurface_, 0, 0);
+    cairo_rectangle(cr, 0, 0, width(), height());
+    cairo_fill(cr);
     cairo_destroy(cr);
-    xcb_flush(ui_->connection());
+    xcb_flush(conn);
     CLASSICUI_DEBUG() << "Render";
 }
 } // namespace fcitx::classicui
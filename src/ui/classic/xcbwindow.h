@@ -7,10 +7,14 @@
 #ifndef _FCITX_UI_CLASSIC_XCBWINDOW_H_
 #define _FCITX_UI_CLASSIC_XCBWINDOW_H_
 
+#include <array>
 #include <cairo/cairo.h>
 #include <xcb/xcb.h>
 #include "window.h"
 #include "xcbui.h"
+#ifdef XCB_SHM_FOUND
+#include <xcb/shm.h>
+#endif
 
 namespace fcitx {
 namespace classicui {
@@ -35,9 +39,49 @@ protected:
     xcb_window_t wid_ = 0;
     xcb_colormap_t colorMapNeedFree_ = 0;
     xcb_visualid_t vid_ = 0;
+    uint8_t depth_ = 0;
     std::unique_ptr<HandlerTableEntry<XCBEventFilter>> eventFilter_;
     UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface_;
+    // Content surface is kept across repaint and may be larger than the
+    // window, only the top left width() x height() area is valid.
     UniqueCPtr<cairo_surface_t, cairo_surface_destroy> contentSurface_;
+
+    // Surface returned by the last prerender, either contentSurface_ or a
+    // shm buffer.
+    cairo_surface_t *contentSurface() const { return currentSurface_; }
+
+private:
+    cairo_surface_t *pixmapContentSurface();
+    void destroyShm();
+
+    unsigned int contentWidth_ = 0;
+    unsigned int contentHeight_ = 0;
+    cairo_surface_t *currentSurface_ = nullptr;
+
+#ifdef XCB_SHM_FOUND
+    // Image surface backed by a MIT-SHM segment. Server reads it after
+    // xcb_shm_put_image returns, so it is busy until the completion event
+    // arrives.
+    struct ShmBuffer {
+        xcb_shm_seg_t seg = 0;
+        void *data = nullptr;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        bool busy = false;
+        UniqueCPtr<cairo_surface_t, cairo_surface_destroy> surface;
+    };
+
+    bool filterShmEvent(xcb_generic_event_t *event);
+    cairo_surface_t *shmContentSurface();
+    bool allocateShmBuffer(ShmBuffer &buffer);
+    void destroyShmBuffer(ShmBuffer &buffer);
+
+    // Double buffered, so painting does not need to wait for the server.
+    std::array<ShmBuffer, 2> shmBuffers_;
+    ShmBuffer *currentShmBuffer_ = nullptr;
+    xcb_gcontext_t gc_ = 0;
+    bool shmFailed_ = false;
+#endif
 };
 } // namespace classicui
 } // namespace fcitx
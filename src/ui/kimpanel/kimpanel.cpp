@@ -115,6 +115,7 @@ Kimpanel::Kimpanel(Instance *instance)
         "org.kde.impanel", [this](const std::string &, const std::string &,
                                   const std::string &newOwner) {
             FCITX_INFO() << "Kimpanel new owner" << newOwner;
+            lastState_.reset();
             setAvailable(!newOwner.empty());
         });
 }
@@ -127,6 +128,8 @@ void Kimpanel::suspend() {
     bus_->releaseName("org.kde.kimpanel.inputmethod");
     hasRelative_ = false;
     hasRelativeV2_ = false;
+    hasUpdateInputPanel_ = false;
+    lastState_.reset();
 }
 
 void Kimpanel::registerAllProperties(InputContext *ic) {
@@ -194,6 +197,10 @@ void Kimpanel::resume() {
                 if (s.find("SetRelativeSpotRectV2") != std::string::npos) {
                     hasRelativeV2_ = true;
                 }
+                if (s.find("UpdateInputPanel") != std::string::npos) {
+                    hasUpdateInputPanel_ = true;
+                    lastState_.reset();
+                }
             }
             return true;
         });
@@ -251,10 +258,12 @@ void Kimpanel::resume() {
                 static_cast<FocusGroupFocusChangedEvent &>(event);
             if (!focusEvent.newFocus() &&
                 lastInputContext_.get() == focusEvent.oldFocus()) {
-                proxy_->showAux(false);
-                proxy_->showPreedit(false);
-                proxy_->showLookupTable(false);
-                bus_->flush();
+                KimpanelInputPanelState state =
+                    lastState_.value_or(KimpanelInputPanelState{});
+                state.showAux = false;
+                state.showPreedit = false;
+                state.showLookupTable = false;
+                sendInputPanelState(std::move(state));
             }
         }));
 }
@@ -272,6 +281,9 @@ void Kimpanel::updateInputPanel(InputContext *inputContext) {
     lastInputContext_ = inputContext->watch();
     auto *instance = this->instance();
     auto &inputPanel = inputContext->inputPanel();
+    // Fields that are not touched keep the value that the panel already has.
+    KimpanelInputPanelState state = lastState_.value_or(
+        KimpanelInputPanelState{});
 
     auto preedit = instance->outputFilter(inputContext, inputPanel.preedit());
     auto auxUp = instance->outputFilter(inputContext, inputPanel.auxUp());
@@ -284,45 +296,45 @@ void Kimpanel::updateInputPanel(InputContext *inputContext) {
             auto cursor = preedit.cursor() + auxUpString.size();
             auto utf8Cursor = utf8::lengthValidated(
                 text.begin(), std::next(text.begin(), cursor));
-            proxy_->updateAux("", "");
-            proxy_->updatePreeditText(text, "");
+            state.aux.clear();
+            state.preedit = std::move(text);
             if (utf8Cursor != utf8::INVALID_LENGTH) {
-                proxy_->updatePreeditCaret(utf8Cursor);
+                state.preeditCaret = utf8Cursor;
             } else {
-                proxy_->updatePreeditCaret(0);
+                state.preeditCaret = 0;
             }
-            proxy_->showPreedit(true);
-            proxy_->showAux(false);
+            state.showPreedit = true;
+            state.showAux = false;
         } else {
-            proxy_->updateAux(text, "");
-            proxy_->updatePreeditText("", "");
-            proxy_->showPreedit(false);
-            proxy_->showAux(true);
+            state.aux = std::move(text);
+            state.preedit.clear();
+            state.showPreedit = false;
+            state.showAux = true;
         }
     } else {
-        proxy_->showAux(false);
-        proxy_->showPreedit(false);
+        state.showAux = false;
+        state.showPreedit = false;
     }
 
     auto auxDown = instance->outputFilter(inputContext, inputPanel.auxDown());
     auto auxDownString = auxDown.toString();
     auto candidateList = inputPanel.candidateList();
 
-    auto msg = bus_->createMethodCall("org.kde.impanel", "/org/kde/impanel",
-                                      "org.kde.impanel2", "SetLookupTable");
+    state.labels.clear();
+    state.texts.clear();
+    state.attrs.clear();
+    state.hasPrev = false;
+    state.hasNext = false;
+    state.cursor = -1;
+    state.layout = 0;
     auto visible =
         !auxDownString.empty() || (candidateList && candidateList->size());
     if (visible) {
-        std::vector<std::string> labels;
-        std::vector<std::string> texts;
-        std::vector<std::string> attrs;
-        bool hasPrev = false, hasNext = false;
-        int pos = -1;
-        int layout = static_cast<int>(CandidateLayoutHint::NotSet);
+        state.layout = static_cast<int>(CandidateLayoutHint::NotSet);
         if (!auxDownString.empty()) {
-            labels.emplace_back("");
-            texts.push_back(auxDownString);
-            attrs.emplace_back("");
+            state.labels.emplace_back("");
+            state.texts.push_back(auxDownString);
+            state.attrs.emplace_back("");
         }
         auxDownIsEmpty_ = auxDownString.empty();
         if (candidateList) {
@@ -336,34 +348,79 @@ void Kimpanel::updateInputPanel(InputContext *inputContext) {
                                      : candidateList->label(i);
 
                 labelText = instance->outputFilter(inputContext, labelText);
-                labels.push_back(labelText.toString());
+                state.labels.push_back(labelText.toString());
                 auto candidateText =
                     instance->outputFilter(inputContext, candidate.text());
-                texts.push_back(candidateText.toString());
-                attrs.emplace_back("");
+                state.texts.push_back(candidateText.toString());
+                state.attrs.emplace_back("");
             }
             if (auto *pageable = candidateList->toPageable()) {
-                hasPrev = pageable->hasPrev();
-                hasNext = pageable->hasNext();
+                state.hasPrev = pageable->hasPrev();
+                state.hasNext = pageable->hasNext();
             }
-            pos = candidateList->cursorIndex();
-            if (pos >= 0) {
-                pos += (auxDownString.empty() ? 0 : 1);
+            state.cursor = candidateList->cursorIndex();
+            if (state.cursor >= 0) {
+                state.cursor += (auxDownString.empty() ? 0 : 1);
             }
-            layout = static_cast<int>(candidateList->layoutHint());
+            state.layout = static_cast<int>(candidateList->layoutHint());
         }
+    }
+    state.showLookupTable = visible;
+    sendInputPanelState(std::move(state));
+}
 
-        msg << labels << texts << attrs;
-        msg << hasPrev << hasNext << pos << layout;
+void Kimpanel::sendInputPanelState(KimpanelInputPanelState state) {
+    if (hasUpdateInputPanel_) {
+        if (lastState_ && lastState_->aux == state.aux &&
+            lastState_->preedit == state.preedit &&
+            lastState_->preeditCaret == state.preeditCaret &&
+            lastState_->showAux == state.showAux &&
+            lastState_->showPreedit == state.showPreedit &&
+            lastState_->sameLookupTable(state) &&
+            lastState_->showLookupTable == state.showLookupTable) {
+            return;
+        }
+        // Send everything with a single call if panel supports it.
+        auto msg = bus_->createMethodCall("org.kde.impanel", "/org/kde/impanel",
+                                          "org.kde.impanel2",
+                                          "UpdateInputPanel");
+        msg << state.preedit << "" << state.preeditCaret << state.showPreedit;
+        msg << state.aux << "" << state.showAux;
+        msg << state.labels << state.texts << state.attrs;
+        msg << state.hasPrev << state.hasNext << state.cursor << state.layout;
+        msg << state.showLookupTable;
+        msg.send();
     } else {
-        std::vector<std::string> labels;
-        std::vector<std::string> texts;
-        std::vector<std::string> attrs;
-        msg << labels << texts << attrs;
-        msg << false << false << -1 << 0;
+        const auto *last = lastState_ ? &(*lastState_) : nullptr;
+        if (!last || last->aux != state.aux) {
+            proxy_->updateAux(state.aux, "");
+        }
+        if (!last || last->preedit != state.preedit) {
+            proxy_->updatePreeditText(state.preedit, "");
+        }
+        if (!last || last->preeditCaret != state.preeditCaret) {
+            proxy_->updatePreeditCaret(state.preeditCaret);
+        }
+        if (!last || last->showPreedit != state.showPreedit) {
+            proxy_->showPreedit(state.showPreedit);
+        }
+        if (!last || last->showAux != state.showAux) {
+            proxy_->showAux(state.showAux);
+        }
+        if (!last || !last->sameLookupTable(state)) {
+            auto msg =
+                bus_->createMethodCall("org.kde.impanel", "/org/kde/impanel",
+                                       "org.kde.impanel2", "SetLookupTable");
+            msg << state.labels << state.texts << state.attrs;
+            msg << state.hasPrev << state.hasNext << state.cursor
+                << state.layout;
+            msg.send();
+        }
+        if (!last || last->showLookupTable != state.showLookupTable) {
+            proxy_->showLookupTable(state.showLookupTable);
+        }
     }
-    msg.send();
-    proxy_->showLookupTable(visible);
+    lastState_ = std::move(state);
     bus_->flush();
 }
 
@@ -521,6 +578,8 @@ void Kimpanel::msgV1Handler(dbus::Message &msg) {
         if (!available_) {
             setAvailable(true);
         }
+        // A new panel does not know anything sent before.
+        lastState_.reset();
         registerAllProperties();
     }
 }
@@ -530,6 +589,7 @@ void Kimpanel::msgV2Handler(dbus::Message &msg) {
         if (!available_) {
             setAvailable(true);
         }
+        lastState_.reset();
         registerAllProperties();
     }
 }
@@ -549,4 +609,4 @@ public:
 };
 } // namespace fcitx
 
-FCITX_ADDON_FACTORY(fcitx::KimpanelFactory);
+FCITX_ADDON_FACTORY_V2(kimpanel, fcitx::KimpanelFactory);
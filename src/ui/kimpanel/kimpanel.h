@@ -7,6 +7,7 @@
 #ifndef _FCITX_UI_KIMPANEL_KIMPANEL_H_
 #define _FCITX_UI_KIMPANEL_KIMPANEL_H_
 
+#include <optional>
 #include "fcitx-utils/dbus/bus.h"
 #include "fcitx-utils/dbus/servicewatcher.h"
 #include "fcitx-utils/event.h"
@@ -24,6 +25,31 @@ namespace fcitx {
 class KimpanelProxy;
 class Action;
 
+// The input panel state that is last sent to kimpanel.
+struct KimpanelInputPanelState {
+    std::string aux;
+    std::string preedit;
+    int32_t preeditCaret = 0;
+    bool showAux = false;
+    bool showPreedit = false;
+
+    std::vector<std::string> labels;
+    std::vector<std::string> texts;
+    std::vector<std::string> attrs;
+    bool hasPrev = false;
+    bool hasNext = false;
+    int32_t cursor = -1;
+    int32_t layout = 0;
+    bool showLookupTable = false;
+
+    bool sameLookupTable(const KimpanelInputPanelState &other) const {
+        return labels == other.labels && texts == other.texts &&
+               attrs == other.attrs && hasPrev == other.hasPrev &&
+               hasNext == other.hasNext && cursor == other.cursor &&
+               layout == other.layout;
+    }
+};
+
 class Kimpanel : public UserInterface {
 public:
     Kimpanel(Instance *instance);
@@ -47,6 +73,7 @@ public:
 
 private:
     void setAvailable(bool available);
+    void sendInputPanelState(KimpanelInputPanelState state);
 
     std::string iconName(const std::string &icon) {
         return IconTheme::iconName(icon, inFlatpak_);
@@ -68,6 +95,8 @@ private:
     std::unique_ptr<dbus::Slot> relativeQuery_;
     bool hasRelative_ = false;
     bool hasRelativeV2_ = false;
+    bool hasUpdateInputPanel_ = false;
+    std::optional<KimpanelInputPanelState> lastState_;
     const bool inFlatpak_ = fs::isreg("/.flatpak-info");
 };
 } // namespace fcitx
@@ -7,20 +7,41 @@
 
 #include "fcitx-utils/log.h"
 #include "fcitx-utils/metastring.h"
+#include "fcitx/addonfactory.h"
 #include "fcitx/addoninstance.h"
+#include "fcitx/addonloader.h"
 #include "fcitx/addonmanager.h"
 #include "addon/dummyaddon_public.h"
 #include "testdir.h"
 
 double f(int) { return 0; }
 
+class DeferredAddonFactory : public fcitx::AddonFactory {
+public:
+    DeferredAddonFactory(bool defer) : defer_(defer) {}
+    fcitx::AddonInstance *create(fcitx::AddonManager *manager) override {
+        if (defer_) {
+            manager->deferAddonReady("deferredaddon");
+        }
+        return new fcitx::AddonInstance;
+    }
+
+private:
+    bool defer_;
+};
+
 int main() {
     fcitx::Log::setLogRule("default=5");
     setenv("SKIP_FCITX_PATH", "1", 1);
     setenv("XDG_DATA_DIRS", FCITX5_SOURCE_DIR "/test/addon2", 1);
     setenv("FCITX_ADDON_DIRS", FCITX5_BINARY_DIR "/test/addon", 1);
+    DeferredAddonFactory deferredFactory(true);
+    DeferredAddonFactory dependentFactory(false);
+    fcitx::StaticAddonRegistry registry = {
+        {"deferredaddon", &deferredFactory},
+        {"deferreddependent", &dependentFactory}};
     fcitx::AddonManager manager;
-    manager.registerDefaultLoader(nullptr);
+    manager.registerDefaultLoader(&registry);
     manager.load();
     auto *addon = manager.addon("dummyaddon");
     FCITX_ASSERT(addon);
@@ -38,5 +59,12 @@ int main() {
     FCITX_ASSERT(addon2);
     auto *addon3 = manager.addon("dummyaddon3");
     FCITX_ASSERT(!addon3);
+
+    // Dependents are held back until the addon is ready.
+    FCITX_ASSERT(!manager.addon("deferredaddon"));
+    FCITX_ASSERT(!manager.addon("deferreddependent"));
+    manager.setAddonReady("deferredaddon");
+    FCITX_ASSERT(manager.addon("deferredaddon"));
+    FCITX_ASSERT(manager.addon("deferreddependent"));
     return 0;
 }
@@ -0,0 +1,177 @@
+/*
+ * SPDX-FileCopyrightText: 2020~2020 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <algorithm>
+#include <thread>
+#include "fcitx-utils/dbus/bus.h"
+#include "fcitx-utils/dbus/variant.h"
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/testing.h"
+#include "fcitx/addonmanager.h"
+#include "fcitx/instance.h"
+#include "testdir.h"
+
+using namespace fcitx;
+using namespace fcitx::dbus;
+
+#define FCITX_SERVICE "org.fcitx.Fcitx5"
+#define FCITX_CONTROLLER_PATH "/controller"
+#define FCITX_CONTROLLER_INTERFACE "org.fcitx.Fcitx.Controller1"
+
+using ConfigList = std::vector<DBusStruct<std::string, Variant>>;
+using GroupList =
+    std::vector<DBusStruct<std::string, std::string,
+                           std::vector<DBusStruct<std::string, std::string>>>>;
+
+Message callController(Bus &bus, const std::string &method) {
+    return bus.createMethodCall(FCITX_SERVICE, FCITX_CONTROLLER_PATH,
+                                FCITX_CONTROLLER_INTERFACE, method.data());
+}
+
+std::vector<std::string> inputMethodGroups(Bus &bus) {
+    auto msg = callController(bus, "InputMethodGroups");
+    auto reply = msg.call(0);
+    FCITX_ASSERT(reply.type() == MessageType::Reply);
+    std::vector<std::string> groups;
+    reply >> groups;
+    return groups;
+}
+
+bool hasGroup(Bus &bus, const std::string &name) {
+    auto groups = inputMethodGroups(bus);
+    return std::find(groups.begin(), groups.end(), name) != groups.end();
+}
+
+void testGetConfig(Bus &bus) {
+    {
+        auto msg = callController(bus, "GetConfig");
+        msg << "fcitx://config/global";
+        auto reply = msg.call(0);
+        FCITX_ASSERT(reply.type() == MessageType::Reply);
+    }
+    {
+        auto msg = callController(bus, "GetConfig");
+        msg << "fcitx://config/unknown";
+        auto reply = msg.call(0);
+        FCITX_ASSERT(reply.type() == MessageType::Error);
+        FCITX_ASSERT(reply.errorName() ==
+                     "org.freedesktop.DBus.Error.InvalidArgs");
+    }
+    {
+        auto msg = callController(bus, "SetConfig");
+        msg << "fcitx://config/addon/nonexist"
+            << Variant(std::vector<DictEntry<std::string, Variant>>{});
+        auto reply = msg.call(0);
+        FCITX_ASSERT(reply.type() == MessageType::Error);
+    }
+}
+
+void testApplyConfigBatch(Bus &bus, EventLoop &loop) {
+    int groupsChanged = 0;
+    std::unique_ptr<EventSourceTime> exitEvent;
+    auto slot = bus.addMatch(
+        MatchRule(FCITX_SERVICE, "", FCITX_CONTROLLER_INTERFACE,
+                  "InputMethodGroupsChanged"),
+        [&groupsChanged, &loop, &exitEvent](Message &) {
+            ++groupsChanged;
+            // Wait a little bit so a duplicated signal would be counted.
+            exitEvent = loop.addTimeEvent(
+                CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 200000, 0,
+                [&loop](EventSource *, uint64_t) {
+                    loop.exit();
+                    return true;
+                });
+            return false;
+        });
+    FCITX_ASSERT(slot);
+
+    GroupList groups;
+    groups.emplace_back(std::make_tuple(
+        "TestGroup", "us",
+        std::vector<DBusStruct<std::string, std::string>>{
+            std::make_tuple("keyboard-us", "")}));
+
+    // A bad config uri rejects the whole batch, including the groups.
+    {
+        ConfigList configs;
+        configs.emplace_back(std::make_tuple(
+            "fcitx://config/inputmethod/nonexist",
+            Variant(std::vector<DictEntry<std::string, Variant>>{})));
+        auto msg = callController(bus, "ApplyConfigBatch");
+        msg << configs << groups;
+        auto reply = msg.call(0);
+        FCITX_ASSERT(reply.type() == MessageType::Error);
+        FCITX_ASSERT(!hasGroup(bus, "TestGroup"));
+    }
+
+    // Unknown input method is rejected instead of being dropped.
+    {
+        GroupList badGroups;
+        badGroups.emplace_back(std::make_tuple(
+            "TestGroup", "us",
+            std::vector<DBusStruct<std::string, std::string>>{
+                std::make_tuple("keyboard-us", ""),
+                std::make_tuple("nonexist", "")}));
+        auto msg = callController(bus, "ApplyConfigBatch");
+        msg << ConfigList() << badGroups;
+        auto reply = msg.call(0);
+        FCITX_ASSERT(reply.type() == MessageType::Error);
+        FCITX_ASSERT(reply.errorName() ==
+                     "org.freedesktop.DBus.Error.InvalidArgs");
+        FCITX_ASSERT(!hasGroup(bus, "TestGroup"));
+    }
+
+    {
+        auto msg = callController(bus, "ApplyConfigBatch");
+        msg << ConfigList() << groups;
+        auto reply = msg.call(0);
+        FCITX_ASSERT(reply.type() == MessageType::Reply);
+        FCITX_ASSERT(hasGroup(bus, "TestGroup"));
+    }
+
+    std::unique_ptr<EventSourceTime> timeout(loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 5000000, 0,
+        [&loop](EventSource *, uint64_t) {
+            loop.exit();
+            return true;
+        }));
+    loop.exec();
+    FCITX_ASSERT(groupsChanged == 1) << groupsChanged;
+}
+
+void client() {
+    Bus bus(BusType::Session);
+    EventLoop loop;
+    bus.attachEventLoop(&loop);
+
+    testGetConfig(bus);
+    testApplyConfigBatch(bus, loop);
+
+    auto msg = callController(bus, "Exit");
+    msg.send();
+    bus.flush();
+}
+
+int main() {
+    setupTestingEnvironment(FCITX5_BINARY_DIR,
+                            {"src/modules/dbus", "src/im/keyboard"},
+                            {"test", FCITX5_SOURCE_DIR "/src/modules"});
+
+    char arg0[] = "testdbusmodule";
+    char arg1[] = "--disable=all";
+    char arg2[] = "--enable=dbus,keyboard";
+    char *argv[] = {arg0, arg1, arg2};
+    Instance instance(FCITX_ARRAY_SIZE(argv), argv);
+    instance.addonManager().registerDefaultLoader(nullptr);
+    EventDispatcher dispatcher;
+    dispatcher.attach(&instance.eventLoop());
+    std::thread thread;
+    dispatcher.schedule([&thread]() { thread = std::thread(client); });
+    instance.exec();
+    thread.join();
+    return 0;
+}
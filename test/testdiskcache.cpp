@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <string>
+#include "fcitx-utils/diskcache.h"
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/stringutils.h"
+
+using namespace fcitx;
+
+void writeFile(const std::string &path, const std::string &content) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FCITX_ASSERT(fd >= 0);
+    FCITX_ASSERT(fs::safeWrite(fd, content.data(), content.size()) ==
+                 static_cast<ssize_t>(content.size()));
+    close(fd);
+}
+
+void testSaveLoad(const std::string &dir) {
+    auto source = stringutils::joinPath(dir, "source");
+    writeFile(source, "abc");
+
+    DiskCacheWriter writer;
+    writer.writeUInt32(42);
+    writer.writeString("hello");
+
+    {
+        DiskCache cache("test", 1);
+        cache.addSourceFile(source);
+        FCITX_ASSERT(!cache.load());
+        FCITX_ASSERT(cache.save(writer.data()));
+        FCITX_ASSERT(fs::isreg(cache.path()));
+    }
+    {
+        DiskCache cache("test", 1);
+        cache.addSourceFile(source);
+        auto data = cache.load();
+        FCITX_ASSERT(data);
+        FCITX_ASSERT(reinterpret_cast<uintptr_t>(data->data()) % 8 == 0);
+        DiskCacheReader reader(data->view());
+        uint32_t value;
+        std::string str;
+        FCITX_ASSERT(reader.readUInt32(value) && value == 42);
+        FCITX_ASSERT(reader.readString(str) && str == "hello");
+        FCITX_ASSERT(reader.atEnd());
+        FCITX_ASSERT(!reader.readUInt32(value));
+    }
+    // Version is part of the key.
+    {
+        DiskCache cache("test", 2);
+        cache.addSourceFile(source);
+        FCITX_ASSERT(!cache.load());
+    }
+    // Source changes.
+    writeFile(source, "abcd");
+    {
+        DiskCache cache("test", 1);
+        cache.addSourceFile(source);
+        FCITX_ASSERT(!cache.load());
+    }
+    {
+        DiskCache cache("test", 1);
+        cache.addSourceData("abc");
+        FCITX_ASSERT(cache.save(writer.data()));
+        FCITX_ASSERT(cache.load());
+
+        // Corrupt the payload.
+        int fd = open(cache.path().c_str(), O_WRONLY);
+        FCITX_ASSERT(fd >= 0);
+        FCITX_ASSERT(lseek(fd, -1, SEEK_END) >= 0);
+        FCITX_ASSERT(fs::safeWrite(fd, "x", 1) == 1);
+        close(fd);
+        FCITX_ASSERT(!cache.load());
+    }
+    {
+        DiskCache cache("test", 1);
+        cache.addSourceData("abd");
+        FCITX_ASSERT(!cache.load());
+    }
+}
+
+void testEvict() {
+    std::string payload(1000, 'a');
+    DiskCache first("first", 1);
+    DiskCache second("second", 1);
+    DiskCache third("third", 1);
+    FCITX_ASSERT(first.save(payload));
+    FCITX_ASSERT(second.save(payload));
+    FCITX_ASSERT(third.save(payload));
+
+    // Make first the oldest one, then use it so second becomes the least
+    // recently used one.
+    struct timespec times[2] = {{0, 0}, {0, 0}};
+    FCITX_ASSERT(utimensat(AT_FDCWD, first.path().c_str(), times, 0) == 0);
+    times[0].tv_sec = times[1].tv_sec = 1;
+    FCITX_ASSERT(utimensat(AT_FDCWD, second.path().c_str(), times, 0) == 0);
+    FCITX_ASSERT(first.load());
+
+    DiskCache::evict(2500);
+    FCITX_ASSERT(fs::isreg(first.path()));
+    FCITX_ASSERT(!fs::isreg(second.path()));
+    FCITX_ASSERT(fs::isreg(third.path()));
+
+    DiskCache::evict(0);
+    FCITX_ASSERT(!fs::isreg(first.path()));
+    FCITX_ASSERT(!fs::isreg(third.path()));
+}
+
+int main() {
+    char dirTemplate[] = "/tmp/fcitx_diskcache_XXXXXX";
+    FCITX_ASSERT(mkdtemp(dirTemplate));
+    std::string dir = dirTemplate;
+    FCITX_ASSERT(setenv("XDG_CACHE_HOME", dir.c_str(), 1) == 0);
+    unsetenv("SKIP_FCITX_USER_PATH");
+
+    testSaveLoad(dir);
+    testEvict();
+
+    unlink(stringutils::joinPath(dir, "source").c_str());
+    rmdir(stringutils::joinPath(dir, "fcitx5").c_str());
+    rmdir(dir.c_str());
+    return 0;
+}
@@ -7,12 +7,56 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <numeric>
 #include <fcitx-utils/event.h>
 #include "fcitx-utils/log.h"
 
 using namespace fcitx;
 
+void testStatistics() {
+    EventLoop e;
+    e.setStatisticsEnabled(true);
+    e.setStallThreshold(10000);
+
+    std::unique_ptr<EventSource> inherited;
+    std::unique_ptr<EventSource> labeled;
+    {
+        EventSourceLabel label("test");
+        labeled = e.addDeferEvent([&e, &inherited](EventSource *) {
+            usleep(20000);
+            // Created in callback of "test".
+            inherited = e.addDeferEvent([&e](EventSource *) {
+                e.exit();
+                return true;
+            });
+            return true;
+        });
+    }
+    std::unique_ptr<EventSource> unlabeled(
+        e.addDeferEvent([](EventSource *) { return true; }));
+    labeled->setOneShot();
+    unlabeled->setOneShot();
+    FCITX_ASSERT(e.exec());
+
+    auto statistics = e.statistics();
+    FCITX_ASSERT(statistics.size() == 2);
+    FCITX_ASSERT(statistics[0].label == "test");
+    FCITX_ASSERT(statistics[0].count == 2);
+    FCITX_ASSERT(statistics[0].maxTime >= 20000);
+    // 20ms is in the bucket of [16ms, 64ms), or later ones on a busy machine.
+    FCITX_ASSERT(std::accumulate(statistics[0].histogram.begin() + 4,
+                                 statistics[0].histogram.end(), 0) == 1);
+    FCITX_ASSERT(statistics[1].label.empty());
+    FCITX_ASSERT(statistics[1].count == 1);
+
+    e.resetStatistics();
+    FCITX_ASSERT(e.statistics().empty());
+    e.setStatisticsEnabled(false);
+}
+
 int main() {
+    testStatistics();
+
     EventLoop e;
 
     int pipefd[2];
@@ -6,6 +6,7 @@
  */
 
 #include <vector>
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/log.h"
 #include "fcitx/focusgroup.h"
 #include "fcitx/inputcontext.h"
@@ -200,6 +201,150 @@ void test_property() {
     FCITX_ASSERT(testProperty2->num() == 0);
 }
 
+void test_lazy_property() {
+    InputContextManager manager;
+    int created = 0;
+    FactoryFor<TestSharedProperty> testFactory([&created](InputContext &) {
+        created++;
+        return new TestSharedProperty;
+    });
+    manager.registerProperty("shared", &testFactory);
+    manager.setPropertyPropagatePolicy(PropertyPropagatePolicy::All);
+    std::vector<std::unique_ptr<InputContext>> ic;
+    ic.emplace_back(new TestInputContext(manager, "Firefox"));
+    ic.emplace_back(new TestInputContext(manager, "Chrome"));
+    ic.emplace_back(new TestInputContext(manager, "Chrome"));
+    FCITX_ASSERT(created == 0);
+    FCITX_ASSERT(!ic[0]->hasProperty(&testFactory));
+
+    // Created property copies the value from others.
+    ic[0]->propertyFor(&testFactory)->setNum(1);
+    FCITX_ASSERT(created == 1);
+    FCITX_ASSERT(ic[0]->hasProperty(&testFactory));
+    FCITX_ASSERT(!ic[1]->hasProperty(&testFactory));
+    FCITX_ASSERT(ic[1]->propertyFor(&testFactory)->num() == 1);
+    FCITX_ASSERT(created == 2);
+    FCITX_ASSERT(!ic[2]->hasProperty(&testFactory));
+
+    // Propagation creates the property in the scope.
+    ic[1]->propertyFor(&testFactory)->setNum(2);
+    ic[1]->updateProperty(&testFactory);
+    FCITX_ASSERT(created == 3);
+    FCITX_ASSERT(ic[2]->hasProperty(&testFactory));
+    FCITX_ASSERT(ic[0]->propertyFor(&testFactory)->num() == 2);
+    FCITX_ASSERT(ic[2]->propertyFor(&testFactory)->num() == 2);
+
+    // New slot for existing input contexts is also lazy.
+    FactoryFor<TestProperty> testFactory2([&created](InputContext &) {
+        created++;
+        return new TestProperty;
+    });
+    manager.registerProperty("property", &testFactory2);
+    FCITX_ASSERT(created == 3);
+    FCITX_ASSERT(!ic[2]->hasProperty(&testFactory2));
+    testFactory.unregister();
+    FCITX_ASSERT(ic[2]->propertyFor(&testFactory2)->num() == 0);
+    FCITX_ASSERT(created == 4);
+}
+
+void test_lazy_property_holder_destroyed() {
+    InputContextManager manager;
+    FactoryFor<TestSharedProperty> testFactory(
+        [](InputContext &) { return new TestSharedProperty; });
+    manager.registerProperty("shared", &testFactory);
+    manager.setPropertyPropagatePolicy(PropertyPropagatePolicy::Program);
+    std::vector<std::unique_ptr<InputContext>> ic;
+    ic.emplace_back(new TestInputContext(manager, "Firefox"));
+    ic.emplace_back(new TestInputContext(manager, "Firefox"));
+    ic.emplace_back(new TestInputContext(manager, "Chrome"));
+
+    ic[0]->propertyFor(&testFactory)->setNum(1);
+    ic[0]->updateProperty(&testFactory);
+    // The only input context that changed the value is gone.
+    ic.erase(ic.begin());
+    FCITX_ASSERT(ic[0]->propertyFor(&testFactory)->num() == 1);
+    ic.emplace_back(new TestInputContext(manager, "Firefox"));
+    FCITX_ASSERT(ic.back()->propertyFor(&testFactory)->num() == 1);
+    // Other program is not affected.
+    FCITX_ASSERT(ic[1]->propertyFor(&testFactory)->num() == 0);
+}
+
+void test_many_input_contexts() {
+    InputContextManager manager;
+    manager.setPropertyPropagatePolicy(PropertyPropagatePolicy::Program);
+    int created = 0;
+    std::vector<std::unique_ptr<FactoryFor<TestSharedProperty>>> factories;
+    for (int i = 0; i < 10; i++) {
+        factories.emplace_back(std::make_unique<FactoryFor<TestSharedProperty>>(
+            [&created](InputContext &) {
+                created++;
+                return new TestSharedProperty;
+            }));
+        FCITX_ASSERT(manager.registerProperty(std::to_string(i),
+                                              factories.back().get()));
+    }
+
+    constexpr int numInputContext = 10000;
+    constexpr int numProgram = 100;
+    std::vector<std::unique_ptr<InputContext>> ic;
+    for (int i = 0; i < numInputContext; i++) {
+        ic.emplace_back(
+            new TestInputContext(manager, std::to_string(i % numProgram)));
+    }
+    FCITX_ASSERT(created == 0);
+    // Only a few input contexts use a property in practice.
+    for (int i = 0; i < numInputContext; i += 10) {
+        auto *factory = factories[(i / 10) % factories.size()].get();
+        ic[i]->propertyFor(factory)->setNum(i);
+    }
+    FCITX_ASSERT(created == numInputContext / 10) << created;
+    // Propagation only creates the property within the program.
+    ic[1]->propertyFor(factories[0].get())->setNum(1);
+    ic[1]->updateProperty(factories[0].get());
+    FCITX_ASSERT(created == numInputContext / 10 +
+                                numInputContext / numProgram)
+        << created;
+    FCITX_ASSERT(ic[numInputContext - numProgram + 1]
+                     ->propertyFor(factories[0].get())
+                     ->num() == 1);
+    FCITX_ASSERT(ic.back()->propertyFor(factories[0].get())->num() == 0);
+}
+
+void test_input_context_timing() {
+    InputContextManager manager;
+    std::vector<std::unique_ptr<FactoryFor<TestSharedProperty>>> factories;
+    for (int i = 0; i < 10; i++) {
+        factories.emplace_back(std::make_unique<FactoryFor<TestSharedProperty>>(
+            [](InputContext &) { return new TestSharedProperty; }));
+        FCITX_ASSERT(manager.registerProperty(std::to_string(i),
+                                              factories.back().get()));
+    }
+
+    constexpr int numInputContext = 10000;
+    // Eager accesses every property right after the input context is
+    // created, which is what the properties used to cost.
+    for (bool eager : {true, false}) {
+        std::vector<std::unique_ptr<InputContext>> ic;
+        ic.reserve(numInputContext);
+        auto start = now(CLOCK_MONOTONIC);
+        for (int i = 0; i < numInputContext; i++) {
+            ic.emplace_back(new TestInputContext(manager));
+            if (eager) {
+                for (const auto &factory : factories) {
+                    ic.back()->propertyFor(factory.get());
+                }
+            }
+        }
+        auto created = now(CLOCK_MONOTONIC);
+        ic.clear();
+        auto destroyed = now(CLOCK_MONOTONIC);
+        FCITX_INFO() << (eager ? "Eager" : "Lazy") << " properties: create "
+                     << numInputContext << " input contexts in "
+                     << (created - start) << "us, destroy in "
+                     << (destroyed - created) << "us";
+    }
+}
+
 void test_preedit_override() {
     InputContextManager manager;
     auto ic = std::make_unique<TestInputContext>(manager, "Firefox");
@@ -219,6 +364,10 @@ void test_preedit_override() {
 int main() {
     test_simple();
     test_property();
+    test_lazy_property();
+    test_lazy_property_holder_destroyed();
+    test_many_input_contexts();
+    test_input_context_timing();
     test_preedit_override();
 
     return 0;
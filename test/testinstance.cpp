@@ -4,14 +4,97 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <fstream>
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/fs.h"
 #include "fcitx-utils/testing.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/globalconfig.h"
+#include "fcitx/inputcontextmanager.h"
+#include "fcitx/inputmethodmanager.h"
+#include "fcitx/inputpanel.h"
 #include "fcitx/instance.h"
 #include "testdir.h"
 
 using namespace fcitx;
 
+class TestInputContext : public InputContext {
+public:
+    TestInputContext(InputContextManager &manager,
+                     const std::string &program = "")
+        : InputContext(manager, program) {
+        created();
+    }
+
+    ~TestInputContext() { destroy(); }
+
+    const char *frontend() const override { return "test"; }
+
+    void commitStringImpl(const std::string &) override {}
+    void deleteSurroundingTextImpl(int, unsigned int) override {}
+    void forwardKeyImpl(const ForwardKeyEvent &) override {}
+    void updatePreeditImpl() override {}
+};
+
+void testOutputFilter(Instance *instance) {
+    TestInputContext ic(instance->inputContextManager());
+    Text text("A long string that does not fit in small buffer");
+    text.append("Another long string that does not fit in small buffer");
+
+    // Nothing is connected, the segments are shared with the original.
+    auto result = instance->outputFilter(&ic, text);
+    FCITX_ASSERT(result.size() == 2);
+    FCITX_ASSERT(&result.stringAt(0) == &text.stringAt(0));
+
+    {
+        ScopedConnection conn = instance->connect<Instance::OutputFilter>(
+            [](InputContext *, Text &text) { text.append("B"); });
+        auto filtered = instance->outputFilter(&ic, text);
+        FCITX_ASSERT(filtered.toString() == text.toString() + "B");
+        FCITX_ASSERT(text.size() == 2);
+        FCITX_ASSERT(&filtered.stringAt(0) != &text.stringAt(0));
+    }
+
+    ic.inputPanel().setClientPreedit(Text("abc"));
+    ic.setCapabilityFlags(CapabilityFlag::Password);
+    auto masked = instance->outputFilter(&ic, ic.inputPanel().clientPreedit());
+    FCITX_ASSERT(masked.toString() ==
+                 "\xe2\x80\xa2\xe2\x80\xa2\xe2\x80\xa2");
+    // Not preedit, so not masked.
+    auto unmasked = instance->outputFilter(&ic, Text("abc"));
+    FCITX_ASSERT(unmasked.toString() == "abc");
+}
+
+void testProgramState(Instance *instance) {
+    FCITX_ASSERT(instance->globalConfig().shareInputState() ==
+                 PropertyPropagatePolicy::Program);
+    auto &imManager = instance->inputMethodManager();
+    auto group = imManager.currentGroup();
+    group.inputMethodList().emplace_back("testim");
+    imManager.setGroup(std::move(group));
+
+    {
+        TestInputContext ic(instance->inputContextManager(), "testprogram");
+        instance->setCurrentInputMethod(&ic, "testim", true);
+        FCITX_ASSERT(instance->inputMethod(&ic) == "testim");
+    }
+
+    // The state is restored from the program state store when the first
+    // input context of the program is created again.
+    TestInputContext ic(instance->inputContextManager(), "testprogram");
+    FCITX_ASSERT(instance->inputMethod(&ic) == "testim");
+
+    // Restored state is propagated like a normal change, so an input context
+    // created later sees the same state.
+    TestInputContext ic2(instance->inputContextManager(), "testprogram");
+    FCITX_ASSERT(instance->inputMethod(&ic2) == "testim");
+    instance->setCurrentInputMethod(&ic2, "keyboard-us", true);
+    FCITX_ASSERT(instance->inputMethod(&ic) == "keyboard-us");
+
+    TestInputContext other(instance->inputContextManager(), "otherprogram");
+    FCITX_ASSERT(instance->inputMethod(&other) == "keyboard-us");
+}
+
 void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
     dispatcher->schedule([instance]() {
         FCITX_ASSERT(!instance->checkUpdate());
@@ -25,12 +108,20 @@ void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
         FCITX_ASSERT(instance->checkUpdate());
         hasUpdateTrue.reset();
         FCITX_ASSERT(!instance->checkUpdate());
+        testOutputFilter(instance);
+        testProgramState(instance);
         instance->exit();
     });
 }
 
 int main() {
-    setupTestingEnvironment(FCITX5_BINARY_DIR, {"testing/testim"}, {});
+    setupTestingEnvironment(FCITX5_BINARY_DIR, {"testing/testim"}, {"test"});
+    // Share input state per program, so program state store is used.
+    const std::string configDir = FCITX5_BINARY_DIR "/test/testinstance_config";
+    fs::makePath(configDir);
+    std::ofstream(configDir + "/config")
+        << "[Behavior]\nShareInputState=Program\n";
+    setenv("FCITX_CONFIG_DIRS", configDir.data(), 1);
 
     char arg0[] = "testinstance";
     char arg1[] = "--disable=all";
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include <xkbcommon/xkbcommon.h>
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/misc.h"
+#include "fcitx/keycodetable.h"
+
+using namespace fcitx;
+
+int main() {
+    UniqueCPtr<xkb_context, xkb_context_unref> context(
+        xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+    FCITX_ASSERT(context);
+    xkb_rule_names names{"evdev", "pc101", "us", "", ""};
+    UniqueCPtr<xkb_keymap, xkb_keymap_unref> keymap(xkb_keymap_new_from_names(
+        context.get(), &names, XKB_KEYMAP_COMPILE_NO_FLAGS));
+    FCITX_ASSERT(keymap);
+    UniqueCPtr<xkb_state, xkb_state_unref> state(xkb_state_new(keymap.get()));
+    FCITX_ASSERT(state);
+
+    KeycodeTable table(keymap.get());
+    FCITX_ASSERT(table.keymap() == keymap.get());
+
+    // KEY_A is 30 in evdev, xkb keycode is offset by 8.
+    constexpr uint32_t keyA = 30 + 8;
+    FCITX_ASSERT(table.keycode(state.get(), FcitxKey_a) == keyA);
+    // Same key needs shift, client would read it as a.
+    FCITX_ASSERT(table.keycode(state.get(), FcitxKey_A) == 0);
+    // Not in the keymap.
+    FCITX_ASSERT(table.keycode(state.get(), FcitxKey_Cyrillic_a) == 0);
+
+    auto shift = xkb_keymap_mod_get_index(keymap.get(), XKB_MOD_NAME_SHIFT);
+    xkb_state_update_mask(state.get(), 1 << shift, 0, 0, 0, 0, 0);
+    FCITX_ASSERT(table.keycode(state.get(), FcitxKey_A) == keyA);
+    FCITX_ASSERT(table.keycode(state.get(), FcitxKey_a) == 0);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <unistd.h>
+#include "fcitx-utils/log.h"
+#include "fcitx/programstate_p.h"
+
+using namespace fcitx;
+
+int main() {
+    char fname[] = "programstateXXXXXX";
+    int f = mkstemp(fname);
+    FCITX_ASSERT(f != -1);
+    close(f);
+
+    {
+        ProgramStateStore store;
+        store.open(fname, 2);
+        FCITX_ASSERT(store.isOpen());
+        FCITX_ASSERT(!store.find("a"));
+        store.update("a", {true, false, "pinyin"});
+        store.update("b", {false, true, ""});
+        auto state = store.find("a");
+        FCITX_ASSERT(state);
+        FCITX_ASSERT(state->active);
+        FCITX_ASSERT(!state->preeditEnabled);
+        FCITX_ASSERT(state->localIM == "pinyin");
+        // Evict least recently updated one.
+        store.update("a", {true, true, "pinyin"});
+        store.update("c", {true, true, ""});
+        FCITX_ASSERT(store.size() == 2);
+        FCITX_ASSERT(!store.find("b"));
+        FCITX_ASSERT(store.find("a"));
+        // Too long program name is ignored.
+        store.update(std::string(200, 'x'), {true, true, ""});
+        FCITX_ASSERT(!store.find(std::string(200, 'x')));
+    }
+
+    {
+        // State survives reopen.
+        ProgramStateStore store;
+        store.open(fname, 2);
+        FCITX_ASSERT(store.size() == 2);
+        auto state = store.find("a");
+        FCITX_ASSERT(state);
+        FCITX_ASSERT(state->preeditEnabled);
+        FCITX_ASSERT(state->localIM == "pinyin");
+        store.update("d", {false, true, ""});
+        FCITX_ASSERT(!store.find("a"));
+        FCITX_ASSERT(store.find("c"));
+    }
+
+    {
+        // Different capacity drops old data.
+        ProgramStateStore store;
+        store.open(fname, 4);
+        FCITX_ASSERT(store.size() == 0);
+    }
+
+    {
+        ProgramStateStore store;
+        store.open("");
+        FCITX_ASSERT(store.isOpen());
+        store.update("a", {true, true, ""});
+        FCITX_ASSERT(store.find("a"));
+    }
+
+    unlink(fname);
+    return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "fcitx-utils/fs.h"
+#include "fcitx-utils/log.h"
+#include "fcitx/restartstate_p.h"
+
+using namespace fcitx;
+
+int main() {
+    RestartStates states{{"group", "Default"},
+                         {"clipboard", std::string("a\0b", 3)},
+                         {"empty", ""}};
+    auto fd = writeRestartState(states);
+#ifdef MFD_CLOEXEC
+    FCITX_ASSERT(fd.isValid());
+    // Must be inherited by the new process.
+    FCITX_ASSERT((fcntl(fd.fd(), F_GETFD) & FD_CLOEXEC) == 0);
+    FCITX_ASSERT(readRestartState(fd.fd()) == states);
+    // Read again from the start.
+    FCITX_ASSERT(readRestartState(fd.fd()) == states);
+
+    // Truncated.
+    FCITX_ASSERT(ftruncate(fd.fd(), 40) == 0);
+    FCITX_ASSERT(readRestartState(fd.fd()).empty());
+
+    // Not a state file.
+    FCITX_ASSERT(ftruncate(fd.fd(), 0) == 0);
+    FCITX_ASSERT(fs::safeWrite(fd.fd(), "abcdefgh", 8) == 8);
+    FCITX_ASSERT(readRestartState(fd.fd()).empty());
+#else
+    FCITX_ASSERT(!fd.isValid());
+#endif
+    FCITX_ASSERT(readRestartState(-1).empty());
+    return 0;
+}
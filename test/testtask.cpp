@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026-2026 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include <unistd.h>
+#include <string>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/log.h"
+#include "fcitx-utils/task.h"
+
+using namespace fcitx;
+
+void testReady() {
+    std::string result;
+    auto task = Task<int>::ready(1)
+                    .then([](int value) { return value + 1; })
+                    .then([](int value) { return std::to_string(value); })
+                    .then([&result](std::string value) { result = value; });
+    FCITX_ASSERT(result == "2");
+    FCITX_ASSERT(task.isResolved());
+
+    bool called = false;
+    auto voidTask = Task<void>::ready().then([&called]() { called = true; });
+    FCITX_ASSERT(called);
+}
+
+void testPromise() {
+    Task<int> task;
+    auto promise = task.promise();
+    int result = 0;
+    auto chain = std::move(task).then([&result](int value) {
+        result = value;
+        return Task<std::string>::ready("done");
+    });
+    FCITX_ASSERT(!chain.isResolved());
+    promise.resolve(3);
+    FCITX_ASSERT(result == 3);
+    FCITX_ASSERT(chain.isResolved());
+    // Resolve only once.
+    promise.resolve(4);
+    FCITX_ASSERT(result == 3);
+}
+
+void testCancel() {
+    Task<int> task;
+    auto promise = task.promise();
+    bool called = false;
+    {
+        auto chain = std::move(task).then([&called](int) { called = true; });
+        FCITX_ASSERT(promise.isValid());
+    }
+    FCITX_ASSERT(!promise.isValid());
+    promise.resolve(1);
+    FCITX_ASSERT(!called);
+}
+
+void testEventLoop() {
+    EventLoop e;
+    int timeCount = 0;
+    auto task =
+        timeTask(e, CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 1000, 0)
+            .then([&e, &timeCount](uint64_t) {
+                ++timeCount;
+                return timeTask(e, CLOCK_MONOTONIC,
+                                now(CLOCK_MONOTONIC) + 1000, 0);
+            })
+            .then([&timeCount](uint64_t) { ++timeCount; });
+
+    // Dropped before the timer fires.
+    bool cancelled = true;
+    auto dropped = timeTask(e, CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 1000,
+                            0)
+                       .then([&cancelled](uint64_t) { cancelled = false; });
+    dropped = Task<void>();
+
+    int pipefd[2];
+    FCITX_ASSERT(pipe(pipefd) == 0);
+    IOEventFlags ioFlags;
+    auto io = ioTask(e, pipefd[0], IOEventFlag::In)
+                  .then([&ioFlags](IOEventFlags flags) { ioFlags = flags; });
+    auto writer = timeTask(e, CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 2000,
+                           0)
+                      .then([pipefd](uint64_t) {
+                          FCITX_ASSERT(write(pipefd[1], "a", 1) == 1);
+                      });
+
+    auto exitTask = timeTask(e, CLOCK_MONOTONIC,
+                             now(CLOCK_MONOTONIC) + 100000, 0)
+                        .then([&e](uint64_t) { e.exit(); });
+    FCITX_ASSERT(e.exec());
+    FCITX_ASSERT(timeCount == 2);
+    FCITX_ASSERT(task.isResolved());
+    FCITX_ASSERT(cancelled);
+    FCITX_ASSERT(ioFlags.test(IOEventFlag::In));
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+int main() {
+    testReady();
+    testPromise();
+    testCancel();
+    testEventLoop();
+    return 0;
+}
@@ -4,9 +4,55 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include <cstdlib>
+#include <new>
 #include <fcitx-utils/log.h>
 #include <fcitx/text.h>
 
+namespace {
+size_t allocations = 0;
+} // namespace
+
+void *operator new(size_t size) {
+    ++allocations;
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+void testCopyOnWrite() {
+    using namespace fcitx;
+    Text text;
+    text.append("A long string that does not fit in small buffer");
+    text.append("Another long string that does not fit in small buffer",
+                TextFormatFlag::HighLight);
+    text.setCursor(3);
+
+    auto before = allocations;
+    Text copy = text;
+    // Only the private object, segments are shared.
+    FCITX_ASSERT(allocations - before == 1) << allocations - before;
+    FCITX_ASSERT(&copy.stringAt(0) == &text.stringAt(0));
+    FCITX_ASSERT(copy.cursor() == 3);
+
+    copy.append("C");
+    FCITX_ASSERT(copy.size() == 3);
+    FCITX_ASSERT(text.size() == 2);
+    FCITX_ASSERT(&copy.stringAt(0) != &text.stringAt(0));
+    FCITX_ASSERT(copy.stringAt(1) == text.stringAt(1));
+
+    copy.clear();
+    FCITX_ASSERT(copy.empty());
+    FCITX_ASSERT(text.size() == 2);
+    copy.append("D");
+    FCITX_ASSERT(copy.toString() == "D");
+    FCITX_ASSERT(text.formatAt(1) == TextFormatFlag::HighLight);
+}
+
 int main() {
     using namespace fcitx;
     Text text("ABC");
@@ -34,5 +80,7 @@ int main() {
     FCITX_ASSERT(lines[3].toStringForCommit() == "Z");
     FCITX_ASSERT(lines[4].toStringForCommit() == "1");
 
+    testCopyOnWrite();
+
     return 0;
 }
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+
+#include <string>
+#include <vector>
+#include "fcitx-utils/log.h"
+#include "frontend/waylandim/textinputbatch.h"
+
+using namespace fcitx;
+
+class Client {
+public:
+    void send(const TextInputChanges &changes) {
+        std::string event = "commit:" + changes.commitString;
+        if (changes.deleteSurroundingText) {
+            event += ":delete";
+        }
+        if (changes.updatePreedit) {
+            event += ":preedit";
+        }
+        events_.push_back(std::move(event));
+    }
+
+    // Same as what input context does before a key is sent.
+    void key(TextInputBatch &batch, const std::string &key) {
+        batch.flush();
+        events_.push_back("key:" + key);
+    }
+
+    std::vector<std::string> events_;
+};
+
+void testImmediate() {
+    Client client;
+    TextInputBatch batch(
+        [&client](const TextInputChanges &changes) { client.send(changes); });
+    batch.commitString("a");
+    batch.updatePreedit();
+    FCITX_ASSERT((client.events_ ==
+                  std::vector<std::string>{"commit:a", "commit::preedit"}));
+}
+
+void testMerge() {
+    Client client;
+    TextInputBatch batch(
+        [&client](const TextInputChanges &changes) { client.send(changes); });
+    batch.begin();
+    batch.updatePreedit();
+    batch.commitString("a");
+    batch.begin();
+    batch.commitString("b");
+    FCITX_ASSERT(!batch.end());
+    batch.updatePreedit();
+    FCITX_ASSERT(client.events_.empty());
+    FCITX_ASSERT(batch.end());
+    FCITX_ASSERT(
+        (client.events_ == std::vector<std::string>{"commit:ab:preedit"}));
+    // Nothing is sent for an empty batch.
+    batch.begin();
+    FCITX_ASSERT(batch.end());
+    FCITX_ASSERT(client.events_.size() == 1);
+}
+
+void testCommitThenKey() {
+    Client client;
+    TextInputBatch batch(
+        [&client](const TextInputChanges &changes) { client.send(changes); });
+    // Keyboard engine commits the current word and lets Return through.
+    batch.begin();
+    batch.commitString("hello");
+    client.key(batch, "Return");
+    batch.updatePreedit();
+    FCITX_ASSERT(batch.end());
+    FCITX_ASSERT((client.events_ == std::vector<std::string>{
+                                        "commit:hello", "key:Return",
+                                        "commit::preedit"}));
+}
+
+void testDeleteSurroundingText() {
+    Client client;
+    TextInputBatch batch(
+        [&client](const TextInputChanges &changes) { client.send(changes); });
+    batch.begin();
+    batch.commitString("a");
+    // Deletion applies before the commit string on the client side, so the
+    // pending commit string goes first.
+    batch.prepareDeleteSurroundingText();
+    FCITX_ASSERT((client.events_ == std::vector<std::string>{"commit:a"}));
+    batch.deleteSurroundingText();
+    batch.commitString("b");
+    FCITX_ASSERT(batch.end());
+    FCITX_ASSERT((client.events_ ==
+                  std::vector<std::string>{"commit:a", "commit:b:delete"}));
+}
+
+int main() {
+    testImmediate();
+    testMerge();
+    testCommitThenKey();
+    testDeleteSurroundingText();
+    return 0;
+}
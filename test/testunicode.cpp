@@ -4,48 +4,198 @@
  * SPDX-License-Identifier: LGPL-2.1-or-later
  *
  */
+#include "fcitx-utils/event.h"
 #include "fcitx-utils/eventdispatcher.h"
+#include "fcitx-utils/stringutils.h"
 #include "fcitx-utils/testing.h"
 #include "fcitx/addonmanager.h"
+#include "fcitx/inputcontextmanager.h"
+#include "fcitx/inputpanel.h"
 #include "fcitx/inputmethodmanager.h"
 #include "fcitx/instance.h"
 #include "testdir.h"
 #include "testfrontend_public.h"
+#include "unicode_public.h"
 
 using namespace fcitx;
 
-void scheduleEvent(EventDispatcher *dispatcher, Instance *instance) {
-    dispatcher->schedule([instance]() {
+std::unique_ptr<EventSourceTime> timeoutEvent;
+
+// Search runs in worker thread, run the callback after the result of the last
+// query is set.
+class SearchWaiter {
+public:
+    SearchWaiter(EventDispatcher *dispatcher) : dispatcher_(dispatcher) {}
+
+    void attach(AddonInstance *unicode) {
+        handler_ = unicode->call<IUnicode::addSearchFinishedCallback>(
+            [this](InputContext *) {
+                ++finished_;
+                if (!callback_) {
+                    return;
+                }
+                // Don't run it within the callback of unicode.
+                dispatcher_->schedule(std::move(callback_));
+                callback_ = nullptr;
+            });
+    }
+
+    void wait(std::function<void()> callback) {
+        callback_ = std::move(callback);
+    }
+
+    int finished() const { return finished_; }
+
+private:
+    EventDispatcher *dispatcher_;
+    std::function<void()> callback_;
+    int finished_ = 0;
+    std::unique_ptr<HandlerTableEntry<UnicodeSearchFinishedCallback>> handler_;
+};
+
+struct TestContext {
+    Instance *instance;
+    EventDispatcher *dispatcher;
+    SearchWaiter *waiter;
+    AddonInstance *testfrontend;
+    ICUUID uuid;
+
+    InputContext *ic() const {
+        auto *ic = instance->inputContextManager().findByUUID(uuid);
+        FCITX_ASSERT(ic);
+        return ic;
+    }
+
+    void key(const Key &key) const {
+        testfrontend->call<ITestFrontend::keyEvent>(uuid, key, false);
+    }
+
+    void type(const std::string &text) const {
+        for (auto c : text) {
+            key(Key(std::string(1, c)));
+        }
+    }
+};
+
+void finish(const TestContext &context) {
+    context.dispatcher->schedule([context]() {
+        context.dispatcher->detach();
+        context.instance->exit();
+    });
+}
+
+void testCancel(const TestContext &context) {
+    context.key(Key("Control+Alt+Shift+u"));
+    context.type("letter");
+    // Reset drops the running search.
+    context.key(Key(FcitxKey_Escape));
+    FCITX_ASSERT(!context.ic()->inputPanel().candidateList());
+
+    // Result of a cancelled search should never be set, give it plenty of
+    // time to come back.
+    const auto finished = context.waiter->finished();
+    timeoutEvent = context.instance->eventLoop().addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 500000, 0,
+        [context, finished](EventSourceTime *, uint64_t) {
+            FCITX_ASSERT(context.waiter->finished() == finished);
+            FCITX_ASSERT(!context.ic()->inputPanel().candidateList());
+            finish(context);
+            return true;
+        });
+}
+
+void testLazyPaging(const TestContext &context) {
+    context.key(Key("Control+Alt+Shift+u"));
+    // Matches hundreds of characters.
+    context.type("latin");
+    context.waiter->wait([context]() {
+        auto candidateList = context.ic()->inputPanel().candidateList();
+        FCITX_ASSERT(candidateList);
+        auto pageSize = context.instance->globalConfig().defaultPageSize();
+        // Only the current page and the one after it are created.
+        FCITX_ASSERT(candidateList->toBulk()->totalSize() == pageSize * 2)
+            << candidateList->toBulk()->totalSize();
+        FCITX_ASSERT(candidateList->toPageable()->hasNext());
+
+        context.key(Key("Down"));
+        candidateList = context.ic()->inputPanel().candidateList();
+        FCITX_ASSERT(candidateList->toPageable()->currentPage() == 1);
+        FCITX_ASSERT(candidateList->toBulk()->totalSize() == pageSize * 3)
+            << candidateList->toBulk()->totalSize();
+
+        context.key(Key(FcitxKey_Escape));
+        testCancel(context);
+    });
+}
+
+void testRefine(const TestContext &context) {
+    context.key(Key("Control+Alt+Shift+u"));
+    context.type("latin small letter a");
+    context.waiter->wait([context]() {
+        auto expect =
+            context.ic()->inputPanel().candidateList()->candidate(0).text();
+        context.key(Key(FcitxKey_Escape));
+
+        context.key(Key("Control+Alt+Shift+u"));
+        context.type("latin");
+        context.waiter->wait([context, expect]() {
+            // Narrow down the result of "latin".
+            context.type(" small letter a");
+            context.waiter->wait([context, expect]() {
+                auto candidateList =
+                    context.ic()->inputPanel().candidateList();
+                FCITX_ASSERT(candidateList->candidate(0).text().toString() ==
+                             expect.toString());
+                context.key(Key(FcitxKey_Escape));
+                testLazyPaging(context);
+            });
+        });
+    });
+}
+
+void testPendingSelection(const TestContext &context) {
+    context.testfrontend->call<ITestFrontend::pushCommitExpectation>("🍏");
+    context.key(Key("Control+Alt+Shift+u"));
+    context.type("apple green");
+    // Selected before the search finishes.
+    context.key(Key("Alt+1"));
+    context.waiter->wait([context]() {
+        FCITX_ASSERT(!context.ic()->inputPanel().candidateList());
+        testRefine(context);
+    });
+}
+
+void testSearch(const TestContext &context) {
+    context.testfrontend->call<ITestFrontend::pushCommitExpectation>("🍏");
+    context.key(Key("Control+Alt+Shift+u"));
+    context.type("ap");
+    context.key(Key(FcitxKey_BackSpace));
+    context.type("pple green");
+
+    // Only the result of the last query is shown.
+    context.waiter->wait([context]() {
+        auto candidateList = context.ic()->inputPanel().candidateList();
+        FCITX_ASSERT(candidateList);
+        FCITX_ASSERT(candidateList->size() > 0);
+        FCITX_ASSERT(stringutils::startsWith(
+            candidateList->candidate(0).text().toString(), "🍏"));
+        context.key(Key("Alt+1"));
+        testPendingSelection(context);
+    });
+}
+
+void scheduleEvent(EventDispatcher *dispatcher, Instance *instance,
+                   SearchWaiter *waiter) {
+    dispatcher->schedule([instance, waiter]() {
         auto *unicode = instance->addonManager().addon("unicode", true);
         FCITX_ASSERT(unicode);
+        waiter->attach(unicode);
     });
-    dispatcher->schedule([dispatcher, instance]() {
+    dispatcher->schedule([dispatcher, instance, waiter]() {
         auto *testfrontend = instance->addonManager().addon("testfrontend");
-        testfrontend->call<ITestFrontend::pushCommitExpectation>("🍏");
         auto uuid =
             testfrontend->call<ITestFrontend::createInputContext>("testapp");
-        testfrontend->call<ITestFrontend::keyEvent>(
-            uuid, Key("Control+Alt+Shift+u"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("a"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("p"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(
-            uuid, Key(FcitxKey_BackSpace), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("p"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("p"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("l"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("e"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key(" "), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("g"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("r"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("e"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("e"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("n"), false);
-        testfrontend->call<ITestFrontend::keyEvent>(uuid, Key("Alt+1"), false);
-
-        dispatcher->schedule([dispatcher, instance]() {
-            dispatcher->detach();
-            instance->exit();
-        });
+        testSearch({instance, dispatcher, waiter, testfrontend, uuid});
     });
 }
 
@@ -64,7 +214,8 @@ int main() {
     instance.addonManager().registerDefaultLoader(nullptr);
     EventDispatcher dispatcher;
     dispatcher.attach(&instance.eventLoop());
-    scheduleEvent(&dispatcher, &instance);
+    SearchWaiter waiter(&dispatcher);
+    scheduleEvent(&dispatcher, &instance, &waiter);
     instance.exec();
     return 0;
 }
@@ -0,0 +1,156 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2021 CSSlayer <wengxt@gmail.com>
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ */
+#include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fcitx-utils/event.h"
+#include "fcitx-utils/log.h"
+#include "fcitx/workerpool.h"
+
+using namespace fcitx;
+
+void testResult() {
+    EventLoop loop;
+    WorkerPool pool(&loop);
+    auto mainThread = std::this_thread::get_id();
+    std::string result;
+    auto job = pool.submit(
+        WorkerJobPriority::Interactive,
+        [mainThread](const WorkerJobToken &) {
+            FCITX_ASSERT(std::this_thread::get_id() != mainThread);
+            return std::string("ABC");
+        },
+        [&result, &loop, mainThread](std::string value) {
+            FCITX_ASSERT(std::this_thread::get_id() == mainThread);
+            result = std::move(value);
+            loop.exit();
+        });
+    loop.exec();
+    FCITX_ASSERT(result == "ABC");
+    FCITX_ASSERT(job->isFinished());
+}
+
+void testCancel() {
+    EventLoop loop;
+    WorkerPool pool(&loop);
+    std::atomic<bool> started = false;
+    std::atomic<bool> stopped = false;
+    bool called = false;
+    auto job = pool.submit(
+        WorkerJobPriority::Background,
+        [&started, &stopped](const WorkerJobToken &token) {
+            started = true;
+            while (!token.isCancelled()) {
+                usleep(1000);
+            }
+            stopped = true;
+        },
+        [&called]() { called = true; });
+    while (!started) {
+        usleep(1000);
+    }
+    // Wait for the job function to return.
+    job.reset();
+    FCITX_ASSERT(stopped);
+
+    auto exitEvent = loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 100000, 0,
+        [&loop](EventSourceTime *, uint64_t) {
+            loop.exit();
+            return true;
+        });
+    loop.exec();
+    FCITX_ASSERT(!called);
+}
+
+void testDetach() {
+    EventLoop loop;
+    WorkerPool pool(&loop);
+    auto started = std::make_shared<std::atomic<bool>>(false);
+    auto blocked = std::make_shared<std::atomic<bool>>(true);
+    auto stopped = std::make_shared<std::atomic<bool>>(false);
+    bool called = false;
+    auto job = pool.submit(
+        WorkerJobPriority::Interactive,
+        [started, blocked, stopped](const WorkerJobToken &token) {
+            started->store(true);
+            while (*blocked) {
+                usleep(1000);
+            }
+            FCITX_ASSERT(token.isCancelled());
+            stopped->store(true);
+        },
+        [&called]() { called = true; });
+    while (!*started) {
+        usleep(1000);
+    }
+    job->detach();
+    // Would never return if it waited for the job function.
+    job.reset();
+    FCITX_ASSERT(!*stopped);
+    blocked->store(false);
+    while (!*stopped) {
+        usleep(1000);
+    }
+
+    auto exitEvent = loop.addTimeEvent(
+        CLOCK_MONOTONIC, now(CLOCK_MONOTONIC) + 100000, 0,
+        [&loop](EventSourceTime *, uint64_t) {
+            loop.exit();
+            return true;
+        });
+    loop.exec();
+    FCITX_ASSERT(!called);
+}
+
+void testPriority() {
+    EventLoop loop;
+    WorkerPool pool(&loop);
+    pool.setMaxThreads(1);
+    FCITX_ASSERT(pool.maxThreads() == 1);
+
+    std::atomic<bool> started = false;
+    std::atomic<bool> blocked = true;
+    std::vector<int> order;
+    auto blocker = pool.submit(WorkerJobPriority::Interactive,
+                               [&started, &blocked](const WorkerJobToken &) {
+                                   started = true;
+                                   while (blocked) {
+                                       usleep(1000);
+                                   }
+                               });
+    while (!started) {
+        usleep(1000);
+    }
+    // Run in worker one by one, so push_back is safe.
+    auto background = pool.submit(
+        WorkerJobPriority::Background,
+        [&order](const WorkerJobToken &) { order.push_back(1); },
+        [&loop]() { loop.exit(); });
+    auto interactive = pool.submit(
+        WorkerJobPriority::Interactive,
+        [&order](const WorkerJobToken &) { order.push_back(0); });
+    blocked = false;
+    loop.exec();
+    FCITX_ASSERT(order == std::vector<int>({0, 1})) << order;
+
+    auto reserved = pool.reserveThreads(3);
+    FCITX_ASSERT(pool.maxThreads() == 3);
+    reserved.reset();
+    FCITX_ASSERT(pool.maxThreads() == 1);
+}
+
+int main() {
+    testResult();
+    testCancel();
+    testDetach();
+    testPriority();
+    return 0;
+}